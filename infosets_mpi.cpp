@@ -1,3 +1,27 @@
+/*
+Infoset discovery by random playouts, spread over MPI ranks.
+
+Every rank plays its share of the scenarios with its own RNG and keeps the
+first row of each infoset it meets (keyed by round, abstraction and
+actions). The rows are then deduplicated globally: each key belongs to rank
+fnv1a64(key) % ranks, rows travel to their owners in one MPI_Alltoallv, and
+owners keep the ones that are neither in the output file already nor sent
+by a lower rank. Keys of an existing output file are streamed out to their
+owners by rank 0 in batches. Rank 0 appends the new rows to the single
+output file, one rank's rows at a time, so no rank holds more than its
+share of the infosets.
+
+--exhaustive prints the exact infoset counts of the public tree instead
+(spingo/infoset_census.cpp); it runs on rank 0 only.
+
+Build: mpicxx -std=c++17 -O2 infosets_mpi.cpp -o infosets_mpi
+Run:   mpirun -np 4 ./infosets_mpi 100000 poker_infosets.csv
+       ./infosets_mpi --exhaustive
+*/
+
+#include <mpi.h>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -12,6 +36,11 @@
 
 // Add this line to include the implementation
 #include "spingo/spingo.cpp"
+#include "spingo/checkpoint.cpp"
+#include "spingo/infoset_census.cpp"
+
+int mpiRank = 0;
+int mpiSize = 1;
 
 
 // Add these global variables to cache cluster data
@@ -371,54 +400,124 @@ std::string findCluster(const std::string& round, const std::string& rankPattern
     return "Cluster not found - Rank: " + rankPattern + ", Suit: " + suitPattern;
 }
 
-// Generate scenarios and track infosets
-void generateScenarios(int maxSamples, const std::string& outputFile) {
-    // Preload all clusters at the start
+// Number of clusters of a postflop round in the loaded cluster files
+int clusterBucketCount(const std::string& round) {
+    int count = 1;
+    auto it = clusterCache.find(round);
+    if (it != clusterCache.end()) {
+        for (const auto& entry : it->second) count = std::max(count, std::atoi(entry.second.c_str()) + 1);
+    }
+    return count;
+}
+
+// Exact infoset counts per round and position from the whole public tree,
+// instead of the infosets random playouts happen to reach
+void countInfosets() {
     preloadClusters();
-    
-    // Declare infosetCounts as a local variable
-    std::unordered_map<std::string, int> infosetCounts;
+    std::array<int, 4> bucketCounts = {{NUM_PREFLOP_CLASSES, clusterBucketCount("flop"), clusterBucketCount("turn"),
+                                        clusterBucketCount("river")}};
+    InfosetEnumerator(bucketCounts).run().print(std::cout);
+}
 
-    // Load existing infosets from the CSV file
-    std::ifstream existingFile(outputFile);
-    if (existingFile.is_open()) {
-        std::string line;
-        // Skip header line
-        std::getline(existingFile, line);
-        while (std::getline(existingFile, line)) {
-            // Assuming the format is: Round,Player,Abstraction,PreviousActions,CumulatedPot
-            std::istringstream iss(line);
-            std::string round, player, abstraction, previousActions;
-            double cumulatedPot;
-            std::getline(iss, round, ',');
-            std::getline(iss, player, ',');
-            std::getline(iss, abstraction, ',');
-            std::getline(iss, previousActions, ',');
-            iss >> cumulatedPot;
+// Key a row is deduplicated by, as generateScenarios builds it
+std::string rowKey(const std::string& line) {
+    std::istringstream iss(line);
+    std::string round, player, abstraction, previousActions;
+    std::getline(iss, round, ',');
+    std::getline(iss, player, ',');
+    std::getline(iss, abstraction, ',');
+    std::getline(iss, previousActions, ',');
+    return round + "|" + abstraction + "|" + previousActions;
+}
 
-            // Create a unique key for this infoset
-            std::string infosetKey = round + "|" + abstraction + "|" + previousActions;
-            infosetCounts[infosetKey]++;
+int ownerOf(const std::string& key) {
+    return static_cast<int>(fnv1a64(key) % static_cast<uint64_t>(mpiSize));
+}
+
+void appendRecord(std::string& buffer, const std::string& data) {
+    uint32_t length = static_cast<uint32_t>(data.size());
+    buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    buffer.append(data);
+}
+
+std::string readRecord(const char*& p) {
+    uint32_t length;
+    std::memcpy(&length, p, sizeof(length));
+    p += sizeof(length);
+    std::string data(p, length);
+    p += length;
+    return data;
+}
+
+// Sends one buffer to every rank and returns what every rank sent to this
+// one, concatenated in rank order.
+bool allToAll(const std::vector<std::string>& outgoing, std::string& incoming) {
+    std::vector<int> sendCounts(mpiSize), recvCounts(mpiSize), sendOffsets(mpiSize), recvOffsets(mpiSize);
+    long total = 0;
+    for (int r = 0; r < mpiSize; r++) {
+        if (total + static_cast<long>(outgoing[r].size()) > INT_MAX) {
+            std::cerr << "Rank " << mpiRank << ": exchange buffer over 2 GB; use more ranks" << std::endl;
+            return false;
         }
-        existingFile.close();
+        sendCounts[r] = static_cast<int>(outgoing[r].size());
+        sendOffsets[r] = static_cast<int>(total);
+        total += sendCounts[r];
     }
-    
-    SpinGoGame game;
-    std::mt19937 rng(std::random_device{}());
-    std::ofstream outFile(outputFile, std::ios::out | std::ios::app);
-    
-    if (!outFile.is_open()) {
-        std::cerr << "Error: Could not open output file " << outputFile << std::endl;
-        return;
+    std::string sendBuffer;
+    sendBuffer.reserve(total);
+    for (const auto& part : outgoing) sendBuffer.append(part);
+
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    long received = 0;
+    for (int r = 0; r < mpiSize; r++) {
+        if (received + recvCounts[r] > INT_MAX) {
+            std::cerr << "Rank " << mpiRank << ": incoming exchange over 2 GB; use more ranks" << std::endl;
+            return false;
+        }
+        recvOffsets[r] = static_cast<int>(received);
+        received += recvCounts[r];
     }
-    
-    // Write header with added CumulatedPot column if the file is empty
-    if (outFile.tellp() == 0) {
-        outFile << "Round,Player,Abstraction,PreviousActions,CumulatedPot\n";
+    incoming.assign(received, '\0');
+    MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendOffsets.data(), MPI_CHAR,
+                  &incoming[0], recvCounts.data(), recvOffsets.data(), MPI_CHAR, MPI_COMM_WORLD);
+    return true;
+}
+
+// Rank 0 streams an existing output file and deals its keys out to their
+// owners in batches, so every rank holds only the keys it owns.
+bool loadExistingKeys(const std::string& outputFile, std::unordered_set<std::string>& existing) {
+    const size_t BATCH_LINES = 1 << 20;
+    std::ifstream file;
+    if (mpiRank == 0) {
+        file.open(outputFile);
+        std::string header;
+        if (file.is_open()) std::getline(file, header);
     }
-    
-    // Track unique infosets and total count
-    int totalInfosets = 0;
+    while (true) {
+        std::vector<std::string> outgoing(mpiSize);
+        int more = 0;
+        if (mpiRank == 0 && file.is_open()) {
+            std::string line;
+            for (size_t n = 0; n < BATCH_LINES && std::getline(file, line); n++) {
+                if (line.empty()) continue;
+                std::string key = rowKey(line);
+                appendRecord(outgoing[ownerOf(key)], key);
+                more = 1;
+            }
+        }
+        MPI_Bcast(&more, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (!more) return true;
+        std::string incoming;
+        if (!allToAll(outgoing, incoming)) return false;
+        for (const char* p = incoming.data(); p < incoming.data() + incoming.size();) existing.insert(readRecord(p));
+    }
+}
+
+// Samples this rank's share of the scenarios, keeping the first row of every
+// infoset it meets (keyed by rowKey).
+void sampleScenarios(int maxSamples, std::mt19937& rng, std::unordered_map<std::string, std::string>& rows,
+                     long& totalInfosets) {
+    SpinGoGame game;
     
     // Track progress with timing
     auto startTime = std::chrono::high_resolution_clock::now();
@@ -528,17 +627,17 @@ void generateScenarios(int maxSamples, const std::string& outputFile) {
             std::string infosetKey = state.round + "|" + abstraction + "|" + prevActionsStr;
             
             // Track all infosets, not just unique ones
-            infosetCounts[infosetKey]++;
             totalInfosets++;
             
-            // Only write to file if we haven't seen this infoset before
-            if (infosetCounts[infosetKey] == 1) {
-                // Write infoset to file with pot size
-                outFile << state.round << ","
-                       << currentPlayer << ","
-                       << abstraction << ","
-                       << prevActionsStr << ","
-                       << totalPot << "\n";
+            // Keep the row of the first sighting of this infoset
+            if (rows.find(infosetKey) == rows.end()) {
+                std::ostringstream row;
+                row << state.round << ","
+                    << currentPlayer << ","
+                    << abstraction << ","
+                    << prevActionsStr << ","
+                    << totalPot << "\n";
+                rows.emplace(infosetKey, row.str());
             }
             
             // Choose a random action
@@ -563,7 +662,7 @@ void generateScenarios(int maxSamples, const std::string& outputFile) {
         }
         
         // Progress indicator with timing information
-        if (sample % 10 == 0 || sample == maxSamples - 1) {
+        if (mpiRank == 0 && (sample % 10 == 0 || sample == maxSamples - 1)) {
             auto currentTime = std::chrono::high_resolution_clock::now();
             auto elapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(
                 currentTime - startTime).count();
@@ -600,7 +699,7 @@ void generateScenarios(int maxSamples, const std::string& outputFile) {
                 std::cout << "\r" << std::string(80, ' ') << "\r"; // Clear line
                 std::cout << "Progress: " << std::fixed << std::setprecision(1) << progressPercent << "% | "
                           << "Completed " << sample + 1 << "/" << maxSamples 
-                          << " | Unique infosets: " << infosetCounts.size()
+                          << " | Unique infosets on rank 0: " << rows.size()
                           << " | Speed: " << std::fixed << std::setprecision(1) << samplesPerSecond 
                           << " samples/sec | ETA: " << etaString << std::flush;
                 
@@ -609,21 +708,125 @@ void generateScenarios(int maxSamples, const std::string& outputFile) {
             }
         }
     }
+    if (mpiRank == 0) std::cout << std::endl;
+}
+
+// Generate scenarios and track infosets. Every rank samples its share and
+// dedupes locally; rows then go to the rank their key hashes to, which drops
+// the ones already in the output file or sent by another rank, and rank 0
+// appends each rank's new rows in turn.
+bool generateScenarios(int maxSamples, const std::string& outputFile) {
+    // Preload all clusters at the start
+    preloadClusters();
     
-    // Calculate and print duplicate statistics
-    int duplicates = totalInfosets - infosetCounts.size();
-    double duplicatePercentage = (static_cast<double>(duplicates) / totalInfosets) * 100.0;
-    
-    std::cout << "\nGenerated " << infosetCounts.size() << " unique infosets from " 
-              << maxSamples << " scenarios to " << outputFile << std::endl;
-    std::cout << "Total infosets encountered: " << totalInfosets << std::endl;
-    std::cout << "Number of duplicates: " << duplicates << " (" 
-              << std::fixed << std::setprecision(5) << duplicatePercentage << "%)" << std::endl;
+    int share = maxSamples / mpiSize + (mpiRank < maxSamples % mpiSize ? 1 : 0);
+    std::mt19937 rng(std::random_device{}() ^ (0x9E3779B9u * static_cast<unsigned>(mpiRank + 1)));
+    std::unordered_map<std::string, std::string> rows;
+    long totalInfosets = 0;
+    sampleScenarios(share, rng, rows, totalInfosets);
+    
+    std::unordered_set<std::string> existing;
+    if (!loadExistingKeys(outputFile, existing)) return false;
+    
+    // Keyed as the rows read back from the file are, which differs from
+    // the sampling key when an abstraction contains a comma
+    std::vector<std::string> outgoing(mpiSize);
+    for (const auto& entry : rows) {
+        std::string key = rowKey(entry.second);
+        std::string& buffer = outgoing[ownerOf(key)];
+        appendRecord(buffer, key);
+        appendRecord(buffer, entry.second);
+    }
+    long locallyUnique = static_cast<long>(rows.size());
+    rows.clear();
+    std::string incoming;
+    if (!allToAll(outgoing, incoming)) return false;
+    outgoing.clear();
+    
+    // Owned rows new to the file, first sender (lowest rank) wins
+    std::string fresh;
+    long freshCount = 0;
+    for (const char* p = incoming.data(); p < incoming.data() + incoming.size();) {
+        std::string key = readRecord(p);
+        std::string line = readRecord(p);
+        if (existing.insert(key).second) {
+            fresh += line;
+            freshCount++;
+        }
+    }
+    incoming.clear();
+    
+    long counts[3] = {totalInfosets, locallyUnique, freshCount};
+    long totals[3] = {0, 0, 0};
+    MPI_Reduce(counts, totals, 3, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    long unique = static_cast<long>(existing.size()), totalUnique = 0;
+    MPI_Reduce(&unique, &totalUnique, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    
+    // Rank 0 appends its own rows and then every other rank's, one at a time
+    int ok = 1;
+    if (mpiRank == 0) {
+        std::ofstream outFile(outputFile, std::ios::out | std::ios::app);
+        if (!outFile.is_open()) {
+            std::cerr << "Error: Could not open output file " << outputFile << std::endl;
+            ok = 0;
+        } else if (outFile.tellp() == 0) {
+            // Write header with added CumulatedPot column if the file is empty
+            outFile << "Round,Player,Abstraction,PreviousActions,CumulatedPot\n";
+        }
+        for (int r = 0; r < mpiSize; r++) {
+            std::string part;
+            if (r == 0) {
+                part.swap(fresh);
+            } else {
+                MPI_Status status;
+                MPI_Probe(r, 0, MPI_COMM_WORLD, &status);
+                int length = 0;
+                MPI_Get_count(&status, MPI_CHAR, &length);
+                part.resize(length);
+                MPI_Recv(&part[0], length, MPI_CHAR, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            }
+            if (ok) outFile.write(part.data(), part.size());
+        }
+        outFile.close();
+        if (ok && !outFile) {
+            std::cerr << "Error writing output file " << outputFile << std::endl;
+            ok = 0;
+        }
+    } else {
+        if (fresh.size() > static_cast<size_t>(INT_MAX)) {
+            std::cerr << "Rank " << mpiRank << ": over 2 GB of new rows; use more ranks" << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_Send(fresh.data(), static_cast<int>(fresh.size()), MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
     
-    outFile.close();
+    if (mpiRank == 0 && ok) {
+        // Calculate and print duplicate statistics
+        long duplicates = totals[0] - totals[2];
+        double duplicatePercentage = totals[0] > 0 ? (static_cast<double>(duplicates) / totals[0]) * 100.0 : 0.0;
+        
+        std::cout << "Generated " << totals[2] << " new unique infosets from " << maxSamples << " scenarios on "
+                  << mpiSize << " ranks to " << outputFile << " (" << totalUnique << " in the file)" << std::endl;
+        std::cout << "Total infosets encountered: " << totals[0] << " (" << totals[1]
+                  << " unique within their rank)" << std::endl;
+        std::cout << "Number of duplicates: " << duplicates << " ("
+                  << std::fixed << std::setprecision(5) << duplicatePercentage << "%)" << std::endl;
+    }
+    return ok != 0;
 }
 
 int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+    
+    if (argc > 1 && std::string(argv[1]) == "--exhaustive") {
+        if (mpiRank == 0) countInfosets();
+        MPI_Finalize();
+        return 0;
+    }
+    
     // Default number of samples
     int numSamples = 10;
     // Default output file name
@@ -634,7 +837,7 @@ int main(int argc, char* argv[]) {
         try {
             numSamples = std::stoi(argv[1]);
         } catch (const std::exception& e) {
-            std::cerr << "Error parsing number of samples. Using default: " << numSamples << std::endl;
+            if (mpiRank == 0) std::cerr << "Error parsing number of samples. Using default: " << numSamples << std::endl;
         }
     }
     
@@ -644,7 +847,8 @@ int main(int argc, char* argv[]) {
     }
     
     // Generate scenarios and track infosets
-    generateScenarios(numSamples, outputFile);
+    bool ok = generateScenarios(numSamples, outputFile);
     
-    return 0;
-}
\ No newline at end of file
+    MPI_Finalize();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*
+Expected payoffs for hands that ended all-in before the river.
+
+With SpinGoState::defer_allin_runout set, apply_action() stops at the all-in
+instead of dealing the rest of the board, and runout_pending() reports it.
+allInExpectedReturns() then gives the expectation of returns() over every
+possible runout instead of one sampled one:
+
+- flop/turn: all remaining boards from the state's deck are enumerated and
+  scored with fastHandScore().
+- preflop: pot shares come from the specific-hand table generated by
+  utils/preflop_allin_equity (./utils/preflop_allin_equity.bin, or the path in
+  SPINGO_PREFLOP_EQUITY) when it is present. Otherwise, and for matchups the
+  file lacks, they come from a table keyed by the 169-class of each player
+  still in the hand (2-way and 3-way). Its entries are filled on first use by
+  a seeded Monte Carlo over concrete hands of those classes that do not share
+  cards, so the table is deterministic and thread-safe to share. Lookups of
+  filled entries only take a shared lock, and each entry is simulated once:
+  threads that miss the same matchup wait for the first one.
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_ALLIN_EQUITY_CPP
+#define SPINGO_ALLIN_EQUITY_CPP
+
+#include "fast_eval.cpp"
+#include "preflop_equity_file.cpp"
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+static const int PREFLOP_EQUITY_SAMPLES = 3000;
+static const char* const PREFLOP_EQUITY_DEFAULT_PATH = "./utils/preflop_allin_equity.bin";
+
+// Adds each player's share of one runout: the best score takes the pot, ties split it.
+inline void addShowdownShares(const int* scores, int numPlayers, double weight, double* shares) {
+    int best = scores[0];
+    for (int i = 1; i < numPlayers; i++) best = std::max(best, scores[i]);
+    int winners = 0;
+    for (int i = 0; i < numPlayers; i++) {
+        if (scores[i] == best) winners++;
+    }
+    for (int i = 0; i < numPlayers; i++) {
+        if (scores[i] == best) shares[i] += weight / winners;
+    }
+}
+
+// Exact pot shares over every completion of the board from the remaining deck.
+// holeCards holds two cards per player.
+inline std::vector<double> enumerateRunoutShares(const std::vector<int>& holeCards, const std::vector<int>& board,
+                                                 const std::vector<int>& deck) {
+    int numPlayers = static_cast<int>(holeCards.size() / 2);
+    std::vector<double> shares(numPlayers, 0.0);
+    int missing = 5 - static_cast<int>(board.size());
+    int deckSize = static_cast<int>(deck.size());
+
+    int fullBoard[5];
+    for (size_t i = 0; i < board.size(); i++) fullBoard[i] = board[i];
+    int scores[NUM_PLAYERS];
+    long long runouts = 0;
+
+    auto scoreRunout = [&]() {
+        for (int p = 0; p < numPlayers; p++) {
+            scores[p] = fastHandScore(holeCards[p * 2], holeCards[p * 2 + 1], fullBoard, 5);
+        }
+        addShowdownShares(scores, numPlayers, 1.0, shares.data());
+        runouts++;
+    };
+
+    if (missing == 1) {
+        for (int a = 0; a < deckSize; a++) {
+            fullBoard[4] = deck[a];
+            scoreRunout();
+        }
+    } else if (missing == 2) {
+        for (int a = 0; a < deckSize; a++) {
+            fullBoard[3] = deck[a];
+            for (int b = a + 1; b < deckSize; b++) {
+                fullBoard[4] = deck[b];
+                scoreRunout();
+            }
+        }
+    } else if (missing == 0) {
+        scoreRunout();
+    }
+
+    for (double& s : shares) s = runouts > 0 ? s / runouts : 0.0;
+    return shares;
+}
+
+// Lazily filled preflop all-in pot shares by 169-class.
+class PreflopEquityTable {
+public:
+    PreflopEquityTable() {
+        for (int c1 = 0; c1 < 52; c1++) {
+            for (int c2 = c1 + 1; c2 < 52; c2++) {
+                classCombos[preflopClassIndex(c1, c2)].push_back({c1, c2});
+            }
+        }
+    }
+
+    // Pot shares for numPlayers (2 or 3) players holding the given classes.
+    std::array<double, 3> shares(const int* classes, int numPlayers) {
+        // Classes are sorted so permutations of the same matchup share an entry
+        int order[3] = {0, 1, 2};
+        sortIndicesByKey(order, numPlayers, classes);
+        int sorted[3] = {0, 0, 0};
+        for (int i = 0; i < numPlayers; i++) sorted[i] = classes[order[i]];
+
+        uint32_t key = (static_cast<uint32_t>(numPlayers) << 24) | (sorted[0] << 16) | (sorted[1] << 8) | sorted[2];
+        Entry* entry = nullptr;
+        {
+            std::shared_lock<std::shared_mutex> lock(tableMutex);
+            auto it = table.find(key);
+            if (it != table.end()) entry = it->second.get();
+        }
+        if (!entry) {
+            std::unique_lock<std::shared_mutex> lock(tableMutex);
+            std::unique_ptr<Entry>& slot = table[key];
+            if (!slot) slot.reset(new Entry());
+            entry = slot.get();
+        }
+        // Entries never move or go away, so the simulation runs unlocked
+        std::call_once(entry->filled, [&]() { entry->shares = simulate(sorted, numPlayers, key); });
+
+        std::array<double, 3> result = {0.0, 0.0, 0.0};
+        for (int i = 0; i < numPlayers; i++) result[order[i]] = entry->shares[i];
+        return result;
+    }
+
+    size_t size() {
+        std::shared_lock<std::shared_mutex> lock(tableMutex);
+        return table.size();
+    }
+
+private:
+    struct Entry {
+        std::once_flag filled;
+        std::array<float, 3> shares = {{0.0f, 0.0f, 0.0f}};
+    };
+
+    std::vector<std::pair<int, int>> classCombos[169];
+    std::unordered_map<uint32_t, std::unique_ptr<Entry>> table;
+    std::shared_mutex tableMutex;
+
+    std::array<float, 3> simulate(const int* classes, int numPlayers, uint32_t seed) const {
+        std::mt19937 rng(seed);
+        double shares[3] = {0.0, 0.0, 0.0};
+        int hole[6];
+        int board[5];
+        int scores[3];
+        int samples = 0;
+
+        for (int s = 0; s < PREFLOP_EQUITY_SAMPLES; s++) {
+            uint64_t used = 0;
+            bool dealt = true;
+            for (int p = 0; p < numPlayers && dealt; p++) {
+                const auto& combos = classCombos[classes[p]];
+                std::uniform_int_distribution<int> pick(0, static_cast<int>(combos.size()) - 1);
+                dealt = false;
+                for (int attempt = 0; attempt < 32; attempt++) {
+                    const auto& combo = combos[pick(rng)];
+                    uint64_t mask = (1ULL << combo.first) | (1ULL << combo.second);
+                    if (used & mask) continue;
+                    used |= mask;
+                    hole[p * 2] = combo.first;
+                    hole[p * 2 + 1] = combo.second;
+                    dealt = true;
+                    break;
+                }
+            }
+            if (!dealt) continue;  // e.g. three players holding the same pair class
+
+            std::uniform_int_distribution<int> card(0, 51);
+            for (int i = 0; i < 5; i++) {
+                int c;
+                do { c = card(rng); } while (used & (1ULL << c));
+                used |= 1ULL << c;
+                board[i] = c;
+            }
+            for (int p = 0; p < numPlayers; p++) {
+                scores[p] = fastHandScore(hole[p * 2], hole[p * 2 + 1], board, 5);
+            }
+            addShowdownShares(scores, numPlayers, 1.0, shares);
+            samples++;
+        }
+
+        std::array<float, 3> entry = {0.0f, 0.0f, 0.0f};
+        for (int p = 0; p < numPlayers && samples > 0; p++) {
+            entry[p] = static_cast<float>(shares[p] / samples);
+        }
+        return entry;
+    }
+};
+
+inline PreflopEquityTable& preflopEquityTable() {
+    static PreflopEquityTable table;
+    return table;
+}
+
+// Table written by utils/preflop_allin_equity, mapped on first use if present.
+inline const PreflopEquityFile& preflopEquityFile() {
+    static PreflopEquityFile file;
+    static std::once_flag opened;
+    std::call_once(opened, []() {
+        const char* path = std::getenv("SPINGO_PREFLOP_EQUITY");
+        if (file.open(path ? path : PREFLOP_EQUITY_DEFAULT_PATH)) {
+            std::cout << "Loaded preflop all-in equity table (" << file.count2() << " 2-way, "
+                      << file.count3() << " 3-way matchups)" << std::endl;
+        }
+    });
+    return file;
+}
+
+inline int cardIndex(const Card& card) {
+    return cardIndexFromStrings(card.rank, card.suit);
+}
+
+// Expected share of the total pot for every player of a state with a pending
+// runout (folded players get 0).
+inline std::vector<double> allInPotShares(const SpinGoState& state) {
+    std::vector<double> shares(NUM_PLAYERS, 0.0);
+    std::vector<int> seats(state.active_players.begin(), state.active_players.end());
+    if (seats.size() == 1) {
+        shares[seats[0]] = 1.0;
+        return shares;
+    }
+
+    if (state.community_cards.empty()) {
+        // Specific-hand table from utils/preflop_allin_equity when available
+        const PreflopEquityFile& file = preflopEquityFile();
+        if (file.isOpen()) {
+            int holeCards[6] = {0, 0, 0, 0, 0, 0};
+            double seatShares[3];
+            for (size_t i = 0; i < seats.size(); i++) {
+                holeCards[i * 2] = cardIndex(state.cards[seats[i] * 2]);
+                holeCards[i * 2 + 1] = cardIndex(state.cards[seats[i] * 2 + 1]);
+            }
+            if (file.lookup(holeCards, static_cast<int>(seats.size()), seatShares)) {
+                for (size_t i = 0; i < seats.size(); i++) shares[seats[i]] = seatShares[i];
+                return shares;
+            }
+        }
+
+        int classes[3];
+        for (size_t i = 0; i < seats.size(); i++) {
+            classes[i] = preflopClassIndex(cardIndex(state.cards[seats[i] * 2]), cardIndex(state.cards[seats[i] * 2 + 1]));
+        }
+        std::array<double, 3> classShares = preflopEquityTable().shares(classes, static_cast<int>(seats.size()));
+        for (size_t i = 0; i < seats.size(); i++) shares[seats[i]] = classShares[i];
+        return shares;
+    }
+
+    std::vector<int> holeCards, board, deck;
+    for (int p : seats) {
+        holeCards.push_back(cardIndex(state.cards[p * 2]));
+        holeCards.push_back(cardIndex(state.cards[p * 2 + 1]));
+    }
+    for (const Card& c : state.community_cards) board.push_back(cardIndex(c));
+    for (const Card& c : state.deck) deck.push_back(cardIndex(c));
+
+    std::vector<double> seatShares = enumerateRunoutShares(holeCards, board, deck);
+    for (size_t i = 0; i < seats.size(); i++) shares[seats[i]] = seatShares[i];
+    return shares;
+}
+
+// Expectation of returns() over the runout of an all-in state.
+inline std::vector<double> allInExpectedReturns(const SpinGoState& state) {
+    double totalPot = 0.0;
+    for (int p = 0; p < NUM_PLAYERS; p++) totalPot += state.cumulative_pot[p] + state.pot[p];
+    std::vector<double> shares = allInPotShares(state);
+    std::vector<double> rewards(NUM_PLAYERS, 0.0);
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        rewards[p] = shares[p] * totalPot - state.cumulative_pot[p] - state.pot[p];
+    }
+    return rewards;
+}
+
+#endif // SPINGO_ALLIN_EQUITY_CPP
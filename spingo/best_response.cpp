@@ -0,0 +1,564 @@
+/*
+Best response and exploitability of a trained strategy in the abstracted game.
+
+The strategy is a StrategyProfile: average strategies keyed by the columns of
+the trainer's CSV (round, player, abstraction, previous actions, pot), loaded
+from that CSV or filled from the trainer's nodeMap / a binary checkpoint.
+
+For each player p the evaluator walks the public tree in vector form (see
+vector_cfr.cpp) with the other two players following the profile, and lets p
+pick, per abstraction bucket, the action with the highest counterfactual
+value. Two independent sets of boards are used:
+
+- fit boards: the best response is chosen on all of them at once. Its value
+  there is optimistic (it is fitted to those boards) and is only reported as
+  an in-sample figure.
+- eval boards: the fixed best response and the profile are both played on
+  each board, so every board gives one unbiased sample of p's gain. The mean
+  over boards is reported with a 95% confidence interval.
+
+The best response remembers the whole public betting line, so it may split
+situations the trainer's infoset key merges; buckets it never saw on the fit
+boards follow the profile. As in the vector CFR, card removal between the two
+opponents is ignored. Exploitability is the sum of the players' gains, in the
+same chip units as the trainer's utilities.
+
+All three players are handled in the same walk: the opponents' reaches are
+the profile's either way, and a player's own reach never enters its
+counterfactual values. Fitting runs the branches near the root as separate
+tasks and evaluation splits the eval boards, both on the shared work-stealing
+scheduler (spingo/scheduler.cpp).
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_BEST_RESPONSE_CPP
+#define SPINGO_BEST_RESPONSE_CPP
+
+#include "vector_cfr.cpp"
+#include "scheduler.cpp"
+#include "strategy_file.cpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Average strategies keyed like the rows of the strategy CSV.
+class StrategyProfile {
+public:
+    static std::string key(const std::string& round, const std::string& player, const std::string& abstraction,
+                           const std::string& previousActions, const std::string& pot) {
+        return round + "," + player + "," + abstraction + "," + previousActions + "," + pot;
+    }
+
+    // Rows with the same key (the CSV drops some key fields) are averaged,
+    // weighted by their update counts.
+    void add(const std::string& key, const std::map<std::string, double>& actionProbs, int updateCount) {
+        double weight = std::max(updateCount, 1);
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            entries[key] = Entry{actionProbs, weight};
+            return;
+        }
+        Entry& entry = it->second;
+        for (const auto& [action, prob] : actionProbs) {
+            entry.actionProbs[action] = (entry.actionProbs[action] * entry.weight + prob * weight) / (entry.weight + weight);
+        }
+        entry.weight += weight;
+    }
+
+    // Loads a strategy CSV or binary strategy file.
+    bool loadCSV(const std::string& filename) {
+        if (isStrategyFile(filename)) {
+            StrategyFileReader reader;
+            return reader.open(filename) && reader.forEach([&](const StrategyRow& row) {
+                add(key(STRATEGY_ROUND_NAMES[row.round], std::to_string(row.player), row.abstraction, row.history,
+                        row.potText()),
+                    row.actionProbs(), static_cast<int>(row.updateCount));
+            });
+        }
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Unable to open strategy file: " << filename << std::endl;
+            return false;
+        }
+        std::string line;
+        std::getline(file, line);  // header
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string round, player, abstraction, previousActions, strategyStr, pot, countStr;
+            std::getline(ss, round, ',');
+            std::getline(ss, player, ',');
+            std::getline(ss, abstraction, ',');
+            std::getline(ss, previousActions, ',');
+            std::getline(ss, strategyStr, ',');
+            std::getline(ss, pot, ',');
+            std::getline(ss, countStr, ',');
+
+            std::map<std::string, double> actionProbs;
+            std::stringstream stratSS(strategyStr);
+            std::string actionProb;
+            while (std::getline(stratSS, actionProb, '|')) {
+                size_t colonPos = actionProb.find(':');
+                if (colonPos != std::string::npos) {
+                    actionProbs[actionProb.substr(0, colonPos)] = std::atof(actionProb.c_str() + colonPos + 1);
+                }
+            }
+            add(key(round, player, abstraction, previousActions, pot), actionProbs, std::atoi(countStr.c_str()));
+        }
+        return true;
+    }
+
+    // Fills probs[a] for the node's actions that are legal in bucket; the
+    // rest get 0. Returns false, with a uniform strategy, for unknown keys.
+    bool strategy(const std::string& key, const VectorPublicNode& node, int bucket, double* probs) const {
+        const int numActions = static_cast<int>(node.actions.size());
+        auto it = entries.find(key);
+        double total = 0.0;
+        int legalCount = 0;
+        for (int a = 0; a < numActions; a++) {
+            probs[a] = 0.0;
+            if (!node.isLegal(bucket, a)) continue;
+            legalCount++;
+            if (it != entries.end()) {
+                auto probIt = it->second.actionProbs.find(action_to_string(node.actions[a]));
+                if (probIt != it->second.actionProbs.end()) probs[a] = std::max(0.0, probIt->second);
+            }
+            total += probs[a];
+        }
+        for (int a = 0; a < numActions; a++) {
+            if (!node.isLegal(bucket, a)) continue;
+            probs[a] = total > 0 ? probs[a] / total : 1.0 / legalCount;
+        }
+        return it != entries.end();
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // Calls fn(key, actionProbs, weight) for every merged row.
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (const auto& entry : entries) {
+            fn(entry.first, entry.second.actionProbs, entry.second.weight);
+        }
+    }
+
+private:
+    struct Entry {
+        std::map<std::string, double> actionProbs;
+        double weight;
+    };
+    std::unordered_map<std::string, Entry> entries;
+};
+
+struct BestResponseConfig {
+    int fitBoards = 32;    // boards the best response is chosen on
+    int evalBoards = 128;  // independent boards it is evaluated on
+    unsigned seed = 0;     // 0 = random
+};
+
+struct BestResponseResult {
+    std::vector<double> strategyValue;  // per player, everyone following the profile
+    std::vector<double> responseValue;  // the player best-responding to the others' profile
+    std::vector<double> gain;           // responseValue - strategyValue
+    std::vector<double> gainError;      // 95% confidence half-width of gain
+    double exploitability = 0.0;        // sum of the gains
+    double exploitabilityError = 0.0;
+    double fitExploitability = 0.0;    // in-sample, on the fit boards
+    size_t matchedInfosets = 0;         // profile rows reached by the walk
+    size_t profileInfosets = 0;
+    double seconds = 0.0;
+};
+
+inline void printBestResponse(const BestResponseResult& result, std::ostream& out = std::cout) {
+    out << std::fixed << std::setprecision(4);
+    for (size_t p = 0; p < result.gain.size(); p++) {
+        out << "Player " << p << ": strategy " << result.strategyValue[p]
+            << ", best response " << result.responseValue[p]
+            << ", gain " << result.gain[p] << " +/- " << result.gainError[p] << "\n";
+    }
+    out << "Exploitability: " << result.exploitability << " +/- " << result.exploitabilityError
+        << " (in-sample " << result.fitExploitability << ", " << result.matchedInfosets << "/"
+        << result.profileInfosets << " strategy infosets reached, " << std::setprecision(1)
+        << result.seconds << " s)" << std::endl;
+}
+
+class BestResponseEvaluator {
+public:
+    BestResponseEvaluator(const StrategyProfile& profile, PostflopBucketFn bucketFn,
+                          const BestResponseConfig& config = BestResponseConfig())
+        : profile(profile), bucketFn(bucketFn), config(config), scheduler(sharedScheduler()) {
+        this->config.fitBoards = std::max(1, this->config.fitBoards);
+        this->config.evalBoards = std::max(2, this->config.evalBoards);
+    }
+
+    BestResponseResult run();
+
+private:
+    typedef std::vector<PlayerHandVectors> BoardVectors;  // [board][player][combo]
+
+    // A public node with the profile's strategy for every bucket
+    struct ProfileNode {
+        VectorPublicNode layout;
+        std::vector<double> sigma;  // [bucket * actions + a]
+    };
+
+    const StrategyProfile& profile;
+    PostflopBucketFn bucketFn;
+    BestResponseConfig config;
+
+    std::vector<SampledBoard> fitBoards, evalBoards;
+    int bucketCount[4];
+
+    std::mutex nodesMutex;
+    std::unordered_map<std::string, std::unique_ptr<ProfileNode>> nodes;
+    std::unordered_map<std::string, bool> matchedKeys;
+
+    // Chosen action per bucket, keyed by the full public line
+    std::mutex responsesMutex;
+    std::unordered_map<std::string, std::vector<int>> responses;
+
+    WorkStealingScheduler& scheduler;
+
+    const ProfileNode& profileNode(const SpinGoState& state);
+    void walk(const SpinGoState& state, const std::string& line, const std::vector<const SampledBoard*>& boards,
+              const BoardVectors& reach, BoardVectors& response, BoardVectors& current, bool fit, int depth);
+    void rootValues(const std::vector<const SampledBoard*>& boards, bool fit,
+                    std::vector<std::vector<double>>& response, std::vector<std::vector<double>>& current);
+};
+
+const BestResponseEvaluator::ProfileNode& BestResponseEvaluator::profileNode(const SpinGoState& state) {
+    std::string key = publicNodeKey(state);
+    std::lock_guard<std::mutex> lock(nodesMutex);
+    auto it = nodes.find(key);
+    if (it != nodes.end()) return *it->second;
+
+    std::unique_ptr<ProfileNode> node(new ProfileNode());
+    node->layout = makePublicNode(state);
+    const VectorPublicNode& layout = node->layout;
+    const int numActions = static_cast<int>(layout.actions.size());
+    const int numBuckets = bucketCount[roundIndex(state.round)];
+    node->sigma.assign(static_cast<size_t>(numBuckets) * numActions, 0.0);
+    std::string player = std::to_string(layout.player);
+    for (int b = 0; b < numBuckets; b++) {
+        std::string abstraction = layout.round == "preflop" ? preflopClassLabel(b) : std::to_string(b);
+        std::string rowKey = StrategyProfile::key(layout.round, player, abstraction, layout.history, layout.pot);
+        if (profile.strategy(rowKey, layout, b, &node->sigma[static_cast<size_t>(b) * numActions])) {
+            matchedKeys[rowKey] = true;
+        }
+    }
+    return *nodes.emplace(key, std::move(node)).first->second;
+}
+
+// Counterfactual values of every player on every board. reach holds the
+// profile's reach for all players; a player's own reach never enters its
+// counterfactual value, so one walk serves all three best responses:
+// response[p] has p best-responding below this node, current[p] has p
+// following the profile. With fit, the acting player's best response is
+// chosen here; otherwise the stored one is used.
+void BestResponseEvaluator::walk(const SpinGoState& state, const std::string& line,
+                                 const std::vector<const SampledBoard*>& boards, const BoardVectors& reach,
+                                 BoardVectors& response, BoardVectors& current, bool fit, int depth) {
+    const size_t numBoards = boards.size();
+    response.resize(numBoards);
+    current.resize(numBoards);
+    for (size_t i = 0; i < numBoards; i++) {
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            response[i][p].assign(NUM_HOLE_COMBOS, 0.0);
+            current[i][p].assign(NUM_HOLE_COMBOS, 0.0);
+        }
+    }
+
+    // Every counterfactual value carries two other players' reach, so a
+    // board is done once two reach vectors are empty
+    std::vector<char> live(numBoards, 0);
+    bool anyLive = false;
+    for (size_t i = 0; i < numBoards; i++) {
+        int zeroPlayers = 0;
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            if (boards[i]->allZero(reach[i][p])) zeroPlayers++;
+        }
+        live[i] = zeroPlayers < 2;
+        anyLive = anyLive || live[i];
+    }
+    if (!anyLive) return;
+
+    if (state.game_over) {
+        for (size_t i = 0; i < numBoards; i++) {
+            if (!live[i]) continue;
+            boards[i]->terminalUtilities(state, reach[i], response[i]);
+            current[i] = response[i];
+        }
+        return;
+    }
+
+    if (state.is_chance_node()) {
+        // The boards were sampled up front; dealing just reveals them.
+        SpinGoState next = state;
+        next.apply_action(Action::DEAL);
+        walk(next, line, boards, reach, response, current, fit, depth);
+        return;
+    }
+
+    const ProfileNode& node = profileNode(state);
+    const VectorPublicNode& layout = node.layout;
+    const int actor = layout.player;
+    const int r = roundIndex(state.round);
+    const int numActions = static_cast<int>(layout.actions.size());
+    const int numBuckets = bucketCount[r];
+    auto sigmaOf = [&](int bucket, int a) { return node.sigma[static_cast<size_t>(bucket) * numActions + a]; };
+
+    // The other players' values are summed as each branch finishes; the
+    // actor's branch values are kept until its best action is known.
+    std::vector<std::vector<HandVector>> actorResponse(numActions);  // [a][board]
+    std::mutex sumMutex;
+    auto runChild = [&](int a) {
+        SpinGoState next = state;
+        if (!layout.representative.empty()) {
+            preflopClassRepresentative(layout.representative[a], next.cards[actor * 2], next.cards[actor * 2 + 1]);
+        }
+        next.apply_action(layout.actions[a]);
+
+        BoardVectors childReach = reach;
+        for (size_t i = 0; i < numBoards; i++) {
+            if (!live[i]) continue;
+            const std::vector<int>& bucketOf = boards[i]->buckets[r];
+            HandVector& own = childReach[i][actor];
+            for (int h : boards[i]->availableHands) own[h] = reach[i][actor][h] * sigmaOf(bucketOf[h], a);
+        }
+        BoardVectors childResponse, childCurrent;
+        walk(next, line + "/" + std::to_string(a), boards, childReach, childResponse, childCurrent, fit, depth + 1);
+
+        actorResponse[a].resize(numBoards);
+        std::lock_guard<std::mutex> lock(sumMutex);
+        for (size_t i = 0; i < numBoards; i++) {
+            if (!live[i]) continue;
+            const std::vector<int>& bucketOf = boards[i]->buckets[r];
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                if (p == actor) continue;
+                for (int h : boards[i]->availableHands) {
+                    response[i][p][h] += childResponse[i][p][h];
+                    current[i][p][h] += childCurrent[i][p][h];
+                }
+            }
+            for (int h : boards[i]->availableHands) {
+                current[i][actor][h] += sigmaOf(bucketOf[h], a) * childCurrent[i][actor][h];
+            }
+            actorResponse[a][i] = std::move(childResponse[i][actor]);
+        }
+    };
+
+    // While fitting, the branches near the root run as parallel tasks
+    if (fit && depth < 2) {
+        TaskGroup branches;
+        for (int a = 0; a < numActions; a++) {
+            scheduler.spawn(branches, [&runChild, a]() { runChild(a); });
+        }
+        scheduler.wait(branches);
+    } else {
+        for (int a = 0; a < numActions; a++) runChild(a);
+    }
+
+    std::vector<int> chosen;
+    if (fit) {
+        // Best action per bucket, summed over every combo on every board
+        std::vector<double> score(static_cast<size_t>(numBuckets) * numActions, 0.0);
+        std::vector<char> seen(numBuckets, 0);
+        for (size_t i = 0; i < numBoards; i++) {
+            if (!live[i]) continue;
+            const std::vector<int>& bucketOf = boards[i]->buckets[r];
+            for (int h : boards[i]->availableHands) {
+                int b = bucketOf[h];
+                seen[b] = 1;
+                for (int a = 0; a < numActions; a++) {
+                    score[static_cast<size_t>(b) * numActions + a] += actorResponse[a][i][h];
+                }
+            }
+        }
+        chosen.assign(numBuckets, -1);
+        for (int b = 0; b < numBuckets; b++) {
+            if (!seen[b]) continue;
+            for (int a = 0; a < numActions; a++) {
+                if (!layout.isLegal(b, a)) continue;
+                if (chosen[b] < 0 || score[static_cast<size_t>(b) * numActions + a] >
+                                     score[static_cast<size_t>(b) * numActions + chosen[b]]) {
+                    chosen[b] = a;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(responsesMutex);
+        responses[line] = chosen;
+    } else {
+        // Read-only once fitting is done
+        auto it = responses.find(line);
+        if (it != responses.end()) chosen = it->second;
+    }
+
+    for (size_t i = 0; i < numBoards; i++) {
+        if (!live[i]) continue;
+        const std::vector<int>& bucketOf = boards[i]->buckets[r];
+        for (int h : boards[i]->availableHands) {
+            int b = bucketOf[h];
+            int best = b < static_cast<int>(chosen.size()) ? chosen[b] : -1;
+            if (best >= 0) {
+                response[i][actor][h] = actorResponse[best][i][h];
+            } else {
+                for (int a = 0; a < numActions; a++) {
+                    response[i][actor][h] += sigmaOf(b, a) * actorResponse[a][i][h];
+                }
+            }
+        }
+    }
+}
+
+// Per-player, per-board root values (expected chips per hand).
+void BestResponseEvaluator::rootValues(const std::vector<const SampledBoard*>& boards, bool fit,
+                                       std::vector<std::vector<double>>& response,
+                                       std::vector<std::vector<double>>& current) {
+    BoardVectors reach(boards.size());
+    for (size_t i = 0; i < boards.size(); i++) {
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            reach[i][p].assign(NUM_HOLE_COMBOS, 0.0);
+            for (int h : boards[i]->availableHands) reach[i][p][h] = 1.0;
+        }
+    }
+
+    BoardVectors responseCf, currentCf;
+    walk(publicTreeRoot(boards[0]->board), "", boards, reach, responseCf, currentCf, fit, 0);
+
+    response.assign(NUM_PLAYERS, std::vector<double>(boards.size(), 0.0));
+    current.assign(NUM_PLAYERS, std::vector<double>(boards.size(), 0.0));
+    for (size_t i = 0; i < boards.size(); i++) {
+        double norm = boards[i]->rootNormalizer();
+        if (norm <= 0) continue;
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            for (int h : boards[i]->availableHands) {
+                response[p][i] += responseCf[i][p][h];
+                current[p][i] += currentCf[i][p][h];
+            }
+            response[p][i] /= norm;
+            current[p][i] /= norm;
+        }
+    }
+}
+
+BestResponseResult BestResponseEvaluator::run() {
+    auto start = std::chrono::steady_clock::now();
+    std::mt19937 rng(config.seed ? config.seed : std::random_device{}());
+
+    fitBoards.assign(config.fitBoards, SampledBoard());
+    evalBoards.assign(config.evalBoards, SampledBoard());
+    for (int r = 0; r < 4; r++) bucketCount[r] = 1;
+    for (auto* boards : {&fitBoards, &evalBoards}) {
+        for (SampledBoard& board : *boards) {
+            int cards[5];
+            sampleBoard(rng, cards);
+            board.deal(cards, bucketFn);
+            for (int r = 0; r < 4; r++) bucketCount[r] = std::max(bucketCount[r], board.bucketCount[r]);
+        }
+    }
+    nodes.clear();
+    matchedKeys.clear();
+    responses.clear();
+
+    BestResponseResult result;
+
+    // Fit every player's best response on all fit boards together
+    std::vector<const SampledBoard*> fitSet;
+    for (const SampledBoard& board : fitBoards) fitSet.push_back(&board);
+    std::vector<std::vector<double>> fitResponse, fitCurrent;
+    rootValues(fitSet, true, fitResponse, fitCurrent);
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        for (size_t i = 0; i < fitSet.size(); i++) {
+            result.fitExploitability += (fitResponse[p][i] - fitCurrent[p][i]) / fitSet.size();
+        }
+    }
+
+    // Play the fixed responses on each eval board
+    std::vector<std::vector<double>> response(NUM_PLAYERS, std::vector<double>(evalBoards.size(), 0.0));
+    std::vector<std::vector<double>> current(NUM_PLAYERS, std::vector<double>(evalBoards.size(), 0.0));
+    scheduler.parallelFor(0, evalBoards.size(), 1, [&](long begin, long end) {
+        std::vector<std::vector<double>> boardResponse, boardCurrent;
+        for (long i = begin; i < end; i++) {
+            rootValues({&evalBoards[i]}, false, boardResponse, boardCurrent);
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                response[p][i] = boardResponse[p][0];
+                current[p][i] = boardCurrent[p][0];
+            }
+        }
+    });
+
+    // Mean and 95% confidence half-width over boards
+    const double n = static_cast<double>(evalBoards.size());
+    auto meanAndError = [n](const std::vector<double>& samples, double& mean, double& error) {
+        mean = 0.0;
+        for (double x : samples) mean += x;
+        mean /= n;
+        double variance = 0.0;
+        for (double x : samples) variance += (x - mean) * (x - mean);
+        variance /= (n - 1);
+        error = 1.96 * std::sqrt(variance / n);
+    };
+
+    std::vector<double> totalGain(evalBoards.size(), 0.0);
+    result.strategyValue.assign(NUM_PLAYERS, 0.0);
+    result.responseValue.assign(NUM_PLAYERS, 0.0);
+    result.gain.assign(NUM_PLAYERS, 0.0);
+    result.gainError.assign(NUM_PLAYERS, 0.0);
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        std::vector<double> gain(evalBoards.size());
+        for (size_t i = 0; i < evalBoards.size(); i++) {
+            gain[i] = response[p][i] - current[p][i];
+            totalGain[i] += gain[i];
+            result.strategyValue[p] += current[p][i] / n;
+            result.responseValue[p] += response[p][i] / n;
+        }
+        meanAndError(gain, result.gain[p], result.gainError[p]);
+    }
+    meanAndError(totalGain, result.exploitability, result.exploitabilityError);
+
+    result.matchedInfosets = matchedKeys.size();
+    result.profileInfosets = profile.size();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Follows exploitability estimates during training. Training has stalled
+// once `patience` evaluations in a row fail to beat the best estimate so far
+// by more than their own confidence interval.
+class ConvergenceMonitor {
+public:
+    explicit ConvergenceMonitor(int patience) : patience(patience), stalled(0), best(0.0), hasBest(false) {}
+
+    // Returns true when training should stop.
+    bool record(const BestResponseResult& result) {
+        if (!hasBest || result.exploitability < best - result.exploitabilityError) {
+            stalled = 0;
+        } else {
+            stalled++;
+        }
+        if (!hasBest || result.exploitability < best) best = result.exploitability;
+        hasBest = true;
+        return patience > 0 && stalled >= patience;
+    }
+
+    int stalledEvaluations() const { return stalled; }
+    double bestExploitability() const { return best; }
+
+private:
+    int patience;
+    int stalled;
+    double best;
+    bool hasBest;
+};
+
+#endif // SPINGO_BEST_RESPONSE_CPP
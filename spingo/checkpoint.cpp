@@ -0,0 +1,247 @@
+/*
+Binary checkpoints of the MCCFR training state.
+
+A checkpoint holds everything needed to continue a run: the iteration count,
+the accumulated root utilities, the state of the action sampler's RNG and,
+for every infoset, its actions, regret sums, strategy sums and update count.
+The header carries a format version and a hash of the abstraction/config the
+run was started with, so a checkpoint is never resumed under different
+clusters.
+
+Layout (native endianness):
+    magic "SGCKPT1\0", uint32 version, uint64 configHash, uint64 iteration,
+    uint32 numPlayers, numPlayers x double totalUtility,
+    uint32 rngStateLength, rngState bytes,
+    uint64 nodeCount, then per node:
+        uint32 keyLength, key bytes, uint32 numActions,
+        numActions x uint8 action, numActions x double regretSum,
+        numActions x double strategySum, int32 strategyUpdateCount,
+        uint8 fieldsLength, fieldsLength bytes (version 2)
+
+The functions are templates over the trainer's node map (std::unordered_map
+or PartitionedNodeTable) and Node type, which only needs the regretSum /
+strategy / strategySum / actions / strategyUpdateCount fields. A node type
+with a trivially copyable `fields` member (the trainers keep InfosetFields
+there) gets it saved as the fields bytes; version-1 files, and fields of
+another size, load with default fields.
+*/
+
+#ifndef SPINGO_CHECKPOINT_CPP
+#define SPINGO_CHECKPOINT_CPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static const char CHECKPOINT_MAGIC[8] = {'S', 'G', 'C', 'K', 'P', 'T', '1', '\0'};
+static const uint32_t CHECKPOINT_VERSION = 2;
+
+// Access to a node's optional `fields` member as raw bytes (see above).
+template <typename NodeT, typename = void>
+struct NodeFields {
+    static constexpr size_t size = 0;
+    static void write(const NodeT&, char*) {}
+    static void read(NodeT&, const char*) {}
+};
+
+template <typename NodeT>
+struct NodeFields<NodeT, std::void_t<decltype(std::declval<NodeT&>().fields)>> {
+    using Fields = decltype(std::declval<NodeT&>().fields);
+    static_assert(std::is_trivially_copyable<Fields>::value, "node fields must be trivially copyable");
+    static constexpr size_t size = sizeof(Fields);
+    static void write(const NodeT& node, char* out) { std::memcpy(out, &node.fields, size); }
+    static void read(NodeT& node, const char* in) { std::memcpy(&node.fields, in, size); }
+};
+
+struct CheckpointInfo {
+    uint64_t configHash = 0;
+    uint64_t iteration = 0;
+    std::vector<double> totalUtility;
+    std::string rngState;  // textual std::mt19937 state (operator<<)
+};
+
+// FNV-1a, used for the config hash.
+inline uint64_t fnv1a64(const std::string& data, uint64_t hash = 1469598103934665603ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+inline void writePod(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline bool readPod(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+inline void writeString(std::ostream& out, const std::string& s) {
+    writePod<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), s.size());
+}
+
+inline bool readString(std::istream& in, std::string& s) {
+    uint32_t length;
+    if (!readPod(in, length)) return false;
+    s.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&s[0], length));
+}
+
+template <typename NodeT>
+void writeCheckpointNode(std::ostream& out, const std::string& key, const NodeT& node) {
+    writeString(out, key);
+    uint32_t numActions = static_cast<uint32_t>(node.regretSum.size());
+    writePod(out, numActions);
+    for (uint32_t a = 0; a < numActions; a++) {
+        writePod<uint8_t>(out, a < node.actions.size() ? static_cast<uint8_t>(node.actions[a]) : 0);
+    }
+    out.write(reinterpret_cast<const char*>(node.regretSum.data()), numActions * sizeof(double));
+    for (uint32_t a = 0; a < numActions; a++) {
+        writePod<double>(out, a < node.strategySum.size() ? node.strategySum[a] : 0.0);
+    }
+    writePod<int32_t>(out, node.strategyUpdateCount);
+    char fields[NodeFields<NodeT>::size + 1];
+    NodeFields<NodeT>::write(node, fields);
+    writePod<uint8_t>(out, static_cast<uint8_t>(NodeFields<NodeT>::size));
+    out.write(fields, NodeFields<NodeT>::size);
+}
+
+inline void writeCheckpointHeader(std::ostream& out, const CheckpointInfo& info, uint64_t nodeCount) {
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    writePod(out, CHECKPOINT_VERSION);
+    writePod(out, info.configHash);
+    writePod(out, info.iteration);
+    writePod<uint32_t>(out, static_cast<uint32_t>(info.totalUtility.size()));
+    for (double u : info.totalUtility) writePod(out, u);
+    writeString(out, info.rngState);
+    writePod(out, nodeCount);
+}
+
+// Writes the checkpoint to filename + ".tmp" and renames it into place, so an
+// interrupted save never replaces the previous good checkpoint.
+template <typename NodeMapT>
+bool saveCheckpoint(const std::string& filename, const NodeMapT& nodes, const CheckpointInfo& info) {
+    std::string tmpFile = filename + ".tmp";
+    std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open checkpoint file: " << tmpFile << std::endl;
+        return false;
+    }
+
+    writeCheckpointHeader(out, info, nodes.size());
+    for (const auto& entry : nodes) {
+        writeCheckpointNode(out, entry.first, entry.second);
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "Error writing checkpoint file: " << tmpFile << std::endl;
+        return false;
+    }
+    if (std::rename(tmpFile.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Unable to move checkpoint into place: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename NodeT>
+void replaceNodes(std::unordered_map<std::string, NodeT>& nodes, std::unordered_map<std::string, NodeT>& loaded) {
+    nodes.swap(loaded);
+}
+
+// Loads a checkpoint into nodes (replacing its contents). Fails without
+// touching nodes if the file is unreadable, from another format version, or
+// was written under a different config hash.
+template <typename NodeMapT>
+bool loadCheckpoint(const std::string& filename, NodeMapT& nodes, CheckpointInfo& info, uint64_t expectedConfigHash) {
+    using NodeT = typename NodeMapT::mapped_type;
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Unable to open checkpoint file: " << filename << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    CheckpointInfo loaded;
+    uint32_t numPlayers = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a checkpoint file: " << filename << std::endl;
+        return false;
+    }
+    if (!readPod(in, version) || version < 1 || version > CHECKPOINT_VERSION) {
+        std::cerr << "Unsupported checkpoint version " << version << " in " << filename << std::endl;
+        return false;
+    }
+    if (!readPod(in, loaded.configHash) || !readPod(in, loaded.iteration) || !readPod(in, numPlayers)) {
+        std::cerr << "Truncated checkpoint header in " << filename << std::endl;
+        return false;
+    }
+    if (loaded.configHash != expectedConfigHash) {
+        std::cerr << "Checkpoint " << filename << " was written with a different abstraction/config "
+                  << "(hash " << loaded.configHash << ", expected " << expectedConfigHash << ")" << std::endl;
+        return false;
+    }
+    loaded.totalUtility.resize(numPlayers);
+    for (uint32_t p = 0; p < numPlayers; p++) {
+        if (!readPod(in, loaded.totalUtility[p])) return false;
+    }
+    uint64_t nodeCount = 0;
+    if (!readString(in, loaded.rngState) || !readPod(in, nodeCount)) {
+        std::cerr << "Truncated checkpoint header in " << filename << std::endl;
+        return false;
+    }
+
+    std::unordered_map<std::string, NodeT> loadedNodes;
+    loadedNodes.reserve(nodeCount);
+    for (uint64_t i = 0; i < nodeCount; i++) {
+        std::string key;
+        uint32_t numActions = 0;
+        if (!readString(in, key) || !readPod(in, numActions)) {
+            std::cerr << "Truncated checkpoint node " << i << " in " << filename << std::endl;
+            return false;
+        }
+        NodeT node(static_cast<int>(numActions));
+        node.actions.resize(numActions);
+        for (uint32_t a = 0; a < numActions; a++) {
+            uint8_t action;
+            if (!readPod(in, action)) return false;
+            node.actions[a] = static_cast<typename decltype(node.actions)::value_type>(action);
+        }
+        int32_t updateCount = 0;
+        if (!in.read(reinterpret_cast<char*>(node.regretSum.data()), numActions * sizeof(double)) ||
+            !in.read(reinterpret_cast<char*>(node.strategySum.data()), numActions * sizeof(double)) ||
+            !readPod(in, updateCount)) {
+            std::cerr << "Truncated checkpoint node " << i << " in " << filename << std::endl;
+            return false;
+        }
+        node.strategyUpdateCount = updateCount;
+        if (version >= 2) {
+            uint8_t fieldsLength = 0;
+            char fields[256];
+            if (!readPod(in, fieldsLength) || !in.read(fields, fieldsLength)) {
+                std::cerr << "Truncated checkpoint node " << i << " in " << filename << std::endl;
+                return false;
+            }
+            if (fieldsLength == NodeFields<NodeT>::size) NodeFields<NodeT>::read(node, fields);
+        }
+        loadedNodes.emplace(std::move(key), std::move(node));
+    }
+
+    replaceNodes(nodes, loadedNodes);
+    info = loaded;
+    return true;
+}
+
+#endif // SPINGO_CHECKPOINT_CPP
@@ -0,0 +1,209 @@
+/*
+Append-only, memory-mapped record store for infosets evicted from RAM.
+
+Records are (key, payload) pairs appended to a file that is mapped into the
+address space and grown by doubling; the kernel pages them in on access and
+writes them back under memory pressure, so only the index stays in RAM: a
+multimap from the 64-bit key hash to the record offset (the key is stored in
+the record and compared on lookup, which resolves hash collisions). That is
+about 40 bytes per cold key, against a few hundred for an in-memory node.
+
+Records are never overwritten. take() only drops the index entry and counts
+the record as garbage; once garbage outweighs live data the live records are
+copied to a fresh file. Because existing bytes never change, a child forked
+for a background snapshot can keep reading the records its copy of the index
+points at while the parent carries on evicting and compacting.
+
+The file is unlinked as soon as it is created, so it disappears when the
+process exits; checkpoints are what persist the state. Not thread-safe.
+
+Record layout: uint32 keyLength, uint32 payloadLength, key, payload.
+*/
+
+#ifndef SPINGO_COLD_STORE_CPP
+#define SPINGO_COLD_STORE_CPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+class ColdStore {
+public:
+    using Index = std::unordered_multimap<uint64_t, uint64_t>;  // key hash -> record offset
+
+    ColdStore() : fd(-1), base(nullptr), capacity(0), used(0), garbage(0), compactions(0), fileIndex(0) {}
+    ~ColdStore() { closeFile(fd, base, capacity); }
+
+    ColdStore(const ColdStore&) = delete;
+    ColdStore& operator=(const ColdStore&) = delete;
+
+    // Creates the backing file; path is a prefix, each compaction makes a new
+    // file next to it.
+    bool open(const std::string& path) {
+        pathPrefix = path;
+        return createFile(INITIAL_CAPACITY, fd, base, capacity);
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    // Appends a record for key, which must not already be in the store.
+    void put(const std::string& key, const char* payload, uint32_t length) {
+        uint64_t offset = append(fd, base, capacity, used, key.data(), static_cast<uint32_t>(key.size()),
+                                 payload, length);
+        index.emplace(hashKey(key), offset);
+    }
+
+    // Removes key and copies its payload out. Returns false if absent.
+    bool take(const std::string& key, std::string& payload) {
+        auto range = index.equal_range(hashKey(key));
+        for (auto it = range.first; it != range.second; ++it) {
+            uint32_t keyLength, payloadLength;
+            const char* record = base + it->second;
+            std::memcpy(&keyLength, record, sizeof(keyLength));
+            std::memcpy(&payloadLength, record + 4, sizeof(payloadLength));
+            if (keyLength != key.size() || std::memcmp(record + 8, key.data(), keyLength) != 0) continue;
+            payload.assign(record + 8 + keyLength, payloadLength);
+            garbage += recordSize(keyLength, payloadLength);
+            index.erase(it);
+            if (garbage > COMPACT_MIN_GARBAGE && garbage > used - garbage) compact();
+            return true;
+        }
+        return false;
+    }
+
+    bool contains(const std::string& key) const {
+        auto range = index.equal_range(hashKey(key));
+        for (auto it = range.first; it != range.second; ++it) {
+            uint32_t keyLength;
+            std::memcpy(&keyLength, base + it->second, sizeof(keyLength));
+            if (keyLength == key.size() && std::memcmp(base + it->second + 8, key.data(), keyLength) == 0) return true;
+        }
+        return false;
+    }
+
+    // Reads the record at offset (an Index value).
+    void read(uint64_t offset, std::string& key, const char*& payload, uint32_t& length) const {
+        uint32_t keyLength;
+        std::memcpy(&keyLength, base + offset, sizeof(keyLength));
+        std::memcpy(&length, base + offset + 4, sizeof(length));
+        key.assign(base + offset + 8, keyLength);
+        payload = base + offset + 8 + keyLength;
+    }
+
+    const Index& entries() const { return index; }
+    size_t size() const { return index.size(); }
+    uint64_t liveBytes() const { return used - garbage; }
+    uint64_t fileBytes() const { return capacity; }
+    uint64_t compactionCount() const { return compactions; }
+
+private:
+    static const uint64_t INITIAL_CAPACITY = 16 << 20;
+    static const uint64_t COMPACT_MIN_GARBAGE = 64 << 20;
+
+    std::string pathPrefix;
+    int fd;
+    char* base;
+    uint64_t capacity;
+    uint64_t used;
+    uint64_t garbage;
+    uint64_t compactions;
+    int fileIndex;
+    Index index;
+
+    static uint64_t hashKey(const std::string& key) { return std::hash<std::string>()(key); }
+
+    // Records start 8-byte aligned
+    static uint64_t recordSize(uint32_t keyLength, uint32_t payloadLength) {
+        return (8 + static_cast<uint64_t>(keyLength) + payloadLength + 7) & ~uint64_t(7);
+    }
+
+    bool createFile(uint64_t size, int& newFd, char*& newBase, uint64_t& newCapacity) {
+        std::string path = pathPrefix + "." + std::to_string(fileIndex++);
+        newFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (newFd < 0) {
+            std::cerr << "Unable to create cold infoset file: " << path << std::endl;
+            return false;
+        }
+        unlink(path.c_str());
+        newBase = nullptr;
+        newCapacity = 0;
+        return resize(newFd, newBase, newCapacity, size);
+    }
+
+    static bool resize(int fileFd, char*& mapping, uint64_t& mappedSize, uint64_t size) {
+        if (ftruncate(fileFd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Unable to grow cold infoset file to " << size << " bytes" << std::endl;
+            return false;
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileFd, 0);
+        if (p == MAP_FAILED) {
+            std::cerr << "Unable to map cold infoset file (" << size << " bytes)" << std::endl;
+            return false;
+        }
+        if (mapping) munmap(mapping, mappedSize);
+        mapping = static_cast<char*>(p);
+        mappedSize = size;
+        return true;
+    }
+
+    static void closeFile(int fileFd, char* mapping, uint64_t mappedSize) {
+        if (mapping) munmap(mapping, mappedSize);
+        if (fileFd >= 0) ::close(fileFd);
+    }
+
+    static uint64_t append(int fileFd, char*& mapping, uint64_t& mappedSize, uint64_t& end,
+                           const char* key, uint32_t keyLength, const char* payload, uint32_t payloadLength) {
+        uint64_t size = recordSize(keyLength, payloadLength);
+        if (end + size > mappedSize) {
+            uint64_t newSize = mappedSize;
+            while (end + size > newSize) newSize *= 2;
+            if (!resize(fileFd, mapping, mappedSize, newSize)) throw std::bad_alloc();
+        }
+        char* record = mapping + end;
+        std::memcpy(record, &keyLength, sizeof(keyLength));
+        std::memcpy(record + 4, &payloadLength, sizeof(payloadLength));
+        std::memcpy(record + 8, key, keyLength);
+        std::memcpy(record + 8 + keyLength, payload, payloadLength);
+        uint64_t offset = end;
+        end += size;
+        return offset;
+    }
+
+    // Copies the live records into a new file and switches to it.
+    void compact() {
+        uint64_t live = used - garbage;
+        uint64_t size = INITIAL_CAPACITY;
+        while (size < live + live / 2) size *= 2;
+        int newFd;
+        char* newBase;
+        uint64_t newCapacity;
+        if (!createFile(size, newFd, newBase, newCapacity)) return;  // keep the old file
+
+        uint64_t newUsed = 0;
+        for (auto& entry : index) {
+            uint32_t keyLength, payloadLength;
+            const char* record = base + entry.second;
+            std::memcpy(&keyLength, record, sizeof(keyLength));
+            std::memcpy(&payloadLength, record + 4, sizeof(payloadLength));
+            entry.second = append(newFd, newBase, newCapacity, newUsed, record + 8, keyLength,
+                                  record + 8 + keyLength, payloadLength);
+        }
+        closeFile(fd, base, capacity);
+        fd = newFd;
+        base = newBase;
+        capacity = newCapacity;
+        used = newUsed;
+        garbage = 0;
+        compactions++;
+    }
+};
+
+#endif // SPINGO_COLD_STORE_CPP
@@ -0,0 +1,385 @@
+/*
+Streaming duplicate detection for large line-oriented files (infoset dumps,
+strategy CSVs) in bounded memory.
+
+  1. The input is read once. Every line, or its key (the first keyColumns
+     CSV fields), is hashed to a 128-bit fingerprint (MurmurHash3 x64-128),
+     and the fingerprint and line number go to one of P partition files in
+     tempDir, chosen by the top bits of the fingerprint.
+  2. The partitions are checked in parallel on the shared scheduler. Each
+     is loaded and sorted, and runs of equal fingerprints are the duplicate
+     groups. A partition larger than its share of memoryBytes is first
+     split again by other fingerprint bits.
+  3. The reported groups, those whose first line comes earliest (up to
+     maxReported), are read back from the input and their lines compared
+     as text.
+
+Lines are held only in step 3, so memory is the partition writers' buffers
+plus one partition (24 bytes per line) per thread. Counts are exact up to
+128-bit fingerprint collisions, whose probability is about n^2 / 2^129 for
+n lines (below 1e-18 for ten billion lines).
+*/
+
+#ifndef SPINGO_DUPLICATE_CHECK_CPP
+#define SPINGO_DUPLICATE_CHECK_CPP
+
+#include "scheduler.cpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct DuplicateCheckOptions {
+    size_t memoryBytes = size_t(512) << 20;  // partitions checked at once
+    int keyColumns = 0;                      // 0 = the whole line is the key
+    bool skipHeader = false;                 // leave line 1 out
+    std::string tempDir;                     // default: <input>.dupcheck
+    size_t maxReported = 100;                // groups reported with their lines
+    int threads = 0;                         // scheduler threads (0 = all cores) if it is not running yet
+};
+
+struct DuplicateGroup {
+    std::vector<uint64_t> lines;  // 1-based line numbers, ascending
+    std::string key;              // the shared key, read back in step 3
+    bool confirmed = false;       // every line's key equals the first's
+};
+
+struct DuplicateReport {
+    uint64_t lines = 0;           // lines checked
+    uint64_t duplicateLines = 0;  // lines whose key is on an earlier line
+    uint64_t groups = 0;          // keys that occur more than once
+    std::vector<DuplicateGroup> reported;
+};
+
+// 128-bit fingerprint of a key, MurmurHash3 x64-128 with seed 0.
+struct Fingerprint128 {
+    uint64_t hi = 0, lo = 0;
+
+    static Fingerprint128 of(const char* data, size_t length) {
+        const uint64_t c1 = 0x87C37B91114253D5ULL, c2 = 0x4CF5AD432745937FULL;
+        uint64_t h1 = 0, h2 = 0;
+        const size_t blocks = length / 16;
+        for (size_t i = 0; i < blocks; i++) {
+            uint64_t k1, k2;
+            std::memcpy(&k1, data + 16 * i, 8);
+            std::memcpy(&k2, data + 16 * i + 8, 8);
+            k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+            h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+            k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+            h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+        }
+        const unsigned char* tail = reinterpret_cast<const unsigned char*>(data + 16 * blocks);
+        uint64_t k1 = 0, k2 = 0;
+        switch (length & 15) {
+        case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; // fall through
+        case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; // fall through
+        case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; // fall through
+        case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; // fall through
+        case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; // fall through
+        case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8;   // fall through
+        case 9:
+            k2 ^= static_cast<uint64_t>(tail[8]);
+            k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+            // fall through
+        case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; // fall through
+        case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; // fall through
+        case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; // fall through
+        case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; // fall through
+        case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; // fall through
+        case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; // fall through
+        case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8;  // fall through
+        case 1:
+            k1 ^= static_cast<uint64_t>(tail[0]);
+            k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+        h1 ^= length; h2 ^= length;
+        h1 += h2; h2 += h1;
+        h1 = fmix(h1); h2 = fmix(h2);
+        h1 += h2; h2 += h1;
+        Fingerprint128 fingerprint;
+        fingerprint.hi = h1;
+        fingerprint.lo = h2;
+        return fingerprint;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t fmix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ULL;
+        return k ^ (k >> 33);
+    }
+};
+
+namespace duplicate_check {
+
+struct Record {
+    uint64_t hi, lo, line;
+};
+
+// The key of a line: the line, or its first keyColumns comma-separated fields.
+inline size_t keyLength(const std::string& line, int keyColumns) {
+    if (keyColumns <= 0) return line.size();
+    size_t pos = 0;
+    for (int c = 0; c < keyColumns; c++) {
+        pos = line.find(',', pos);
+        if (pos == std::string::npos) return line.size();
+        pos++;
+    }
+    return pos - 1;
+}
+
+// Buffered appends of records to one partition file.
+class PartitionWriter {
+public:
+    explicit PartitionWriter(const std::string& path) : path(path) {}
+
+    bool add(const Record& record) {
+        buffer.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+        return buffer.size() < BUFFER_BYTES || flush();
+    }
+
+    bool flush() {
+        if (buffer.empty()) return true;
+        if (!file.is_open()) file.open(path, std::ios::binary | std::ios::trunc);
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+        if (!file) {
+            std::cerr << "Error writing " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool close() {
+        bool ok = flush();
+        if (file.is_open()) file.close();
+        return ok;
+    }
+
+private:
+    static const size_t BUFFER_BYTES = 1 << 16;
+    std::string path;
+    std::string buffer;
+    std::ofstream file;
+};
+
+// Groups found in partitions, keeping only the earliest maxReported.
+class GroupCollector {
+public:
+    explicit GroupCollector(size_t maxReported) : limit(maxReported) {}
+
+    void add(std::vector<DuplicateGroup>&& found, uint64_t groups, uint64_t duplicateLines) {
+        std::lock_guard<std::mutex> lock(mutex);
+        report.groups += groups;
+        report.duplicateLines += duplicateLines;
+        for (auto& group : found) report.reported.push_back(std::move(group));
+        trim(report.reported, limit);
+    }
+
+    // Keeps the groups whose first lines are earliest.
+    static void trim(std::vector<DuplicateGroup>& groups, size_t limit) {
+        if (groups.size() <= limit) return;
+        std::nth_element(groups.begin(), groups.begin() + limit, groups.end(), earlier);
+        groups.resize(limit);
+    }
+
+    static bool earlier(const DuplicateGroup& a, const DuplicateGroup& b) { return a.lines[0] < b.lines[0]; }
+
+    DuplicateReport report;
+
+private:
+    size_t limit;
+    std::mutex mutex;
+};
+
+inline bool readRecords(const std::string& path, std::vector<Record>& records) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    records.clear();
+    if (!file.is_open()) return true;  // partition without records
+    size_t bytes = static_cast<size_t>(file.tellg());
+    records.resize(bytes / sizeof(Record));
+    file.seekg(0);
+    if (!records.empty() && !file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record))) {
+        std::cerr << "Error reading " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Checks one partition file, splitting it by 4 more bits of lo at a time
+// while it is larger than limitBytes.
+inline bool checkPartition(const std::string& path, size_t limitBytes, int level, size_t maxReported,
+                           GroupCollector& collector) {
+    std::error_code error;
+    uintmax_t bytes = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    if (bytes > limitBytes && level < 16) {
+        std::vector<std::unique_ptr<PartitionWriter>> writers;
+        for (int s = 0; s < 16; s++) writers.emplace_back(new PartitionWriter(path + "." + std::to_string(s)));
+        {
+            std::ifstream file(path, std::ios::binary);
+            Record record;
+            while (file.read(reinterpret_cast<char*>(&record), sizeof(Record))) {
+                if (!writers[(record.lo >> (60 - 4 * level)) & 15]->add(record)) return false;
+            }
+        }
+        for (auto& writer : writers) {
+            if (!writer->close()) return false;
+        }
+        std::filesystem::remove(path, error);
+        for (int s = 0; s < 16; s++) {
+            if (!checkPartition(path + "." + std::to_string(s), limitBytes, level + 1, maxReported, collector)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Record> records;
+    if (!readRecords(path, records)) return false;
+    std::filesystem::remove(path, error);
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        if (a.hi != b.hi) return a.hi < b.hi;
+        if (a.lo != b.lo) return a.lo < b.lo;
+        return a.line < b.line;
+    });
+    std::vector<DuplicateGroup> found;
+    uint64_t groups = 0, duplicateLines = 0;
+    for (size_t i = 0; i < records.size();) {
+        size_t j = i + 1;
+        while (j < records.size() && records[j].hi == records[i].hi && records[j].lo == records[i].lo) j++;
+        if (j - i > 1) {
+            groups++;
+            duplicateLines += j - i - 1;
+            DuplicateGroup group;
+            for (size_t k = i; k < j; k++) group.lines.push_back(records[k].line);
+            found.push_back(std::move(group));
+            if (found.size() > 2 * maxReported) GroupCollector::trim(found, maxReported);
+        }
+        i = j;
+    }
+    GroupCollector::trim(found, maxReported);
+    collector.add(std::move(found), groups, duplicateLines);
+    return true;
+}
+
+// Reads the reported groups' keys back and compares them.
+inline bool confirmGroups(const std::string& input, const DuplicateCheckOptions& options,
+                          std::vector<DuplicateGroup>& groups) {
+    std::vector<std::pair<uint64_t, size_t>> wanted;  // line, group
+    for (size_t g = 0; g < groups.size(); g++) {
+        groups[g].confirmed = true;
+        for (uint64_t line : groups[g].lines) wanted.emplace_back(line, g);
+    }
+    std::sort(wanted.begin(), wanted.end());
+    std::ifstream file(input);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << input << std::endl;
+        return false;
+    }
+    std::string line;
+    uint64_t number = 0;
+    size_t next = 0;
+    while (next < wanted.size() && std::getline(file, line)) {
+        number++;
+        for (; next < wanted.size() && wanted[next].first == number; next++) {
+            DuplicateGroup& group = groups[wanted[next].second];
+            std::string key = line.substr(0, keyLength(line, options.keyColumns));
+            if (number == group.lines[0]) group.key = key;
+            else if (key != group.key) group.confirmed = false;
+        }
+    }
+    return true;
+}
+
+} // namespace duplicate_check
+
+// Finds every key of input that occurs on more than one line.
+inline bool findDuplicates(const std::string& input, DuplicateReport& report,
+                           const DuplicateCheckOptions& options = DuplicateCheckOptions()) {
+    using namespace duplicate_check;
+    WorkStealingScheduler& scheduler = sharedScheduler(options.threads > 0 ? options.threads - 1 : 0);
+    const int concurrency = scheduler.concurrency();
+    const size_t limitBytes = std::max<size_t>(options.memoryBytes / concurrency, sizeof(Record));
+
+    std::ifstream file(input);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << input << std::endl;
+        return false;
+    }
+    std::error_code error;
+    uintmax_t inputBytes = std::filesystem::file_size(input, error);
+    if (error) inputBytes = 0;
+
+    // Enough partitions that one per thread fits in memory if lines average
+    // 32 bytes; larger ones are split again when they are checked
+    int bits = 0;
+    while ((1 << bits) < 4 * concurrency) bits++;
+    while (bits < 12 && (static_cast<uintmax_t>(sizeof(Record)) * (inputBytes / 32) >> bits) > limitBytes) bits++;
+    const int numPartitions = 1 << bits;
+
+    std::string dir = options.tempDir.empty() ? input + ".dupcheck" : options.tempDir;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        std::cerr << "Unable to create " << dir << ": " << error.message() << std::endl;
+        return false;
+    }
+    struct DirRemover {
+        std::string path;
+        ~DirRemover() {
+            std::error_code ignored;
+            std::filesystem::remove_all(path, ignored);
+        }
+    } remover{dir};
+
+    // 1. Fingerprint every line into the partitions.
+    std::vector<std::string> paths;
+    std::vector<std::unique_ptr<PartitionWriter>> writers;
+    for (int p = 0; p < numPartitions; p++) {
+        paths.push_back(dir + "/part" + std::to_string(p));
+        writers.emplace_back(new PartitionWriter(paths.back()));
+    }
+    std::string line;
+    uint64_t number = 0, checked = 0;
+    while (std::getline(file, line)) {
+        number++;
+        if (number == 1 && options.skipHeader) continue;
+        Fingerprint128 fingerprint = Fingerprint128::of(line.data(), keyLength(line, options.keyColumns));
+        Record record = {fingerprint.hi, fingerprint.lo, number};
+        size_t p = bits == 0 ? 0 : static_cast<size_t>(fingerprint.hi >> (64 - bits));
+        if (!writers[p]->add(record)) return false;
+        checked++;
+    }
+    for (auto& writer : writers) {
+        if (!writer->close()) return false;
+    }
+    writers.clear();
+
+    // 2. Check the partitions in parallel.
+    GroupCollector collector(options.maxReported);
+    std::atomic<bool> failed(false);
+    scheduler.parallelFor(0, numPartitions, 1, [&](long begin, long end) {
+        for (long p = begin; p < end && !failed; p++) {
+            if (!checkPartition(paths[p], limitBytes, 0, options.maxReported, collector)) failed = true;
+        }
+    });
+    if (failed) return false;
+
+    // 3. Confirm and order the reported groups.
+    report = std::move(collector.report);
+    report.lines = checked;
+    std::sort(report.reported.begin(), report.reported.end(), GroupCollector::earlier);
+    return confirmGroups(input, options, report.reported);
+}
+
+#endif // SPINGO_DUPLICATE_CHECK_CPP
@@ -0,0 +1,148 @@
+/*
+Integer hand scoring for hot loops.
+
+Cards are encoded as ints 0..51: rank index * 4 + suit index, using the same
+RANKS ("2".."A") and SUITS (h, d, c, s) order as spingo.cpp. fastHandScore()
+returns exactly the value PokerEvaluator::evaluateHand() would return for the
+same cards (category * 1000000 + sum of the scored card values), so results
+can be compared with, or substituted for, the engine's showdown scores. It
+works from rank counts and per-suit bit masks instead of building all 21
+five-card combinations out of strings.
+
+This file has no dependency on Card so the utils/ tools can include it too.
+*/
+
+#ifndef SPINGO_FAST_EVAL_CPP
+#define SPINGO_FAST_EVAL_CPP
+
+#include <algorithm>
+#include <string>
+
+static const int FAST_EVAL_NUM_CARDS = 52;
+
+inline int cardRankIndex(int card) { return card >> 2; }
+inline int cardSuitIndex(int card) { return card & 3; }
+
+// Converts the string representation used by Card ("10", "h") to a card index.
+// Returns -1 for unknown ranks or suits.
+inline int cardIndexFromStrings(const std::string& rank, const std::string& suit) {
+    static const char* rankNames[13] = {"2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K", "A"};
+    static const char suitNames[4] = {'h', 'd', 'c', 's'};
+    int r = -1, s = -1;
+    for (int i = 0; i < 13; i++) {
+        if (rank == rankNames[i]) { r = i; break; }
+    }
+    for (int i = 0; i < 4 && !suit.empty(); i++) {
+        if (suit[0] == suitNames[i]) { s = i; break; }
+    }
+    if (r < 0 || s < 0) return -1;
+    return r * 4 + s;
+}
+
+// Index of the two-card preflop class in a 13x13 grid (0..168): pairs on the
+// diagonal, suited hands above it, offsuit hands below it.
+inline int preflopClassIndex(int card1, int card2) {
+    int r1 = cardRankIndex(card1), r2 = cardRankIndex(card2);
+    int lo = std::min(r1, r2), hi = std::max(r1, r2);
+    bool suited = cardSuitIndex(card1) == cardSuitIndex(card2);
+    return (lo == hi || suited) ? lo * 13 + hi : hi * 13 + lo;
+}
+
+// Highest straight contained in a 13-bit rank mask, as the card value of its
+// top card (5 for the wheel), or 0 when there is none.
+inline int fastStraightHigh(unsigned rankMask) {
+    for (int top = 12; top >= 4; top--) {
+        unsigned run = 0x1Fu << (top - 4);
+        if ((rankMask & run) == run) return top + 2;
+    }
+    // A-2-3-4-5
+    const unsigned wheel = (1u << 12) | 0xFu;
+    if ((rankMask & wheel) == wheel) return 5;
+    return 0;
+}
+
+// Sum of the values of the n highest ranks set in mask, skipping the ranks in
+// excludeMask.
+inline int fastTopValues(unsigned mask, unsigned excludeMask, int n) {
+    int sum = 0;
+    for (int r = 12; r >= 0 && n > 0; r--) {
+        if ((mask & (1u << r)) && !(excludeMask & (1u << r))) {
+            sum += r + 2;
+            n--;
+        }
+    }
+    return sum;
+}
+
+// Score of the best five-card hand out of numCards (5..7) card indices.
+inline int fastHandScore(const int* cards, int numCards) {
+    int counts[13] = {0};
+    unsigned suitMask[4] = {0, 0, 0, 0};
+    unsigned rankMask = 0;
+    for (int i = 0; i < numCards; i++) {
+        int r = cardRankIndex(cards[i]);
+        counts[r]++;
+        suitMask[cardSuitIndex(cards[i])] |= 1u << r;
+        rankMask |= 1u << r;
+    }
+
+    const int SCALE = 1000000;
+
+    int flushSuit = -1;
+    for (int s = 0; s < 4; s++) {
+        if (__builtin_popcount(suitMask[s]) >= 5) flushSuit = s;
+    }
+    if (flushSuit >= 0) {
+        int high = fastStraightHigh(suitMask[flushSuit]);
+        if (high) return 8 * SCALE + high;
+    }
+
+    int quad = -1, trip = -1, secondTrip = -1, pair = -1, secondPair = -1;
+    for (int r = 12; r >= 0; r--) {
+        if (counts[r] == 4 && quad < 0) quad = r;
+        else if (counts[r] == 3) {
+            if (trip < 0) trip = r;
+            else if (secondTrip < 0) secondTrip = r;
+        } else if (counts[r] == 2) {
+            if (pair < 0) pair = r;
+            else if (secondPair < 0) secondPair = r;
+        }
+    }
+
+    if (quad >= 0) {
+        return 7 * SCALE + (quad + 2) + fastTopValues(rankMask, 1u << quad, 1);
+    }
+    if (trip >= 0 && (secondTrip >= 0 || pair >= 0)) {
+        int other = std::max(secondTrip, pair);
+        return 6 * SCALE + (trip + 2) + (other + 2);
+    }
+    if (flushSuit >= 0) {
+        return 5 * SCALE + fastTopValues(suitMask[flushSuit], 0, 5);
+    }
+    int straightHigh = fastStraightHigh(rankMask);
+    if (straightHigh) {
+        return 4 * SCALE + straightHigh;
+    }
+    if (trip >= 0) {
+        return 3 * SCALE + (trip + 2) + fastTopValues(rankMask, 1u << trip, 2);
+    }
+    if (pair >= 0 && secondPair >= 0) {
+        unsigned used = (1u << pair) | (1u << secondPair);
+        return 2 * SCALE + (pair + 2) + (secondPair + 2) + fastTopValues(rankMask, used, 1);
+    }
+    if (pair >= 0) {
+        return 1 * SCALE + (pair + 2) + fastTopValues(rankMask, 1u << pair, 3);
+    }
+    return fastTopValues(rankMask, 0, 5);
+}
+
+// Convenience overload for two hole cards plus a board.
+inline int fastHandScore(int hole1, int hole2, const int* board, int boardSize) {
+    int cards[7];
+    cards[0] = hole1;
+    cards[1] = hole2;
+    for (int i = 0; i < boardSize && i < 5; i++) cards[2 + i] = board[i];
+    return fastHandScore(cards, 2 + (boardSize < 5 ? boardSize : 5));
+}
+
+#endif // SPINGO_FAST_EVAL_CPP
@@ -0,0 +1,192 @@
+/*
+Exhaustive, deterministic enumeration of the infosets of the abstraction.
+
+Sampled discovery (generateScenarios) plays random hands and keeps the keys
+it meets, so lines that random play rarely takes are missed and most of the
+time goes into hands it has already seen. This walks the public tree
+instead: every action sequence legal_actions() allows from the root, once,
+with the board dealt as in vector CFR (publicTreeRoot), since postflop
+legality does not depend on the cards.
+
+A decision's infosets are its public node (publicNodeKey, the infoset key
+without the abstraction) crossed with the acting player's buckets.
+Postflop, every cluster bucket of the round is counted. Preflop the fold
+charts make legality depend on the hand class, so the walk carries the
+classes each player can still hold after their own actions. An action is
+followed if one of the actor's classes may take it, and only those classes
+keep going. Sequences that end in the same public node (keys hold only the
+current round's actions) are counted once. Preflop they contribute the
+union of their classes.
+
+InfosetCensus has the counts per round and seat. A visitor, if given, is
+called once per distinct infoset with a state at its public node and the
+bucket. Preflop that state holds a representative of the class as the
+actor's cards.
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_INFOSET_CENSUS_CPP
+#define SPINGO_INFOSET_CENSUS_CPP
+
+#include "vector_cfr.cpp"
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::bitset<NUM_PREFLOP_CLASSES> PreflopClassSet;
+typedef std::function<void(const SpinGoState& state, int bucket)> InfosetVisitor;
+
+struct InfosetCensus {
+    static const int NUM_ROUNDS = 4;
+
+    uint64_t sequences[NUM_ROUNDS][NUM_PLAYERS] = {};    // decisions of the public tree
+    uint64_t publicNodes[NUM_ROUNDS][NUM_PLAYERS] = {};  // distinct public keys among them
+    uint64_t infosets[NUM_ROUNDS][NUM_PLAYERS] = {};     // public keys x reachable buckets
+    uint64_t terminals = 0;
+    double seconds = 0.0;
+
+    uint64_t totalInfosets() const {
+        uint64_t total = 0;
+        for (int r = 0; r < NUM_ROUNDS; r++) {
+            for (int p = 0; p < NUM_PLAYERS; p++) total += infosets[r][p];
+        }
+        return total;
+    }
+
+    void print(std::ostream& out) const {
+        static const char* const ROUND_NAMES[NUM_ROUNDS] = {"preflop", "flop", "turn", "river"};
+        out << std::left << std::setw(9) << "Round" << std::setw(8) << "Player" << std::right << std::setw(14)
+            << "Sequences" << std::setw(14) << "PublicNodes" << std::setw(16) << "Infosets" << "\n";
+        for (int r = 0; r < NUM_ROUNDS; r++) {
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                out << std::left << std::setw(9) << ROUND_NAMES[r] << std::setw(8) << p << std::right
+                    << std::setw(14) << sequences[r][p] << std::setw(14) << publicNodes[r][p] << std::setw(16)
+                    << infosets[r][p] << "\n";
+            }
+        }
+        out << "Total: " << totalInfosets() << " infosets, " << terminals << " terminal sequences, "
+            << std::fixed << std::setprecision(2) << seconds << " s" << std::endl;
+        out.unsetf(std::ios::fixed);
+    }
+};
+
+class InfosetEnumerator {
+public:
+    // bucketCounts are the buckets of each round (0 preflop .. 3 river);
+    // the preflop count is fixed at NUM_PREFLOP_CLASSES.
+    InfosetEnumerator(const std::array<int, 4>& bucketCounts, InfosetVisitor visit = nullptr)
+        : bucketCounts(bucketCounts), visit(std::move(visit)) {}
+
+    InfosetCensus run() {
+        auto start = std::chrono::steady_clock::now();
+        census = InfosetCensus();
+        preflopSeen.clear();
+        for (auto& seen : postflopSeen) seen.clear();
+
+        const int board[5] = {0, 1, 2, 3, 4};  // any board: postflop legality ignores cards
+        SpinGoState root = publicTreeRoot(board);
+        root.defer_allin_runout = true;
+        std::array<PreflopClassSet, NUM_PLAYERS> classes;
+        for (auto& set : classes) set.set();
+        walk(root, classes);
+
+        census.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return census;
+    }
+
+private:
+    std::array<int, 4> bucketCounts;
+    InfosetVisitor visit;
+    InfosetCensus census;
+    std::unordered_map<std::string, PreflopClassSet> preflopSeen;
+    std::unordered_map<std::string, char> postflopSeen[3];
+
+    void walk(const SpinGoState& state, std::array<PreflopClassSet, NUM_PLAYERS>& classes) {
+        if (state.game_over) {
+            census.terminals++;
+            return;
+        }
+        if (state.is_chance_node()) {
+            SpinGoState next = state;
+            next.apply_action(Action::DEAL);
+            walk(next, classes);
+            return;
+        }
+
+        int player = state.current_player();
+        int r = roundIndex(state.round);
+        if (r > 3 || player < 0) return;
+        census.sequences[r][player]++;
+
+        if (r == 0) {
+            walkPreflop(state, player, classes);
+            return;
+        }
+
+        std::string key = publicNodeKey(state);
+        if (postflopSeen[r - 1].emplace(key, 0).second) {
+            census.publicNodes[r][player]++;
+            census.infosets[r][player] += bucketCounts[r];
+            if (visit) {
+                for (int b = 0; b < bucketCounts[r]; b++) visit(state, b);
+            }
+        }
+        for (Action action : state.legal_actions()) {
+            SpinGoState next = state;
+            next.apply_action(action);
+            walk(next, classes);
+        }
+    }
+
+    // Splits the actor's classes by the actions each may take, records the
+    // classes new to this public node and follows every action some class
+    // may take with just those classes.
+    void walkPreflop(const SpinGoState& state, int player, std::array<PreflopClassSet, NUM_PLAYERS>& classes) {
+        const PreflopClassSet& reaching = classes[player];
+        std::vector<std::pair<Action, PreflopClassSet>> byAction;
+        SpinGoState probe = state;
+        for (int cls = 0; cls < NUM_PREFLOP_CLASSES; cls++) {
+            if (!reaching.test(cls)) continue;
+            preflopClassRepresentative(cls, probe.cards[player * 2], probe.cards[player * 2 + 1]);
+            for (Action action : probe.legal_actions()) {
+                size_t i = 0;
+                while (i < byAction.size() && byAction[i].first != action) i++;
+                if (i == byAction.size()) byAction.emplace_back(action, PreflopClassSet());
+                byAction[i].second.set(cls);
+            }
+        }
+
+        std::string key = publicNodeKey(state);
+        auto inserted = preflopSeen.emplace(key, PreflopClassSet());
+        if (inserted.second) census.publicNodes[0][player]++;
+        PreflopClassSet added = reaching & ~inserted.first->second;
+        inserted.first->second |= reaching;
+        census.infosets[0][player] += added.count();
+        if (visit && added.any()) {
+            for (int cls = 0; cls < NUM_PREFLOP_CLASSES; cls++) {
+                if (!added.test(cls)) continue;
+                preflopClassRepresentative(cls, probe.cards[player * 2], probe.cards[player * 2 + 1]);
+                visit(probe, cls);
+            }
+        }
+
+        PreflopClassSet saved = reaching;
+        for (const auto& entry : byAction) {
+            SpinGoState next = state;
+            next.apply_action(entry.first);
+            classes[player] = entry.second;
+            walk(next, classes);
+        }
+        classes[player] = saved;
+    }
+};
+
+#endif // SPINGO_INFOSET_CENSUS_CPP
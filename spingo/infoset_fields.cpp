@@ -0,0 +1,137 @@
+/*
+Structured fields of an infoset, stored with its node so that exporting the
+strategy does not have to parse the text key back.
+
+These are the columns the strategy CSV shows: round, player, abstraction
+(preflop class or cluster bucket), the current round's action history and
+the pot. They pack into 16 bytes. The history uses 6 bits per action
+(player << 4 | action) in a uint64, which holds ten actions, and the pot is
+kept in tenths of a big blind, rounded the way the CSV prints it.
+
+Infosets whose fields do not fit (longer rounds, larger pots) leave them
+unset, as do nodes read from version-1 checkpoints or created without a
+state. The exporter falls back to parsing the key for those.
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_INFOSET_FIELDS_CPP
+#define SPINGO_INFOSET_FIELDS_CPP
+
+#include "vector_cfr.cpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+struct InfosetFields {
+    static const uint8_t NO_ROUND = 0xFF;
+    static const int MAX_HISTORY = 10;
+
+    uint64_t history = 0;      // action i in bits [6i, 6i + 6)
+    uint16_t potTenths = 0;
+    uint16_t abstraction = 0;  // preflop class (preflopClassIndex) or cluster bucket
+    uint8_t round = NO_ROUND;  // roundIndex(); NO_ROUND = unset
+    uint8_t player = 0;
+    uint8_t historyLength = 0;
+
+    bool valid() const { return round != NO_ROUND; }
+
+    // Fields of the infoset of the player to act at state, or unset ones if
+    // they do not fit.
+    static InfosetFields fromState(const SpinGoState& state, const PostflopBucketFn& bucketFn);
+
+    // The abstraction of the player to act at state (round r < 4): the
+    // preflop class or the postflop bucket.
+    static int abstractionOf(const SpinGoState& state, int r, const PostflopBucketFn& bucketFn);
+
+    // Appends "round,player,abstraction,previousActions" as the CSV has them.
+    void appendLeadingColumns(std::string& out) const;
+
+    // The abstraction column: the preflop class label or the bucket.
+    std::string abstractionLabel() const;
+
+    // Appends the previousActions column, "P2:BET_2|P0:CALL".
+    void appendHistory(std::string& out) const;
+
+    // Appends the pot with one decimal.
+    void appendPot(std::string& out) const;
+};
+
+InfosetFields InfosetFields::fromState(const SpinGoState& state, const PostflopBucketFn& bucketFn) {
+    InfosetFields fields;
+    int r = roundIndex(state.round);
+    int actor = state.current_player();
+    if (r > 3 || actor < 0) return fields;
+
+    // ActionHistory codes are player << 4 | action, the same six bits
+    const ActionHistory& actions = state.action_history;
+    if (actions.round_length() > MAX_HISTORY) return fields;
+    for (int i = 0; i < actions.round_length(); i++) {
+        fields.history |= static_cast<uint64_t>(actions.code(i)) << (6 * fields.historyLength++);
+    }
+
+    double totalPot = 0.0;
+    for (int p = 0; p < NUM_PLAYERS; p++) totalPot += state.pot[p] + state.cumulative_pot[p];
+    char potText[32];
+    std::snprintf(potText, sizeof(potText), "%.1f", totalPot);
+    long tenths = std::lround(std::atof(potText) * 10.0);
+    if (tenths < 0 || tenths > 0xFFFF) return fields;
+    fields.potTenths = static_cast<uint16_t>(tenths);
+
+    int bucket = abstractionOf(state, r, bucketFn);
+    if (bucket < 0 || bucket > 0xFFFF) return fields;
+    fields.abstraction = static_cast<uint16_t>(bucket);
+    fields.player = static_cast<uint8_t>(actor);
+    fields.round = static_cast<uint8_t>(r);
+    return fields;
+}
+
+int InfosetFields::abstractionOf(const SpinGoState& state, int r, const PostflopBucketFn& bucketFn) {
+    int actor = state.current_player();
+    const Card& first = state.cards[actor * 2];
+    const Card& second = state.cards[actor * 2 + 1];
+    int hole1 = cardIndexFromStrings(first.rank, first.suit);
+    int hole2 = cardIndexFromStrings(second.rank, second.suit);
+    if (r == 0) return preflopClassIndex(hole1, hole2);
+    int board[5] = {-1, -1, -1, -1, -1};
+    for (size_t i = 0; i < state.community_cards.size() && i < 5; i++) {
+        board[i] = cardIndexFromStrings(state.community_cards[i].rank, state.community_cards[i].suit);
+    }
+    return bucketFn(r, hole1, hole2, board);
+}
+
+void InfosetFields::appendLeadingColumns(std::string& out) const {
+    static const char* const ROUND_NAMES[4] = {"preflop", "flop", "turn", "river"};
+    out += ROUND_NAMES[round];
+    out += ',';
+    out += static_cast<char>('0' + player);
+    out += ',';
+    out += abstractionLabel();
+    out += ',';
+    appendHistory(out);
+}
+
+std::string InfosetFields::abstractionLabel() const {
+    return round == 0 ? preflopClassLabel(abstraction) : std::to_string(abstraction);
+}
+
+void InfosetFields::appendHistory(std::string& out) const {
+    for (int i = 0; i < historyLength; i++) {
+        int code = static_cast<int>((history >> (6 * i)) & 0x3F);
+        if (i > 0) out += '|';
+        out += 'P';
+        out += static_cast<char>('0' + (code >> 4));
+        out += ':';
+        out += action_to_string(static_cast<Action>(code & 0xF));
+    }
+}
+
+void InfosetFields::appendPot(std::string& out) const {
+    out += std::to_string(potTenths / 10);
+    out += '.';
+    out += static_cast<char>('0' + potTenths % 10);
+}
+
+#endif // SPINGO_INFOSET_FIELDS_CPP
@@ -0,0 +1,245 @@
+/*
+Immutable perfect-hash index of infoset keys, built once from the infosets a
+scenario enumeration reached.
+
+Every key maps to its own slot in [0, slots()), with no collisions and no
+probing: keys are hashed into buckets of about four, and each bucket stores
+the seed that sends all of its keys to free slots (hash and displace, filled
+largest bucket first). A lookup is one hash of the key, a seed read, one
+fingerprint compare and a key compare, so keys that were not enumerated come
+back as -1 instead of a wrong slot. The table is 2% larger than the key
+count.
+
+Each slot also keeps the number of legal actions seen at the infoset, so a
+node table can size the regret arrays of every slot up front (see
+PartitionedNodeTable::useIndex).
+
+Layout of an index file (native endianness):
+    magic "SGINDEX1", uint32 version, uint64 configHash, uint64 numKeys,
+    uint64 numSlots, uint64 numBuckets, numBuckets x uint32 seed,
+    numSlots x uint64 fingerprint, numSlots x uint8 numActions,
+    (numSlots + 1) x uint64 keyOffset, key bytes
+
+configHash is the trainer's abstraction/config hash, as in checkpoints; keys
+built under other clusters are not loaded.
+*/
+
+#ifndef SPINGO_INFOSET_INDEX_CPP
+#define SPINGO_INFOSET_INDEX_CPP
+
+#include "checkpoint.cpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const char INFOSET_INDEX_MAGIC[8] = {'S', 'G', 'I', 'N', 'D', 'E', 'X', '1'};
+static const uint32_t INFOSET_INDEX_VERSION = 1;
+
+class InfosetIndex {
+public:
+    // Builds the index of keys (distinct), each with its number of legal
+    // actions. Fails only if two keys share a 64-bit hash or a bucket cannot
+    // be placed.
+    bool build(const std::vector<std::pair<std::string, uint8_t>>& keys, uint64_t configHash) {
+        config = configHash;
+        numKeys = keys.size();
+        numSlots = numKeys + numKeys / 50 + 1;
+        size_t numBuckets = numKeys / 4 + 1;
+
+        std::vector<uint64_t> hashes(numKeys);
+        std::vector<std::vector<uint32_t>> buckets(numBuckets);
+        for (size_t k = 0; k < numKeys; k++) {
+            hashes[k] = hashKey(keys[k].first);
+            buckets[hashes[k] % numBuckets].push_back(static_cast<uint32_t>(k));
+        }
+        std::vector<uint32_t> order(numBuckets);
+        for (size_t b = 0; b < numBuckets; b++) order[b] = static_cast<uint32_t>(b);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        seeds.assign(numBuckets, 0);
+        std::vector<int64_t> owner(numSlots, -1);
+        std::vector<size_t> placed;
+        for (uint32_t b : order) {
+            const std::vector<uint32_t>& members = buckets[b];
+            if (members.empty()) break;
+            // Keys with equal hashes collide under every seed
+            for (size_t i = 0; i < members.size(); i++) {
+                for (size_t j = i + 1; j < members.size(); j++) {
+                    if (hashes[members[i]] == hashes[members[j]]) {
+                        std::cerr << "Infoset keys with equal hashes: " << keys[members[i]].first << " and "
+                                  << keys[members[j]].first << std::endl;
+                        return false;
+                    }
+                }
+            }
+            uint32_t seed = 0;
+            for (;; seed++) {
+                if (seed == MAX_SEED) {
+                    std::cerr << "Could not place a bucket of " << members.size() << " infoset keys" << std::endl;
+                    return false;
+                }
+                placed.clear();
+                bool free = true;
+                for (uint32_t k : members) {
+                    size_t slot = slotOf(hashes[k], seed);
+                    if (owner[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                        free = false;
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+                if (free) break;
+            }
+            seeds[b] = seed;
+            for (size_t i = 0; i < members.size(); i++) owner[placed[i]] = members[i];
+        }
+
+        fingerprints.assign(numSlots, 0);
+        actionCounts.assign(numSlots, 0);
+        keyOffsets.assign(numSlots + 1, 0);
+        keyData.clear();
+        for (size_t slot = 0; slot < numSlots; slot++) {
+            keyOffsets[slot] = keyData.size();
+            if (owner[slot] < 0) continue;
+            const auto& key = keys[owner[slot]];
+            fingerprints[slot] = hashes[owner[slot]];
+            actionCounts[slot] = key.second;
+            keyData += key.first;
+        }
+        keyOffsets[numSlots] = keyData.size();
+        return true;
+    }
+
+    // The slot of key, or -1 if it was not indexed.
+    int64_t find(const std::string& key) const {
+        if (numSlots == 0) return -1;
+        uint64_t hash = hashKey(key);
+        size_t slot = slotOf(hash, seeds[hash % seeds.size()]);
+        if (fingerprints[slot] != hash) return -1;
+        uint64_t length = keyOffsets[slot + 1] - keyOffsets[slot];
+        if (length != key.size() || std::memcmp(keyData.data() + keyOffsets[slot], key.data(), length) != 0) {
+            return -1;
+        }
+        return static_cast<int64_t>(slot);
+    }
+
+    size_t size() const { return numKeys; }
+    size_t slots() const { return numSlots; }
+    uint64_t configHash() const { return config; }
+
+    // Whether slot holds a key; the others are the 2% slack.
+    bool used(size_t slot) const { return keyOffsets[slot + 1] > keyOffsets[slot]; }
+    int numActions(size_t slot) const { return actionCounts[slot]; }
+
+    void key(size_t slot, std::string& out) const {
+        out.assign(keyData, keyOffsets[slot], keyOffsets[slot + 1] - keyOffsets[slot]);
+    }
+
+    // Approximate RAM held by the index itself.
+    uint64_t bytes() const {
+        return seeds.size() * sizeof(uint32_t) + numSlots * (sizeof(uint64_t) * 2 + 1) + keyData.size();
+    }
+
+    bool save(const std::string& filename) const {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Unable to write infoset index: " << filename << std::endl;
+            return false;
+        }
+        out.write(INFOSET_INDEX_MAGIC, sizeof(INFOSET_INDEX_MAGIC));
+        writePod(out, INFOSET_INDEX_VERSION);
+        writePod<uint64_t>(out, config);
+        writePod<uint64_t>(out, numKeys);
+        writePod<uint64_t>(out, numSlots);
+        writePod<uint64_t>(out, seeds.size());
+        writeArray(out, seeds);
+        writeArray(out, fingerprints);
+        writeArray(out, actionCounts);
+        writeArray(out, keyOffsets);
+        out.write(keyData.data(), keyData.size());
+        out.close();
+        if (!out) {
+            std::cerr << "Error writing infoset index: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << "Unable to open infoset index: " << filename << std::endl;
+            return false;
+        }
+        char magic[sizeof(INFOSET_INDEX_MAGIC)];
+        uint32_t version = 0;
+        uint64_t numBuckets = 0;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, INFOSET_INDEX_MAGIC, sizeof(magic)) != 0
+            || !readPod(in, version) || version != INFOSET_INDEX_VERSION) {
+            std::cerr << filename << " is not an infoset index" << std::endl;
+            return false;
+        }
+        uint64_t keys = 0, slots = 0;
+        bool ok = readPod(in, config) && readPod(in, keys) && readPod(in, slots) && readPod(in, numBuckets)
+               && numBuckets > 0 && readArray(in, seeds, numBuckets) && readArray(in, fingerprints, slots)
+               && readArray(in, actionCounts, slots) && readArray(in, keyOffsets, slots + 1);
+        if (ok) {
+            keyData.resize(keyOffsets.back());
+            ok = keyData.empty() || static_cast<bool>(in.read(&keyData[0], keyData.size()));
+        }
+        if (!ok) {
+            std::cerr << "Truncated infoset index: " << filename << std::endl;
+            return false;
+        }
+        numKeys = keys;
+        numSlots = slots;
+        return true;
+    }
+
+private:
+    static const uint32_t MAX_SEED = 1u << 24;
+
+    uint64_t config = 0;
+    size_t numKeys = 0;
+    size_t numSlots = 0;
+    std::vector<uint32_t> seeds;         // per bucket
+    std::vector<uint64_t> fingerprints;  // per slot, the key's hash
+    std::vector<uint8_t> actionCounts;   // per slot
+    std::vector<uint64_t> keyOffsets;    // per slot, into keyData
+    std::string keyData;
+
+    // Stable across builds and platforms, unlike std::hash.
+    static uint64_t hashKey(const std::string& key) { return mix(fnv1a64(key)); }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    size_t slotOf(uint64_t hash, uint32_t seed) const {
+        return static_cast<size_t>(mix(hash + (seed + 1) * 0x9E3779B97F4A7C15ULL) % numSlots);
+    }
+
+    template <typename T>
+    static void writeArray(std::ostream& out, const std::vector<T>& values) {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    static bool readArray(std::istream& in, std::vector<T>& values, uint64_t count) {
+        values.resize(count);
+        return count == 0 || static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T)));
+    }
+};
+
+#endif // SPINGO_INFOSET_INDEX_CPP
@@ -0,0 +1,193 @@
+/*
+Index of the infoset table by public action sequence.
+
+MCCFR finds the node of every decision it visits by building the text key
+and hashing it, although along one traversal the next decision follows from
+the current one and the action taken. The trie has one node per public
+action sequence (every action and deal since the start of the hand),
+reached from its parent through a child pointer per action. Each trie node
+holds a dense array indexed by the acting player's bucket (preflop class or
+postflop cluster), and each entry points at that infoset's node in the
+table, together with the partition whose lock guards it. A traversal
+carries its trie node down the recursion, so revisiting an infoset costs a
+child-pointer step and a bucket lookup instead of a key.
+
+The first visit of a (sequence, bucket) pair still builds the key and finds
+or creates the node in the table; only then is the entry filled. Several
+sequences can lead to the same key (keys hold only the current round's
+actions), and their entries point at the same node. The nodes stay in the
+table, so checkpoints, snapshots, export and evaluation read them as
+before; the trie holds no regrets of its own.
+
+Reads take no locks: children and entries are published through atomic
+pointers, and a thread that loses the race to create one frees its copy.
+Entries stay valid as long as table nodes do not move, which holds for
+PartitionedNodeTable without a cold tier, so the trainers leave the trie
+off with --ram-budget.
+
+forEachEntry() lists the infosets of one public node and forEach() walks
+the whole trie, for export or analysis by public node.
+
+Include after spingo/infoset_fields.cpp and spingo/node_table.cpp.
+*/
+
+#ifndef SPINGO_INFOSET_TRIE_CPP
+#define SPINGO_INFOSET_TRIE_CPP
+
+#include "infoset_fields.cpp"
+#include "node_table.cpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+template <typename TableT>
+class InfosetTrie {
+public:
+    using NodeT = typename TableT::mapped_type;
+    using Partition = typename TableT::Partition;
+
+    static const int NUM_EDGES = 16;  // every Action value, DEAL included
+
+    // Where the node of one infoset lives; node is nullptr until the first
+    // visit has found it in the table.
+    struct Entry {
+        std::atomic<NodeT*> node{nullptr};
+        std::atomic<Partition*> partition{nullptr};
+    };
+
+    struct Entries {
+        explicit Entries(int size) : size(size), slots(new Entry[size]) {}
+        int size;
+        std::unique_ptr<Entry[]> slots;
+    };
+
+    struct PublicNode {
+        std::atomic<PublicNode*> children[NUM_EDGES];
+        std::atomic<Entries*> entries{nullptr};  // allocated by the first decision made here
+
+        PublicNode() {
+            for (auto& child : children) child.store(nullptr, std::memory_order_relaxed);
+        }
+        ~PublicNode() {
+            for (auto& child : children) delete child.load(std::memory_order_relaxed);
+            delete entries.load(std::memory_order_relaxed);
+        }
+        PublicNode(const PublicNode&) = delete;
+        PublicNode& operator=(const PublicNode&) = delete;
+    };
+
+    struct Stats {
+        uint64_t publicNodes = 0;
+        uint64_t entryArrays = 0;
+        uint64_t filledEntries = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Turns the trie on. bucketCounts are the number of buckets of each
+    // round (0 preflop .. 3 river); infosets in higher buckets are looked up
+    // by key every time.
+    void enable(PostflopBucketFn fn, const std::array<int, 4>& counts) {
+        bucketFn = std::move(fn);
+        bucketCounts = counts;
+        on = true;
+    }
+
+    bool enabled() const { return on; }
+
+    // The node of the public sequence every hand starts from, or nullptr
+    // when the trie is off.
+    PublicNode* root() { return on ? &rootNode : nullptr; }
+
+    // The node after taking action at parent, created on first use; nullptr
+    // if parent is.
+    PublicNode* child(PublicNode* parent, Action action) {
+        if (!parent) return nullptr;
+        std::atomic<PublicNode*>& slot = parent->children[static_cast<int>(action) & (NUM_EDGES - 1)];
+        PublicNode* existing = slot.load(std::memory_order_acquire);
+        if (existing) return existing;
+        PublicNode* created = new PublicNode();
+        if (slot.compare_exchange_strong(existing, created, std::memory_order_acq_rel)) {
+            publicNodes.fetch_add(1, std::memory_order_relaxed);
+            return created;
+        }
+        delete created;
+        return existing;
+    }
+
+    // The entry of the infoset of the player to act at state, whose public
+    // sequence is at; nullptr if at is or the bucket is out of range.
+    Entry* entry(PublicNode* at, const SpinGoState& state) {
+        if (!at) return nullptr;
+        int r = roundIndex(state.round);
+        if (r > 3) return nullptr;
+        int bucket = InfosetFields::abstractionOf(state, r, bucketFn);
+        if (bucket < 0 || bucket >= bucketCounts[r]) return nullptr;
+        Entries* entries = at->entries.load(std::memory_order_acquire);
+        if (!entries) {
+            Entries* created = new Entries(bucketCounts[r]);
+            if (at->entries.compare_exchange_strong(entries, created, std::memory_order_acq_rel)) {
+                entryArrays.fetch_add(1, std::memory_order_relaxed);
+                entrySlots.fetch_add(created->size, std::memory_order_relaxed);
+                entries = created;
+            } else {
+                delete created;
+            }
+        }
+        return &entries->slots[bucket];
+    }
+
+    // Records where the entry's infoset lives. The caller holds partition's
+    // lock, so racing threads store the same node.
+    void fill(Entry* entry, Partition& partition, NodeT* node) {
+        entry->partition.store(&partition, std::memory_order_relaxed);
+        if (entry->node.exchange(node, std::memory_order_release) == nullptr) {
+            filledEntries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Calls fn(bucket, node) for every filled entry of one public node.
+    // Reading the nodes needs their partition locks or a paused trainer.
+    void forEachEntry(const PublicNode& node, const std::function<void(int, NodeT&)>& fn) const {
+        const Entries* entries = node.entries.load(std::memory_order_acquire);
+        if (!entries) return;
+        for (int b = 0; b < entries->size; b++) {
+            if (NodeT* n = entries->slots[b].node.load(std::memory_order_acquire)) fn(b, *n);
+        }
+    }
+
+    // Calls fn(node, depth) for every public node, parents first.
+    void forEach(const std::function<void(const PublicNode&, int)>& fn) const {
+        if (on) walk(rootNode, 0, fn);
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.publicNodes = publicNodes.load(std::memory_order_relaxed) + (on ? 1 : 0);
+        s.entryArrays = entryArrays.load(std::memory_order_relaxed);
+        s.filledEntries = filledEntries.load(std::memory_order_relaxed);
+        s.bytes = s.publicNodes * sizeof(PublicNode) + s.entryArrays * sizeof(Entries)
+                + entrySlots.load(std::memory_order_relaxed) * sizeof(Entry);
+        return s;
+    }
+
+private:
+    bool on = false;
+    PostflopBucketFn bucketFn;
+    std::array<int, 4> bucketCounts = {{0, 0, 0, 0}};
+    PublicNode rootNode;
+    std::atomic<uint64_t> publicNodes{0};
+    std::atomic<uint64_t> entryArrays{0};
+    std::atomic<uint64_t> entrySlots{0};
+    std::atomic<uint64_t> filledEntries{0};
+
+    static void walk(const PublicNode& node, int depth, const std::function<void(const PublicNode&, int)>& fn) {
+        fn(node, depth);
+        for (const auto& child : node.children) {
+            if (const PublicNode* c = child.load(std::memory_order_acquire)) walk(*c, depth + 1, fn);
+        }
+    }
+};
+
+#endif // SPINGO_INFOSET_TRIE_CPP
@@ -0,0 +1,221 @@
+/*
+Low-overhead training telemetry.
+
+Every thread that records metrics gets its own cache-line aligned block of
+counters (registered on first use), so the hot path is a relaxed increment on
+memory no other thread writes. A reporter thread periodically sums the blocks
+and emits either
+
+- JSON lines appended to a file (one object per interval), or
+- a Prometheus text-format file, rewritten atomically, for a node-exporter
+  style textfile scraper.
+
+Counters: iterations, nodes touched, terminal evaluations, new infosets,
+time spent waiting for contended locks, and bytes allocated for infosets.
+The reporter adds rates per second, an infoset-count gauge and any other
+gauges supplied by the trainer, and the process resident set size.
+*/
+
+#ifndef SPINGO_METRICS_CPP
+#define SPINGO_METRICS_CPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+enum MetricCounter {
+    METRIC_ITERATIONS = 0,
+    METRIC_NODES_TOUCHED,
+    METRIC_TERMINAL_EVALS,
+    METRIC_NEW_INFOSETS,
+    METRIC_LOCK_WAIT_NS,
+    METRIC_BYTES_ALLOCATED,
+    METRIC_COUNT
+};
+
+static const char* const METRIC_NAMES[METRIC_COUNT] = {
+    "iterations", "nodes_touched", "terminal_evals", "new_infosets", "lock_wait_ns", "bytes_allocated"};
+
+struct alignas(64) ThreadMetrics {
+    std::atomic<uint64_t> counters[METRIC_COUNT];
+    ThreadMetrics() {
+        for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    }
+};
+
+class MetricsRegistry {
+public:
+    ThreadMetrics& local() {
+        thread_local ThreadMetrics* mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            blocks.push_back(std::unique_ptr<ThreadMetrics>(new ThreadMetrics()));
+            mine = blocks.back().get();
+        }
+        return *mine;
+    }
+
+    std::vector<uint64_t> totals() {
+        std::vector<uint64_t> sum(METRIC_COUNT, 0);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& block : blocks) {
+            for (int i = 0; i < METRIC_COUNT; i++) sum[i] += block->counters[i].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    // Blocks are never freed so counts from finished threads are kept
+    std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+    std::mutex registryMutex;
+};
+
+inline MetricsRegistry& metricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+inline void metricAdd(MetricCounter counter, uint64_t amount = 1) {
+    metricsRegistry().local().counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+// Locks m, timing the wait only when the lock is contended.
+inline std::unique_lock<std::mutex> metricsLock(std::mutex& m) {
+    std::unique_lock<std::mutex> lock(m, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        metricAdd(METRIC_LOCK_WAIT_NS, waited.count());
+    }
+    return lock;
+}
+
+inline uint64_t residentSetBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+class MetricsReporter {
+public:
+    using Gauges = std::vector<std::pair<std::string, double>>;
+
+    // format is "json" (JSON lines appended to path) or "prometheus" (path
+    // rewritten each interval). infosetCount and gauges are sampled on every
+    // report; gauge names become JSON fields or spingo_<name> metrics.
+    MetricsReporter(const std::string& path, const std::string& format, double intervalSeconds,
+                    std::function<size_t()> infosetCount = nullptr, std::function<Gauges()> gauges = nullptr)
+        : path(path), prometheus(format == "prometheus" || format == "prom"),
+          interval(intervalSeconds > 0 ? intervalSeconds : 10.0), infosetCount(infosetCount), gauges(gauges),
+          stopping(false) {
+        start = std::chrono::steady_clock::now();
+        last = start;
+        lastTotals = metricsRegistry().totals();
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~MetricsReporter() { stop(); }
+
+    // Stops the reporter after writing one final report.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        stopCondition.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    std::string path;
+    bool prometheus;
+    double interval;
+    std::function<size_t()> infosetCount;
+    std::function<Gauges()> gauges;
+    std::chrono::steady_clock::time_point start, last;
+    std::vector<uint64_t> lastTotals;
+    bool stopping;
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    std::thread worker;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(stopMutex);
+        while (!stopping) {
+            stopCondition.wait_for(lock, std::chrono::duration<double>(interval), [this]() { return stopping; });
+            lock.unlock();
+            report();
+            lock.lock();
+        }
+    }
+
+    void report() {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        double window = std::chrono::duration<double>(now - last).count();
+        std::vector<uint64_t> totals = metricsRegistry().totals();
+        double iterationsPerSec = window > 0 ? (totals[METRIC_ITERATIONS] - lastTotals[METRIC_ITERATIONS]) / window : 0.0;
+        double nodesPerSec = window > 0 ? (totals[METRIC_NODES_TOUCHED] - lastTotals[METRIC_NODES_TOUCHED]) / window : 0.0;
+        size_t infosets = infosetCount ? infosetCount() : 0;
+        uint64_t rss = residentSetBytes();
+        Gauges extra = gauges ? gauges() : Gauges();
+        last = now;
+        lastTotals = totals;
+
+        if (prometheus) {
+            std::ostringstream out;
+            for (int i = 0; i < METRIC_COUNT; i++) {
+                out << "# TYPE spingo_" << METRIC_NAMES[i] << "_total counter\n"
+                    << "spingo_" << METRIC_NAMES[i] << "_total " << totals[i] << "\n";
+            }
+            out << "# TYPE spingo_iterations_per_second gauge\nspingo_iterations_per_second " << iterationsPerSec << "\n"
+                << "# TYPE spingo_nodes_per_second gauge\nspingo_nodes_per_second " << nodesPerSec << "\n"
+                << "# TYPE spingo_infosets gauge\nspingo_infosets " << infosets << "\n"
+                << "# TYPE spingo_resident_bytes gauge\nspingo_resident_bytes " << rss << "\n"
+                << "# TYPE spingo_elapsed_seconds gauge\nspingo_elapsed_seconds " << elapsed << "\n";
+            for (const auto& gauge : extra) {
+                out << "# TYPE spingo_" << gauge.first << " gauge\nspingo_" << gauge.first << " " << gauge.second << "\n";
+            }
+            std::string tmp = path + ".tmp";
+            {
+                std::ofstream file(tmp, std::ios::trunc);
+                file << out.str();
+            }
+            std::rename(tmp.c_str(), path.c_str());
+        } else {
+            std::ofstream file(path, std::ios::app);
+            file << std::fixed << std::setprecision(3)
+                 << "{\"elapsed_s\":" << elapsed
+                 << ",\"iterations_per_sec\":" << iterationsPerSec
+                 << ",\"nodes_per_sec\":" << nodesPerSec
+                 << ",\"infosets\":" << infosets
+                 << ",\"rss_bytes\":" << rss;
+            for (int i = 0; i < METRIC_COUNT; i++) {
+                file << ",\"" << METRIC_NAMES[i] << "\":" << totals[i];
+            }
+            for (const auto& gauge : extra) {
+                file << ",\"" << gauge.first << "\":" << gauge.second;
+            }
+            file << "}\n";
+        }
+    }
+};
+
+#endif // SPINGO_METRICS_CPP
@@ -0,0 +1,636 @@
+/*
+Infoset table split into independently locked partitions by key hash.
+
+Each partition is its own unordered_map with its own lock, so threads that
+touch different partitions never contend. With a NUMA layout every partition
+also gets a NumaArena, and the map's buckets and entries plus the vectors of
+the nodes stored in it are allocated there:
+
+- NUMA_LAYOUT_NONE         plain heap allocations (the default)
+- NUMA_LAYOUT_INTERLEAVE   every partition's pages interleaved over all nodes
+- NUMA_LAYOUT_PARTITIONED  partition p lives on node p % nodes
+
+Node types opt into arena placement by using NodeVector for their arrays.
+NodeAllocator picks up the arena of the partition that is inserting (set by
+NumaArenaScope), while copies made outside the table, like the trainers'
+local working nodes, stay on the ordinary heap. Keys are plain std::string
+and stay on the heap.
+
+With a cold tier (enableColdTier) the table is memory-bounded: each
+partition keeps its share of a RAM budget of nodes in its map and evicts
+the rest, chosen by CLOCK so recently used nodes stay, to a memory-mapped
+ColdStore (spingo/cold_store.cpp). Lookups page evicted nodes back in.
+stats() reports hit rate, evictions and the size of both tiers.
+
+With an InfosetIndex (useIndex) every indexed key has a preallocated node,
+its arrays sized up front, in one flat array addressed by the key's
+perfect-hash slot; the partition maps then only hold the overflow, keys the
+index lacks, and stats() counts them. Indexed nodes are guarded by the lock
+of their key's partition like the others, stay on the ordinary heap, and
+cannot be combined with a cold tier.
+
+Iteration (begin/end) walks the indexed slots and then every partition, hot
+entries and then cold ones, and takes no locks; it is for code that runs while no worker is updating
+the table. forEachInShard() splits the same walk for parallel readers.
+*/
+
+#ifndef SPINGO_NODE_TABLE_CPP
+#define SPINGO_NODE_TABLE_CPP
+
+#include "checkpoint.cpp"
+#include "cold_store.cpp"
+#include "infoset_index.cpp"
+#include "numa.cpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum NumaLayout {
+    NUMA_LAYOUT_NONE,
+    NUMA_LAYOUT_INTERLEAVE,
+    NUMA_LAYOUT_PARTITIONED
+};
+
+inline const char* numaLayoutName(NumaLayout layout) {
+    switch (layout) {
+    case NUMA_LAYOUT_INTERLEAVE: return "interleave";
+    case NUMA_LAYOUT_PARTITIONED: return "partitioned";
+    default: return "none";
+    }
+}
+
+inline bool parseNumaLayout(const std::string& name, NumaLayout& layout) {
+    if (name == "none") layout = NUMA_LAYOUT_NONE;
+    else if (name == "interleave") layout = NUMA_LAYOUT_INTERLEAVE;
+    else if (name == "partitioned") layout = NUMA_LAYOUT_PARTITIONED;
+    else return false;
+    return true;
+}
+
+// Arena that NodeAllocator uses for containers created on this thread.
+inline NumaArena*& currentNumaArena() {
+    thread_local NumaArena* arena = nullptr;
+    return arena;
+}
+
+// Makes arena the current one for the lifetime of the scope.
+class NumaArenaScope {
+public:
+    explicit NumaArenaScope(NumaArena* arena) : previous(currentNumaArena()) { currentNumaArena() = arena; }
+    ~NumaArenaScope() { currentNumaArena() = previous; }
+    NumaArenaScope(const NumaArenaScope&) = delete;
+    NumaArenaScope& operator=(const NumaArenaScope&) = delete;
+
+private:
+    NumaArena* previous;
+};
+
+// Allocator that remembers the arena current when the container was created
+// (nullptr = heap). Copies of a container pick the arena current at the time
+// of the copy instead of inheriting the source's.
+template <typename T>
+class NodeAllocator {
+public:
+    using value_type = T;
+
+    NodeAllocator() : arena(currentNumaArena()) {}
+    explicit NodeAllocator(NumaArena* arena) : arena(arena) {}
+    template <typename U>
+    NodeAllocator(const NodeAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (!arena) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (!arena) ::operator delete(p);
+        else arena->deallocate(p, n * sizeof(T));
+    }
+
+    NodeAllocator select_on_container_copy_construction() const { return NodeAllocator(); }
+
+    template <typename U>
+    bool operator==(const NodeAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const NodeAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U>
+    friend class NodeAllocator;
+    NumaArena* arena;
+};
+
+template <typename T>
+using NodeVector = std::vector<T, NodeAllocator<T>>;
+
+// Cold-tier encoding of a node, the body of a checkpoint node record without
+// the fields length: uint32 numActions, numActions x uint8 action,
+// numActions x double regretSum, numActions x double strategySum,
+// int32 strategyUpdateCount, the node's fields bytes.
+template <typename NodeT>
+void encodeNode(const NodeT& node, std::string& out) {
+    uint32_t numActions = static_cast<uint32_t>(node.regretSum.size());
+    int32_t updateCount = node.strategyUpdateCount;
+    out.resize(4 + numActions * (1 + 2 * sizeof(double)) + 4 + NodeFields<NodeT>::size);
+    char* p = &out[0];
+    std::memcpy(p, &numActions, 4);
+    p += 4;
+    for (uint32_t a = 0; a < numActions; a++) *p++ = a < node.actions.size() ? static_cast<char>(node.actions[a]) : 0;
+    std::memcpy(p, node.regretSum.data(), numActions * sizeof(double));
+    p += numActions * sizeof(double);
+    for (uint32_t a = 0; a < numActions; a++, p += sizeof(double)) {
+        double value = a < node.strategySum.size() ? node.strategySum[a] : 0.0;
+        std::memcpy(p, &value, sizeof(double));
+    }
+    std::memcpy(p, &updateCount, 4);
+    NodeFields<NodeT>::write(node, p + 4);
+}
+
+template <typename NodeT>
+void decodeNode(const char* data, NodeT& node) {
+    uint32_t numActions;
+    int32_t updateCount;
+    std::memcpy(&numActions, data, 4);
+    data += 4;
+    node = NodeT(static_cast<int>(numActions));
+    node.actions.resize(numActions);
+    for (uint32_t a = 0; a < numActions; a++) {
+        node.actions[a] = static_cast<typename decltype(node.actions)::value_type>(static_cast<uint8_t>(*data++));
+    }
+    std::memcpy(node.regretSum.data(), data, numActions * sizeof(double));
+    data += numActions * sizeof(double);
+    std::memcpy(node.strategySum.data(), data, numActions * sizeof(double));
+    data += numActions * sizeof(double);
+    std::memcpy(&updateCount, data, 4);
+    node.strategyUpdateCount = updateCount;
+    NodeFields<NodeT>::read(node, data + 4);
+}
+
+// Counters of one table, summed over partitions by stats().
+struct NodeTableStats {
+    uint64_t hotHits = 0;      // lookups served from RAM
+    uint64_t coldHits = 0;     // lookups that paged a node back in
+    uint64_t misses = 0;       // lookups of keys in neither tier
+    uint64_t evictions = 0;    // nodes written out to the cold tier
+    uint64_t hotEntries = 0;
+    uint64_t coldEntries = 0;
+    uint64_t hotBytes = 0;     // estimated RAM held by hot entries
+    uint64_t coldBytes = 0;    // live bytes in the cold files
+    uint64_t compactions = 0;
+    uint64_t indexSlots = 0;       // slots of the InfosetIndex, 0 without one
+    uint64_t indexedEntries = 0;   // nodes stored in those slots
+    uint64_t overflowEntries = 0;  // with an index, nodes of keys it lacks
+
+    // Nodes in the table, as size() counts them.
+    uint64_t entries() const { return hotEntries + coldEntries + indexedEntries; }
+
+    double hitRate() const {
+        uint64_t found = hotHits + coldHits;
+        return found > 0 ? static_cast<double>(hotHits) / found : 1.0;
+    }
+};
+
+template <typename NodeT>
+class PartitionedNodeTable {
+public:
+    using key_type = std::string;
+    using mapped_type = NodeT;
+
+    // With a cold tier, referenced is the CLOCK bit used to pick victims.
+    struct Slot {
+        NodeT node;
+        bool referenced;
+        explicit Slot(const NodeT& node) : node(node), referenced(true) {}
+    };
+
+    using Map = std::unordered_map<std::string, Slot, std::hash<std::string>, std::equal_to<std::string>,
+                                   NodeAllocator<std::pair<const std::string, Slot>>>;
+
+    // Preallocated nodes of the keys of an index, one per slot. filled[s]
+    // is written under the lock of the partition of slot s's key.
+    struct IndexedTier {
+        std::shared_ptr<const InfosetIndex> index;
+        std::vector<NodeT> nodes;
+        std::vector<uint8_t> filled;
+    };
+
+    // Every method expects the caller to hold mutex. Returned pointers and
+    // references stay valid until the next call on the same partition, which
+    // may evict the node.
+    struct alignas(64) Partition {
+        std::mutex mutex;
+        std::unique_ptr<NumaArena> arena;
+        Map map;
+        std::unique_ptr<ColdStore> cold;  // nullptr = everything stays in RAM
+        std::string coldPath;
+        uint64_t budgetBytes = 0;
+        uint64_t hotBytes = 0;
+        size_t clockHand = 0;
+        NodeTableStats counters;
+        std::string scratch;
+        IndexedTier* indexed = nullptr;  // shared by all partitions
+        size_t indexedCount = 0;         // indexed nodes filled through this partition
+
+        explicit Partition(NumaArena* arena)
+            : arena(arena), map(0, std::hash<std::string>(), std::equal_to<std::string>(),
+                                NodeAllocator<std::pair<const std::string, Slot>>(arena)) {}
+
+        // The node for key, paged back in if it was evicted; nullptr if absent.
+        NodeT* find(const std::string& key) {
+            if (indexed) {
+                int64_t slot = indexed->index->find(key);
+                if (slot >= 0) return indexed->filled[slot] ? &indexed->nodes[slot] : nullptr;
+            }
+            return findInMap(key);
+        }
+
+        // Inserts or overwrites key with a copy of node placed in its
+        // indexed slot or in this partition's arena.
+        NodeT& store(const std::string& key, const NodeT& node) {
+            int64_t slot = indexed ? indexed->index->find(key) : -1;
+            if (slot >= 0) {
+                if (!indexed->filled[slot]) {
+                    indexed->filled[slot] = 1;
+                    indexedCount++;
+                }
+                indexed->nodes[slot] = node;
+                return indexed->nodes[slot];
+            }
+            if (NodeT* existing = findInMap(key)) {
+                NumaArenaScope scope(arena.get());
+                *existing = node;
+                return *existing;
+            }
+            return insert(key, node);
+        }
+
+        // The node for key, default-constructed if absent (like operator[]).
+        NodeT& get(const std::string& key) {
+            if (NodeT* existing = find(key)) return *existing;
+            return store(key, NodeT());
+        }
+
+        size_t size() const { return map.size() + (cold ? cold->size() : 0) + indexedCount; }
+
+        void clear() {
+            map.clear();
+            hotBytes = 0;
+            indexedCount = 0;
+            if (cold) {
+                cold.reset(new ColdStore());
+                cold->open(coldPath);
+            }
+        }
+
+    private:
+        NodeT* findInMap(const std::string& key) {
+            auto it = map.find(key);
+            if (it != map.end()) {
+                if (cold) {
+                    it->second.referenced = true;
+                    counters.hotHits++;
+                }
+                return &it->second.node;
+            }
+            if (!cold) return nullptr;
+            if (!cold->take(key, scratch)) {
+                counters.misses++;
+                return nullptr;
+            }
+            counters.coldHits++;
+            NodeT node;
+            decodeNode(scratch.data(), node);
+            return &insert(key, node);
+        }
+
+        NodeT& insert(const std::string& key, const NodeT& node) {
+            // Evict first so the new entry is never its own victim
+            while (cold && hotBytes > budgetBytes && !map.empty()) evictOne();
+            NumaArenaScope scope(arena.get());
+            auto& entry = *map.emplace(key, Slot(node)).first;
+            hotBytes += footprint(entry.first, entry.second.node);
+            return entry.second.node;
+        }
+
+        // CLOCK over the buckets: referenced entries get a second chance.
+        void evictOne() {
+            size_t buckets = map.bucket_count();
+            for (size_t swept = 0; swept <= 2 * buckets; swept++) {
+                size_t bucket = clockHand++ % buckets;
+                for (auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+                    if (it->second.referenced) {
+                        it->second.referenced = false;
+                        continue;
+                    }
+                    std::string key = it->first;
+                    encodeNode(it->second.node, scratch);
+                    cold->put(key, scratch.data(), static_cast<uint32_t>(scratch.size()));
+                    hotBytes -= std::min<uint64_t>(hotBytes, footprint(key, it->second.node));
+                    map.erase(key);
+                    counters.evictions++;
+                    return;
+                }
+            }
+        }
+
+        static uint64_t footprint(const std::string& key, const NodeT& node) {
+            const uint64_t entryOverhead = sizeof(typename Map::value_type) + 2 * sizeof(void*);
+            uint64_t keyBytes = key.capacity() > 15 ? key.capacity() + 1 : 0;
+            return entryOverhead + keyBytes
+                 + (node.regretSum.capacity() + node.strategy.capacity() + node.strategySum.capacity()) * sizeof(double)
+                 + node.actions.capacity() * sizeof(typename decltype(node.actions)::value_type);
+        }
+    };
+
+    explicit PartitionedNodeTable(int partitions = 1, NumaLayout layout = NUMA_LAYOUT_NONE) {
+        configure(partitions, layout);
+    }
+
+    // Re-creates the (empty) partitions. Returns false if the table has entries.
+    bool configure(int partitions, NumaLayout layout) {
+        if (!parts.empty() && size() > 0) return false;
+        this->layout = layout;
+        parts.clear();
+        partitions = std::max(1, partitions);
+        for (int p = 0; p < partitions; p++) {
+            NumaArena* arena = nullptr;
+            if (layout == NUMA_LAYOUT_INTERLEAVE) arena = new NumaArena(NUMA_POLICY_INTERLEAVE, 0);
+            else if (layout == NUMA_LAYOUT_PARTITIONED) arena = new NumaArena(NUMA_POLICY_PREFERRED, nodeOf(p));
+            parts.emplace_back(new Partition(arena));
+            parts.back()->indexed = indexed.get();
+        }
+        return true;
+    }
+
+    // Gives every key of index a preallocated node whose arrays have the
+    // key's number of actions, so storing it later copies into place. Keys
+    // outside the index go to the partition maps. Call after configure(),
+    // while empty and without a cold tier.
+    bool useIndex(std::shared_ptr<const InfosetIndex> index) {
+        if (size() > 0 || hasColdTier()) return false;
+        indexed.reset(new IndexedTier());
+        indexed->index = std::move(index);
+        size_t slots = indexed->index->slots();
+        indexed->nodes.reserve(slots);
+        for (size_t s = 0; s < slots; s++) {
+            int numActions = indexed->index->numActions(s);
+            indexed->nodes.emplace_back(numActions);
+            indexed->nodes.back().actions.resize(numActions);
+        }
+        indexed->filled.assign(slots, 0);
+        for (auto& part : parts) part->indexed = indexed.get();
+        return true;
+    }
+
+    bool hasIndex() const { return indexed != nullptr; }
+
+    // Keeps at most budgetBytes of nodes in RAM (split evenly over the
+    // partitions) and evicts the rest to memory-mapped files named
+    // pathPrefix.p<partition>.<n>. Call after configure(), while empty.
+    bool enableColdTier(const std::string& pathPrefix, uint64_t budgetBytes) {
+        if (size() > 0) return false;
+        for (size_t p = 0; p < parts.size(); p++) {
+            Partition& part = *parts[p];
+            part.coldPath = pathPrefix + ".p" + std::to_string(p);
+            part.cold.reset(new ColdStore());
+            if (!part.cold->open(part.coldPath)) {
+                for (auto& undo : parts) undo->cold.reset();
+                return false;
+            }
+            part.budgetBytes = budgetBytes / parts.size();
+        }
+        return true;
+    }
+
+    bool hasColdTier() const { return !parts.empty() && parts[0]->cold != nullptr; }
+
+    int numPartitions() const { return static_cast<int>(parts.size()); }
+    NumaLayout numaLayout() const { return layout; }
+
+    // Node index a partition's memory is placed on (partitioned layout).
+    int nodeOf(int partition) const { return partition % NumaTopology::get().numNodes(); }
+
+    size_t partitionIndex(const std::string& key) const {
+        if (parts.size() == 1) return 0;
+        // High bits, so the choice is independent of the bucket within the map
+        uint64_t h = std::hash<std::string>()(key) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>((h >> 32) % parts.size());
+    }
+
+    Partition& partitionFor(const std::string& key) { return *parts[partitionIndex(key)]; }
+    Partition& partition(int index) { return *parts[index]; }
+
+    // Locks every partition, in index order.
+    std::vector<std::unique_lock<std::mutex>> lockAll() {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (auto& part : parts) locks.emplace_back(part->mutex);
+        return locks;
+    }
+
+    std::vector<std::mutex*> mutexes() {
+        std::vector<std::mutex*> all;
+        for (auto& part : parts) all.push_back(&part->mutex);
+        return all;
+    }
+
+    // Entry count over both tiers, taking each partition's lock in turn.
+    size_t size() {
+        size_t total = 0;
+        for (auto& part : parts) {
+            std::lock_guard<std::mutex> lock(part->mutex);
+            total += part->size();
+        }
+        return total;
+    }
+
+    // Takes no locks: only while no other thread uses the table (stats() is
+    // safe during training).
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& part : parts) total += part->size();
+        return total;
+    }
+
+    NodeTableStats stats() {
+        NodeTableStats total;
+        for (auto& part : parts) {
+            std::lock_guard<std::mutex> lock(part->mutex);
+            total.hotHits += part->counters.hotHits;
+            total.coldHits += part->counters.coldHits;
+            total.misses += part->counters.misses;
+            total.evictions += part->counters.evictions;
+            total.hotEntries += part->map.size();
+            total.hotBytes += part->hotBytes;
+            if (indexed) {
+                total.indexedEntries += part->indexedCount;
+                total.overflowEntries += part->map.size();
+            }
+            if (part->cold) {
+                total.coldEntries += part->cold->size();
+                total.coldBytes += part->cold->liveBytes();
+                total.compactions += part->cold->compactionCount();
+            }
+        }
+        if (indexed) total.indexSlots = indexed->nodes.size();
+        return total;
+    }
+
+    void clear() {
+        for (auto& part : parts) part->clear();
+        if (indexed) std::fill(indexed->filled.begin(), indexed->filled.end(), 0);
+    }
+
+    // Replaces the contents with nodes (used when loading checkpoints).
+    void assign(std::unordered_map<std::string, NodeT>&& nodes) {
+        clear();
+        for (auto& entry : nodes) partitionFor(entry.first).store(entry.first, entry.second);
+        nodes.clear();
+    }
+
+    // What iteration yields: the key and the node, hot or read back from the
+    // cold tier (without paging it in).
+    struct EntryRef {
+        const std::string& first;
+        const NodeT& second;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = EntryRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = EntryRef;
+
+        const_iterator(const PartitionedNodeTable* table, size_t part)
+            : table(table), part(part), slot(part == 0 ? 0 : table->indexedSlots()), inCold(false),
+              coldNode(std::make_shared<NodeT>()) {
+            if (part < table->parts.size()) hotIt = table->parts[part]->map.begin();
+            settle();
+        }
+
+        EntryRef operator*() const {
+            if (slot < table->indexedSlots()) return EntryRef{indexedKey, table->indexed->nodes[slot]};
+            if (inCold) return EntryRef{coldKey, *coldNode};
+            return EntryRef{hotIt->first, hotIt->second.node};
+        }
+        const_iterator& operator++() {
+            if (slot < table->indexedSlots()) ++slot;
+            else if (inCold) ++coldIt;
+            else ++hotIt;
+            settle();
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const {
+            if (part != other.part || slot != other.slot) return false;
+            if (part == table->parts.size()) return true;
+            return inCold == other.inCold && (inCold ? coldIt == other.coldIt : hotIt == other.hotIt);
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        const PartitionedNodeTable* table;
+        size_t part;
+        size_t slot;  // indexed slots come first
+        std::string indexedKey;
+        bool inCold;
+        typename Map::const_iterator hotIt;
+        ColdStore::Index::const_iterator coldIt;
+        std::string coldKey;
+        std::shared_ptr<NodeT> coldNode;
+
+        // Moves past empty slots, exhausted tiers and partitions, decoding
+        // cold entries.
+        void settle() {
+            size_t slots = table->indexedSlots();
+            while (slot < slots && !table->indexed->filled[slot]) slot++;
+            if (slot < slots) {
+                table->indexed->index->key(slot, indexedKey);
+                return;
+            }
+            while (part < table->parts.size()) {
+                const Partition& current = *table->parts[part];
+                if (!inCold) {
+                    if (hotIt != current.map.end()) return;
+                    inCold = true;
+                    if (current.cold) coldIt = current.cold->entries().begin();
+                }
+                if (current.cold && coldIt != current.cold->entries().end()) {
+                    const char* payload;
+                    uint32_t length;
+                    current.cold->read(coldIt->second, coldKey, payload, length);
+                    decodeNode(payload, *coldNode);
+                    return;
+                }
+                inCold = false;
+                if (++part < table->parts.size()) hotIt = table->parts[part]->map.begin();
+            }
+        }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, parts.size()); }
+
+    // Calls fn(key, node) for shard `shard` of numShards: indexed slots in
+    // runs of 4096, and every partition's hot map and cold index bucket by
+    // bucket, are dealt out to the shards, so shards are even with a single
+    // partition too. Takes no locks; distinct shards can be walked
+    // concurrently while no worker updates the table.
+    template <typename Fn>
+    void forEachInShard(int shard, int numShards, Fn fn) const {
+        size_t slot = 0;
+        NodeT coldNode;
+        std::string coldKey;
+        const size_t run = 4096;
+        for (size_t start = 0; start < indexedSlots(); start += run, slot++) {
+            if (slot % numShards != static_cast<size_t>(shard)) continue;
+            for (size_t s = start; s < std::min(start + run, indexedSlots()); s++) {
+                if (!indexed->filled[s]) continue;
+                indexed->index->key(s, coldKey);
+                fn(coldKey, indexed->nodes[s]);
+            }
+        }
+        for (const auto& part : parts) {
+            for (size_t b = 0; b < part->map.bucket_count(); b++, slot++) {
+                if (slot % numShards != static_cast<size_t>(shard)) continue;
+                for (auto it = part->map.begin(b); it != part->map.end(b); ++it) fn(it->first, it->second.node);
+            }
+            if (!part->cold) continue;
+            const ColdStore::Index& index = part->cold->entries();
+            for (size_t b = 0; b < index.bucket_count(); b++, slot++) {
+                if (slot % numShards != static_cast<size_t>(shard)) continue;
+                for (auto it = index.begin(b); it != index.end(b); ++it) {
+                    const char* payload;
+                    uint32_t length;
+                    part->cold->read(it->second, coldKey, payload, length);
+                    decodeNode(payload, coldNode);
+                    fn(coldKey, coldNode);
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Partition>> parts;
+    NumaLayout layout = NUMA_LAYOUT_NONE;
+    std::unique_ptr<IndexedTier> indexed;
+
+    size_t indexedSlots() const { return indexed ? indexed->nodes.size() : 0; }
+};
+
+// Counterpart of the std::unordered_map overload in checkpoint.cpp.
+template <typename NodeT>
+void replaceNodes(PartitionedNodeTable<NodeT>& nodes, std::unordered_map<std::string, NodeT>& loaded) {
+    nodes.assign(std::move(loaded));
+}
+
+#endif // SPINGO_NODE_TABLE_CPP
@@ -0,0 +1,263 @@
+/*
+NUMA topology, memory placement and thread pinning without libnuma.
+
+The topology is read from /sys/devices/system/node (one node covering every
+CPU when that is missing, e.g. on non-Linux systems or in containers that
+hide it). Memory placement uses the mbind system call directly on regions
+the caller maps itself; NumaArena builds on that to give a partition of a
+data structure its own node-local (or interleaved) heap.
+
+All of this degrades to plain behaviour on single-node machines or when the
+kernel refuses the policy: memory still gets allocated, just without the
+placement hint, and a single warning is printed.
+*/
+
+#ifndef SPINGO_NUMA_CPP
+#define SPINGO_NUMA_CPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum NumaPolicy {
+    NUMA_POLICY_DEFAULT,     // first touch, whatever the kernel does
+    NUMA_POLICY_PREFERRED,   // on one node while it has free memory
+    NUMA_POLICY_INTERLEAVE   // pages round-robin over every node
+};
+
+// Parses a sysfs CPU/node list such as "0-7,16-23".
+inline std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range[0] == '\n') continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; id++) ids.push_back(id);
+        } catch (...) {
+            return {};
+        }
+    }
+    return ids;
+}
+
+class NumaTopology {
+public:
+    static const NumaTopology& get() {
+        static NumaTopology topology;
+        return topology;
+    }
+
+    int numNodes() const { return static_cast<int>(nodeIds.size()); }
+
+    // Kernel id of the index-th node (node ids need not be contiguous).
+    int nodeId(int index) const { return nodeIds[index % numNodes()]; }
+
+    const std::vector<int>& cpus(int index) const { return nodeCpus[index % numNodes()]; }
+
+    // CPU for the i-th pinned thread: threads go round-robin over the nodes,
+    // then over the CPUs of their node.
+    int cpuForThread(int i, int* nodeIndex = nullptr) const {
+        int node = i % numNodes();
+        if (nodeIndex) *nodeIndex = node;
+        const std::vector<int>& list = nodeCpus[node];
+        return list[(i / numNodes()) % list.size()];
+    }
+
+private:
+    std::vector<int> nodeIds;
+    std::vector<std::vector<int>> nodeCpus;
+
+    NumaTopology() {
+#ifdef __linux__
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (online && std::getline(online, list)) {
+            for (int node : parseCpuList(list)) {
+                std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpus;
+                if (!cpulist || !std::getline(cpulist, cpus)) continue;
+                std::vector<int> ids = parseCpuList(cpus);
+                if (ids.empty()) continue;  // memory-only node
+                nodeIds.push_back(node);
+                nodeCpus.push_back(ids);
+            }
+        }
+#endif
+        if (nodeIds.empty()) {
+            int count = std::max(1u, std::thread::hardware_concurrency());
+            std::vector<int> all(count);
+            for (int cpu = 0; cpu < count; cpu++) all[cpu] = cpu;
+            nodeIds.push_back(0);
+            nodeCpus.push_back(all);
+        }
+    }
+};
+
+// Binds the calling thread to one CPU. Returns false if that is unsupported.
+inline bool pinThreadToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Applies policy to [addr, addr + length) before it is first touched. node is
+// a node index for NUMA_POLICY_PREFERRED and ignored otherwise.
+inline bool numaBindMemory(void* addr, size_t length, NumaPolicy policy, int node) {
+    if (policy == NUMA_POLICY_DEFAULT) return true;
+#if defined(__linux__) && defined(SYS_mbind)
+    const NumaTopology& topology = NumaTopology::get();
+    const int maskBits = 1024;
+    unsigned long mask[maskBits / (8 * sizeof(unsigned long))] = {0};
+    auto setNode = [&](int id) {
+        if (id >= 0 && id < maskBits) mask[id / (8 * sizeof(unsigned long))] |= 1UL << (id % (8 * sizeof(unsigned long)));
+    };
+    if (policy == NUMA_POLICY_INTERLEAVE) {
+        for (int n = 0; n < topology.numNodes(); n++) setNode(topology.nodeId(n));
+    } else {
+        setNode(topology.nodeId(node));
+    }
+    const int mode = policy == NUMA_POLICY_INTERLEAVE ? 3 /* MPOL_INTERLEAVE */ : 1 /* MPOL_PREFERRED */;
+    // The kernel reads maxnode - 1 bits of the mask
+    if (syscall(SYS_mbind, addr, length, mode, mask, maskBits + 1, 0) == 0) return true;
+#else
+    (void)addr;
+    (void)length;
+    (void)node;
+#endif
+    static std::atomic<bool> warned(false);
+    if (!warned.exchange(true)) {
+        std::cerr << "Warning: NUMA memory policy not supported here; using default placement" << std::endl;
+    }
+    return false;
+}
+
+// Heap for one partition of a data structure, carved out of large mappings
+// that carry the partition's NUMA policy. Small blocks are recycled through
+// per-size free lists; blocks above LARGE_BLOCK get their own mapping.
+//
+// Not thread-safe: callers serialize access (the node table does this with
+// the partition lock).
+class NumaArena {
+public:
+    NumaArena(NumaPolicy policy, int node) : policy(policy), node(node), cursor(nullptr), remaining(0) {
+        std::fill(freeLists, freeLists + NUM_CLASSES, nullptr);
+    }
+
+    ~NumaArena() {
+        for (const auto& mapping : mappings) munmap(mapping.first, mapping.second);
+    }
+
+    NumaArena(const NumaArena&) = delete;
+    NumaArena& operator=(const NumaArena&) = delete;
+
+    void* allocate(size_t bytes) {
+        if (bytes > LARGE_BLOCK) return mapRegion(bytes);
+        int sizeClass = classOf(bytes);
+        if (FreeBlock* block = freeLists[sizeClass]) {
+            freeLists[sizeClass] = block->next;
+            return block;
+        }
+        size_t size = classSize(sizeClass);
+        if (remaining < size) {
+            cursor = static_cast<char*>(mapRegion(CHUNK_SIZE));
+            remaining = CHUNK_SIZE;
+        }
+        void* p = cursor;
+        cursor += size;
+        remaining -= size;
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        if (bytes > LARGE_BLOCK) {
+            unmapRegion(p, bytes);
+            return;
+        }
+        int sizeClass = classOf(bytes);
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+
+    size_t mappedBytes() const {
+        size_t total = 0;
+        for (const auto& mapping : mappings) total += mapping.second;
+        return total;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // 16-byte classes up to 1 KB, then powers of two up to LARGE_BLOCK
+    static const size_t CHUNK_SIZE = 4 << 20;
+    static const size_t LARGE_BLOCK = 256 << 10;
+    static const int SMALL_CLASSES = 64;
+    static const int NUM_CLASSES = SMALL_CLASSES + 8;
+
+    static int classOf(size_t bytes) {
+        if (bytes <= 1024) return static_cast<int>((std::max<size_t>(bytes, 1) + 15) / 16) - 1;
+        int sizeClass = SMALL_CLASSES;
+        for (size_t size = 2048; size < bytes; size <<= 1) sizeClass++;
+        return sizeClass;
+    }
+
+    static size_t classSize(int sizeClass) {
+        return sizeClass < SMALL_CLASSES ? 16 * (sizeClass + 1) : size_t(2048) << (sizeClass - SMALL_CLASSES);
+    }
+
+    void* mapRegion(size_t bytes) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        numaBindMemory(p, bytes, policy, node);
+        mappings.emplace_back(p, bytes);
+        return p;
+    }
+
+    void unmapRegion(void* p, size_t bytes) {
+        munmap(p, bytes);
+        for (size_t i = 0; i < mappings.size(); i++) {
+            if (mappings[i].first == p) {
+                mappings[i] = mappings.back();
+                mappings.pop_back();
+                break;
+            }
+        }
+    }
+
+    NumaPolicy policy;
+    int node;
+    char* cursor;
+    size_t remaining;
+    FreeBlock* freeLists[NUM_CLASSES];
+    std::vector<std::pair<void*, size_t>> mappings;
+};
+
+#endif // SPINGO_NUMA_CPP
@@ -0,0 +1,172 @@
+/*
+Binary preflop all-in equity table (written by utils/preflop_allin_equity.cpp).
+
+Matchups of specific hole cards are stored once per suit-isomorphism class:
+the hands are mapped through each of the 24 suit permutations, sorted by
+combo index, and the smallest resulting key is the canonical one.
+
+Layout (little endian, mmap-able):
+    PreflopEquityHeader
+    count2 x PreflopEquityRecord2   sorted by key, key = a * 1326 + b
+    count3 x PreflopEquityRecord3   sorted by key, key = (a * 1326 + b) * 1326 + c
+where a < b < c are combo indices of the canonical hands and shares are the
+expected fractions of the pot for the hands in that order.
+
+This file has no dependency on Card so the utils/ tools can include it too.
+*/
+
+#ifndef SPINGO_PREFLOP_EQUITY_FILE_CPP
+#define SPINGO_PREFLOP_EQUITY_FILE_CPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char PREFLOP_EQUITY_MAGIC[8] = {'S', 'G', 'P', 'F', 'E', 'Q', '1', '\0'};
+static const uint32_t PREFLOP_EQUITY_VERSION = 1;
+static const int PREFLOP_COMBOS = 1326;
+
+struct PreflopEquityHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t threeWaySamples;  // 0 when 3-way entries are exact
+    uint64_t count2;
+    uint64_t count3;
+};
+
+struct PreflopEquityRecord2 {
+    uint32_t key;
+    float share;  // first hand; the second gets 1 - share
+};
+
+struct PreflopEquityRecord3 {
+    uint32_t key;
+    float shares[3];
+};
+
+// Index of a two-card combo (0..1325) for cards in either order.
+inline int comboIndex(int card1, int card2) {
+    int lo = std::min(card1, card2), hi = std::max(card1, card2);
+    return lo * (2 * 52 - lo - 1) / 2 + (hi - lo - 1);
+}
+
+// Sorts the first n entries of idx (n <= 3) by ascending keys[idx[i]].
+inline void sortIndicesByKey(int* idx, int n, const int* keys) {
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && keys[idx[j]] < keys[idx[j - 1]]; j--) std::swap(idx[j], idx[j - 1]);
+    }
+}
+
+// Canonical key of a 2- or 3-way matchup. holeCards holds two cards per
+// player; order[i] receives the input player stored at position i.
+inline uint32_t canonicalMatchupKey(const int* holeCards, int numPlayers, int* order) {
+    static const int SUIT_PERMUTATIONS[24][4] = {
+        {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {0, 3, 2, 1},
+        {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0}, {1, 3, 0, 2}, {1, 3, 2, 0},
+        {2, 0, 1, 3}, {2, 0, 3, 1}, {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 3, 0, 1}, {2, 3, 1, 0},
+        {3, 0, 1, 2}, {3, 0, 2, 1}, {3, 1, 0, 2}, {3, 1, 2, 0}, {3, 2, 0, 1}, {3, 2, 1, 0}};
+
+    uint32_t best = UINT32_MAX;
+    for (int p = 0; p < 24; p++) {
+        const int* perm = SUIT_PERMUTATIONS[p];
+        int combos[3];
+        int idx[3] = {0, 1, 2};
+        for (int i = 0; i < numPlayers; i++) {
+            int c1 = holeCards[i * 2], c2 = holeCards[i * 2 + 1];
+            combos[i] = comboIndex((c1 & ~3) | perm[c1 & 3], (c2 & ~3) | perm[c2 & 3]);
+        }
+        sortIndicesByKey(idx, numPlayers, combos);
+        uint32_t key = 0;
+        for (int i = 0; i < numPlayers; i++) key = key * PREFLOP_COMBOS + combos[idx[i]];
+        if (key < best) {
+            best = key;
+            if (order) std::copy(idx, idx + numPlayers, order);
+        }
+    }
+    return best;
+}
+
+// Read-only view of a table file.
+class PreflopEquityFile {
+public:
+    PreflopEquityFile() : data(nullptr), size(0), header(nullptr), records2(nullptr), records3(nullptr) {}
+    ~PreflopEquityFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(PreflopEquityHeader))) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        data = mapped;
+        size = st.st_size;
+        header = static_cast<const PreflopEquityHeader*>(data);
+        size_t expected = sizeof(PreflopEquityHeader) + header->count2 * sizeof(PreflopEquityRecord2)
+                        + header->count3 * sizeof(PreflopEquityRecord3);
+        if (std::memcmp(header->magic, PREFLOP_EQUITY_MAGIC, 8) != 0 ||
+            header->version != PREFLOP_EQUITY_VERSION || expected != size) {
+            close();
+            return false;
+        }
+        records2 = reinterpret_cast<const PreflopEquityRecord2*>(header + 1);
+        records3 = reinterpret_cast<const PreflopEquityRecord3*>(records2 + header->count2);
+        return true;
+    }
+
+    void close() {
+        if (data) munmap(data, size);
+        data = nullptr;
+        header = nullptr;
+        records2 = nullptr;
+        records3 = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const { return data != nullptr; }
+    uint64_t count2() const { return header ? header->count2 : 0; }
+    uint64_t count3() const { return header ? header->count3 : 0; }
+
+    // Pot shares for the given players' hole cards; false if the matchup is
+    // not in the table.
+    bool lookup(const int* holeCards, int numPlayers, double* shares) const {
+        if (!header || numPlayers < 2 || numPlayers > 3) return false;
+        int order[3];
+        uint32_t key = canonicalMatchupKey(holeCards, numPlayers, order);
+        if (numPlayers == 2) {
+            const PreflopEquityRecord2* end = records2 + header->count2;
+            const PreflopEquityRecord2* it = std::lower_bound(records2, end, key,
+                [](const PreflopEquityRecord2& r, uint32_t k) { return r.key < k; });
+            if (it == end || it->key != key) return false;
+            shares[order[0]] = it->share;
+            shares[order[1]] = 1.0 - it->share;
+        } else {
+            const PreflopEquityRecord3* end = records3 + header->count3;
+            const PreflopEquityRecord3* it = std::lower_bound(records3, end, key,
+                [](const PreflopEquityRecord3& r, uint32_t k) { return r.key < k; });
+            if (it == end || it->key != key) return false;
+            for (int i = 0; i < 3; i++) shares[order[i]] = it->shares[i];
+        }
+        return true;
+    }
+
+private:
+    void* data;
+    size_t size;
+    const PreflopEquityHeader* header;
+    const PreflopEquityRecord2* records2;
+    const PreflopEquityRecord3* records3;
+};
+
+#endif // SPINGO_PREFLOP_EQUITY_FILE_CPP
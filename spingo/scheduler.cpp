@@ -0,0 +1,290 @@
+/*
+Work-stealing task scheduler shared by the trainers, the best-response
+evaluator and the equity generators.
+
+Each worker owns a deque of tasks. A worker pushes and pops at the back of its
+own deque (newest first, which keeps split ranges cache-warm) and, when it
+runs dry, steals from the front of a random victim's deque (oldest first,
+which for split ranges is the largest remaining piece). Every deque has its
+own small lock, so there is no global queue to contend on; idle workers sleep
+on a condition variable and are woken by new work.
+
+parallelFor() hands out iteration ranges that split themselves in half until
+they reach the grain size, so the tail of a run is balanced by stealing
+instead of waiting on one fixed batch. Threads that wait (wait(), parallelFor())
+run queued tasks while they wait, which makes nested parallelism safe and lets
+the calling thread count as one of the workers. A task that throws still counts
+as finished; the first exception of a group is rethrown by wait() (and so by
+parallelFor()) once all of the group's tasks are done.
+
+Workers can be pinned to CPUs (Linux only), spread round-robin over the NUMA
+nodes so that every node gets its share of workers.
+
+This file has no dependency on Card so the utils/ tools can include it too.
+*/
+
+#ifndef SPINGO_SCHEDULER_CPP
+#define SPINGO_SCHEDULER_CPP
+
+#include "numa.cpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Counts the outstanding tasks spawned into it and keeps the first exception
+// one of them threw.
+class TaskGroup {
+public:
+    TaskGroup() : pending(0) {}
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class WorkStealingScheduler;
+    std::atomic<int> pending;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void fail(std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = e;
+    }
+};
+
+class WorkStealingScheduler {
+public:
+    // numWorkers may be 0, in which case every task runs on the waiting
+    // thread. With pin, worker i is bound to one CPU of NUMA node i modulo
+    // the node count.
+    explicit WorkStealingScheduler(int numWorkers, bool pin = false)
+        : queues(std::max(numWorkers, 0) + 1), pinned(pin), stopping(false), sleepers(0), queued(0) {
+        // The last queue belongs to threads that are not workers
+        for (auto& q : queues) q.reset(new WorkerQueue());
+        for (int i = 0; i < numWorkers; i++) {
+            workers.emplace_back([this, i, pin]() {
+                workerIndex() = i;
+                if (pin) pinThreadToCpu(NumaTopology::get().cpuForThread(i));
+                workerLoop(i);
+            });
+        }
+    }
+
+    ~WorkStealingScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    int numWorkers() const { return static_cast<int>(workers.size()); }
+
+    // Threads that can run tasks at once, counting one waiting caller.
+    int concurrency() const { return numWorkers() + 1; }
+
+    bool pinsWorkers() const { return pinned; }
+
+    // Queues fn as part of group. Called from a worker, the task goes on that
+    // worker's own deque.
+    void spawn(TaskGroup& group, std::function<void()> fn) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        WorkerQueue& q = ownQueue();
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(Task{std::move(fn), &group});
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wakeCondition.notify_one();
+        }
+    }
+
+    // Runs queued tasks until every task of group has finished, then rethrows
+    // the first exception a task of group threw.
+    void wait(TaskGroup& group) {
+        int spins = 0;
+        while (!group.done()) {
+            Task task;
+            if (takeTask(ownIndex(), task)) {
+                runTask(task);
+                spins = 0;
+            } else if (++spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(group.errorMutex);
+            std::swap(error, group.error);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    // Calls body(rangeBegin, rangeEnd) over [begin, end) in chunks of at most
+    // grain iterations and returns once all of them have run.
+    void parallelFor(long begin, long end, long grain, const std::function<void(long, long)>& body) {
+        if (begin >= end) return;
+        grain = std::max(1L, grain);
+        TaskGroup group;
+        // The queued halves refer to group and body, so wait for them even
+        // if the caller's own chunk throws
+        try {
+            splitRange(group, begin, end, grain, body);
+        } catch (...) {
+            group.fail(std::current_exception());
+        }
+        wait(group);
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+    };
+
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    bool pinned;
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    bool stopping;
+    std::atomic<int> sleepers;
+    // Tasks pushed minus tasks taken. Sequentially consistent together with
+    // sleepers, so a push never misses a worker that is going to sleep.
+    std::atomic<long> queued;
+
+    static int& workerIndex() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    int ownIndex() const {
+        int index = workerIndex();
+        return index >= 0 && index < numWorkers() ? index : numWorkers();
+    }
+
+    WorkerQueue& ownQueue() { return *queues[ownIndex()]; }
+
+    // Keeps the left half and queues the right half until the range is no
+    // larger than grain, so thieves always take the biggest pieces.
+    void splitRange(TaskGroup& group, long begin, long end, long grain,
+                    const std::function<void(long, long)>& body) {
+        while (end - begin > grain) {
+            long mid = begin + (end - begin) / 2;
+            spawn(group, [this, &group, mid, end, grain, &body]() { splitRange(group, mid, end, grain, body); });
+            end = mid;
+        }
+        body(begin, end);
+    }
+
+    bool popOwn(int index, Task& task) {
+        WorkerQueue& q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int thief, Task& task) {
+        thread_local std::minstd_rand victimRng(std::random_device{}());
+        const int n = static_cast<int>(queues.size());
+        int start = static_cast<int>(victimRng() % n);
+        for (int k = 0; k < n; k++) {
+            int victim = (start + k) % n;
+            if (victim == thief) continue;
+            WorkerQueue& q = *queues[victim];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty()) continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool takeTask(int index, Task& task) {
+        if (queued.load() <= 0) return false;
+        if (popOwn(index, task) || steal(index, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void runTask(Task& task) {
+        // Decrements pending however fn exits, so waiters cannot hang
+        struct Finish {
+            TaskGroup* group;
+            ~Finish() { group->pending.fetch_sub(1, std::memory_order_acq_rel); }
+        } finish{task.group};
+        try {
+            task.fn();
+        } catch (...) {
+            task.group->fail(std::current_exception());
+        }
+    }
+
+    void workerLoop(int index) {
+        while (true) {
+            Task task;
+            if (takeTask(index, task)) {
+                runTask(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers++;
+            wakeCondition.wait(lock, [this]() { return stopping || queued.load() > 0; });
+            sleepers--;
+            if (stopping) return;
+        }
+    }
+};
+
+// Process-wide scheduler, created on first use with numWorkers workers (0 =
+// one per hardware thread, leaving one for the caller). Later calls return
+// the same instance; if they ask for another worker count (other than 0) or
+// for pinning it lacks, a warning is printed once, since the running
+// scheduler cannot change.
+inline WorkStealingScheduler& sharedScheduler(int numWorkers = 0, bool pin = false) {
+    static std::unique_ptr<WorkStealingScheduler> scheduler;
+    static std::once_flag created;
+    static std::atomic<bool> warned(false);
+    bool first = false;
+    std::call_once(created, [&]() {
+        first = true;
+        int workers = numWorkers > 0 ? numWorkers : std::max(1u, std::thread::hardware_concurrency()) - 1;
+        scheduler.reset(new WorkStealingScheduler(workers, pin));
+    });
+    bool conflicts = (numWorkers > 0 && numWorkers != scheduler->numWorkers()) || (pin && !scheduler->pinsWorkers());
+    if (!first && conflicts && !warned.exchange(true)) {
+        std::cerr << "Warning: the shared scheduler already runs " << scheduler->numWorkers() << " workers"
+                  << (scheduler->pinsWorkers() ? " (pinned)" : "") << "; ignoring a request for " << numWorkers
+                  << (pin ? " pinned" : "") << " workers" << std::endl;
+    }
+    return *scheduler;
+}
+
+#endif // SPINGO_SCHEDULER_CPP
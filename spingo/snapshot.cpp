@@ -0,0 +1,168 @@
+/*
+Background snapshots of the training state using fork() copy-on-write.
+
+snapshot() briefly takes the locks that make the state consistent, forks, and
+releases them: the child process inherits a frozen copy of the whole address
+space and serializes it at its own pace while the parent's workers carry on
+(pages are only copied when the parent writes to them). The pause seen by
+training is the lock wait plus the fork itself, which is proportional to the
+page-table size rather than to the amount of data written.
+
+A reaper thread waits for the child, reports pause time, write time and
+throughput, and then runs an optional completion callback (e.g. an upload).
+Only one snapshot is in flight at a time; requests made while the previous
+one is still being written or uploaded are skipped.
+
+POSIX only. The child must not touch locks owned by other threads, so the
+write function should only do file I/O (and report errors on std::cerr).
+
+The locks only keep single nodes whole. A training iteration updates many
+nodes, so a parallel trainer brackets its iterations with an IterationGate and
+snapshots while it is paused: no iteration is then half applied, and the
+iteration count saved with the snapshot is exact.
+*/
+
+#ifndef SPINGO_SNAPSHOT_CPP
+#define SPINGO_SNAPSHOT_CPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Lets one thread stop new training iterations from starting and wait for
+// the running ones to finish. Workers call enter() before and leave() after
+// each iteration; pause() returns once none is running, and holds the others
+// in enter() until resume().
+class IterationGate {
+public:
+    void enter() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !paused; });
+        running++;
+    }
+
+    void leave() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0 && paused) changed.notify_all();
+    }
+
+    // Must not be called between enter() and leave() of the same thread.
+    void pause() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !paused; });
+        paused = true;
+        changed.wait(lock, [this]() { return running == 0; });
+    }
+
+    void resume() {
+        std::lock_guard<std::mutex> lock(mutex);
+        paused = false;
+        changed.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    int running = 0;
+    bool paused = false;
+};
+
+class BackgroundSnapshotter {
+public:
+    // writeFn runs in the forked child and returns true when the file was
+    // written; onComplete runs on the reaper thread after a successful write.
+    BackgroundSnapshotter(std::function<bool(const std::string&)> writeFn,
+                          std::function<void(const std::string&)> onComplete = nullptr)
+        : writeFn(writeFn), onComplete(onComplete), busy(false), snapshotsTaken(0), snapshotsSkipped(0) {}
+
+    ~BackgroundSnapshotter() { wait(); }
+
+    // Freezes the state by taking freezeLocks (in order), forks a child that
+    // writes filename, and releases the locks. Returns false if a previous
+    // snapshot is still in flight or fork() failed.
+    bool snapshot(const std::string& filename, const std::vector<std::mutex*>& freezeLocks = {}) {
+        if (busy.exchange(true)) {
+            snapshotsSkipped++;
+            return false;
+        }
+        if (reaper.joinable()) reaper.join();
+
+        // Unflushed output would otherwise be written by both processes
+        std::cout.flush();
+        std::cerr.flush();
+
+        auto pauseStart = std::chrono::steady_clock::now();
+        std::vector<std::unique_lock<std::mutex>> held;
+        for (std::mutex* m : freezeLocks) held.emplace_back(*m);
+        pid_t pid = fork();
+        held.clear();
+        auto pauseEnd = std::chrono::steady_clock::now();
+
+        if (pid == 0) {
+            bool ok = writeFn(filename);
+            _exit(ok ? 0 : 1);
+        }
+        if (pid < 0) {
+            std::cerr << "Snapshot fork failed; skipping snapshot of " << filename << std::endl;
+            busy = false;
+            return false;
+        }
+
+        double pauseMs = std::chrono::duration<double, std::milli>(pauseEnd - pauseStart).count();
+        snapshotsTaken++;
+        reaper = std::thread([this, pid, filename, pauseMs, pauseEnd]() {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pauseEnd).count();
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+            struct stat st;
+            double megabytes = (ok && stat(filename.c_str(), &st) == 0) ? st.st_size / (1024.0 * 1024.0) : 0.0;
+            {
+                std::lock_guard<std::mutex> lock(reportMutex);
+                if (ok) {
+                    std::cout << "\nSnapshot " << filename << " written in background: pause "
+                              << std::fixed << std::setprecision(2) << pauseMs << " ms, write "
+                              << writeSeconds << " s, " << megabytes << " MB ("
+                              << (writeSeconds > 0 ? megabytes / writeSeconds : 0.0) << " MB/s)" << std::endl;
+                } else {
+                    std::cerr << "\nSnapshot " << filename << " failed in background process" << std::endl;
+                }
+            }
+            if (ok && onComplete) onComplete(filename);
+            busy = false;
+        });
+        return true;
+    }
+
+    // Blocks until the in-flight snapshot (and its callback) has finished.
+    void wait() {
+        if (reaper.joinable()) reaper.join();
+    }
+
+    bool inFlight() const { return busy; }
+    int taken() const { return snapshotsTaken; }
+    int skipped() const { return snapshotsSkipped; }
+
+private:
+    std::function<bool(const std::string&)> writeFn;
+    std::function<void(const std::string&)> onComplete;
+    std::atomic<bool> busy;
+    std::atomic<int> snapshotsTaken;
+    std::atomic<int> snapshotsSkipped;
+    std::thread reaper;
+    std::mutex reportMutex;
+};
+
+#endif // SPINGO_SNAPSHOT_CPP
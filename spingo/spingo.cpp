@@ -35,6 +35,7 @@ g++ -std=c++17 -O2 kickoff_poker.cpp -o kickoff_poker
 #include <functional>
 #include <iomanip>  // for setprecision
 #include <unordered_set>
+#include <cstdint>
 
 using namespace std;
 
@@ -368,6 +369,89 @@ string action_to_string(Action action) {
         default: return "INVALID_ACTION";
     }
 }
+
+// ----------------------------------------------------------------------------
+// Action history
+// ----------------------------------------------------------------------------
+
+// Betting actions of one hand, one byte each (player << 4 | action; every
+// Action fits in four bits), plus the index where each round's actions start.
+// Copying a state copies one small vector, and the current round's actions
+// are a contiguous run that infoset keys are built from without formatting
+// any text. action_history_text() turns key text back into the readable
+// "P2:BET_2|P0:CALL" form for export.
+class ActionHistory {
+public:
+    static const int MAX_ROUNDS = 5;  // preflop .. showdown
+
+    void push(int player, Action action) {
+        codes.push_back(static_cast<uint8_t>(player << 4 | static_cast<int>(action)));
+    }
+
+    // Later actions belong to the next round.
+    void next_round() {
+        if (current + 1 < MAX_ROUNDS) round_start[++current] = static_cast<uint32_t>(codes.size());
+    }
+
+    // Actions of the current round, i = 0 first.
+    int round_length() const { return static_cast<int>(codes.size() - round_start[current]); }
+    uint8_t code(int i) const { return codes[round_start[current] + i]; }
+    int player(int i) const { return code(i) >> 4; }
+    Action action(int i) const { return static_cast<Action>(code(i) & 0xF); }
+
+    // Appends the current round's actions as infoset key text: two hex
+    // digits (the action code) per action.
+    void append_key(string& out) const {
+        static const char HEX[] = "0123456789abcdef";
+        for (size_t i = round_start[current]; i < codes.size(); i++) {
+            out += HEX[codes[i] >> 4];
+            out += HEX[codes[i] & 0xF];
+        }
+    }
+
+    // The current round's actions as "P2:BET_2|P0:CALL".
+    string round_text() const {
+        string out;
+        for (int i = 0; i < round_length(); i++) {
+            if (i > 0) out += '|';
+            out += "P" + std::to_string(player(i)) + ":" + action_to_string(action(i));
+        }
+        return out;
+    }
+
+private:
+    vector<uint8_t> codes;
+    uint32_t round_start[MAX_ROUNDS] = {0};
+    int current = 0;
+};
+
+// Readable form, "P2:BET_2|P0:CALL", of the Actions field of an infoset key.
+// Takes the hex codes of ActionHistory::append_key and the bracketed text
+// "[P2:BET_2][P0:CALL]" of keys written before it, so older checkpoints can
+// still seed a --warm-start.
+string action_history_text(const string& keyActions) {
+    string out;
+    if (!keyActions.empty() && keyActions[0] == '[') {
+        size_t pos = 0;
+        while (pos < keyActions.size()) {
+            size_t start = keyActions.find('[', pos);
+            if (start == string::npos) break;
+            size_t end = keyActions.find(']', start);
+            if (end == string::npos) break;
+            if (!out.empty()) out += '|';
+            out.append(keyActions, start + 1, end - start - 1);
+            pos = end + 1;
+        }
+        return out;
+    }
+    for (size_t i = 0; i + 1 < keyActions.size(); i += 2) {
+        int code = static_cast<int>(std::stoi(keyActions.substr(i, 2), nullptr, 16));
+        if (!out.empty()) out += '|';
+        out += "P" + std::to_string(code >> 4) + ":" + action_to_string(static_cast<Action>(code & 0xF));
+    }
+    return out;
+}
+
 // ----------------------------------------------------------------------------
 // SpinGoState class
 // ----------------------------------------------------------------------------
@@ -387,7 +471,8 @@ public:
     vector<double> cumulative_pot; // total chips contributed per player over rounds
     double current_bet = 1.0;
     vector<Card> deck;             // the deck (shuffled)
-    map<string, vector<pair<int, Action>>> round_action_history; // Stores action history per round
+    ActionHistory action_history; // betting actions of the hand, by round
+    bool defer_allin_runout = false; // leave the board of an all-in hand undealt (see runout_pending())
 
     // Random engine for shuffling.
     mt19937 rng;
@@ -746,6 +831,7 @@ public:
             bets[p] = Action::UNKNOWN;
         }
         current_bet = 0.0;
+        action_history.next_round();
         if (round == "preflop")
             round = "flop";
         else if (round == "flop")
@@ -787,7 +873,7 @@ public:
 
         // Record action in round history, unless it's a setup or deal action
         if (action != Action::DEAL && action != Action::POST_SB && action != Action::POST_BB) {
-            round_action_history[round].push_back({player, action});
+            action_history.push(player, action);
         }
         
         // Handle actions
@@ -843,7 +929,8 @@ public:
             if (should_end_game()) {
                 // if game should end but some cards missing, complete the deal.
                 while (round != "showdown") {
-                    deal_cards();
+                    if (!defer_allin_runout)
+                        deal_cards();
                     advance_round();
                 }
                 game_over = true;
@@ -876,6 +963,12 @@ public:
         }
     }
 
+    // True when the hand ended all-in with board cards still to come. Only
+    // happens with defer_allin_runout set; the undealt cards are left in deck.
+    bool runout_pending() const {
+        return game_over && active_players.size() > 1 && community_cards.size() < 5;
+    }
+
     // Compute and return the rewards (for each player) at game end.
     vector<double> returns() {
         vector<double> rewards(NUM_PLAYERS, 0.0);
@@ -974,9 +1067,9 @@ public:
 
         // Log action history for the current round
         file << "Action History for Round " << round << ": ";
-        if (round_action_history.count(round)) {
-            for (const auto& p_action : round_action_history.at(round)) {
-                file << "(Player " << p_action.first << ", " << action_to_string(p_action.second) << ") ";
+        if (action_history.round_length() > 0) {
+            for (int i = 0; i < action_history.round_length(); i++) {
+                file << "(Player " << action_history.player(i) << ", " << action_to_string(action_history.action(i)) << ") ";
             }
         } else {
             file << "No actions recorded for this round yet.";
@@ -0,0 +1,834 @@
+/*
+Binary columnar strategy files (.sgs), the compact counterpart of the
+strategy CSV.
+
+A file holds the same rows as the CSV (round, player, abstraction, previous
+actions, strategy, pot, update count), stored column by column in blocks of
+blockRows rows:
+
+  header (StrategyFileHeader)
+  block 0 .. block n-1, each:
+    uint32 historyId[rows]     index into the history dictionary
+    uint32 potTenths[rows]     pot in tenths of a big blind
+    uint32 updateCount[rows]
+    uint16 abstractionId[rows] index into the abstraction dictionary
+    uint16 actionMask[rows]    bit a set = action a (Action enum order) present
+    uint8  round[rows]         0 preflop, 1 flop, 2 turn, 3 river
+    uint8  player[rows]
+    uint16 probs[]             one per mask bit, lowest action first,
+                               quantized to 1/65535 (float64 in exact files)
+    float64 strategySums[]     raw files only: the node sums behind probs,
+    float64 regretSums[]       one per mask bit; NaN for rows without them
+  dictionaries: histories, then abstractions, each a uint32 length + bytes
+  block index: one StrategyBlockEntry per block
+
+Histories and abstraction labels repeat across millions of rows, so they
+are stored once and referenced by id. The block index gives the offset and
+first key of every block, which is enough to read any block on its own.
+Writers record whether the rows came in sortKey() order (the order of the
+--aggregate output); lookups binary-search the index of such files and scan
+the others.
+
+Probabilities lose precision to quantization (at most 7.7e-6 per action),
+below the six decimals the CSV prints. Everything else round-trips exactly.
+Exact files keep the probabilities as doubles; the aggregator uses them for
+its intermediate runs so that merging in several passes adds no error.
+
+Raw files (and CSVs with the two extra columns StrategySum and RegretSum,
+"FOLD:1520.25|CALL:88.5") also carry each node's strategySum and regretSum,
+which trainers export with --raw-sums. The aggregator adds those up instead
+of averaging probabilities.
+
+Self-contained (standard library only) so that tools can include it without
+the game engine.
+*/
+
+#ifndef SPINGO_STRATEGY_FILE_CPP
+#define SPINGO_STRATEGY_FILE_CPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const char STRATEGY_FILE_MAGIC[8] = {'S', 'G', 'S', 'T', 'R', 'A', 'T', '1'};
+static const uint32_t STRATEGY_FILE_VERSION = 1;
+static const uint32_t STRATEGY_FILE_SORTED = 1;
+static const uint32_t STRATEGY_FILE_EXACT = 2;
+static const uint32_t STRATEGY_FILE_RAW = 4;
+static const uint32_t STRATEGY_FILE_BLOCK_ROWS = 65536;
+static const char* const STRATEGY_FILE_EXTENSION = ".sgs";
+
+static const char* const STRATEGY_CSV_HEADER =
+    "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,StrategyUpdateCount";
+static const char* const STRATEGY_CSV_RAW_COLUMNS = ",StrategySum,RegretSum";
+
+// Names of the Action values (spingo/spingo.cpp) in enum order, as
+// action_to_string prints them; bit a of an action mask stands for
+// STRATEGY_ACTION_NAMES[a].
+static const int STRATEGY_NUM_ACTIONS = 15;
+static const char* const STRATEGY_ACTION_NAMES[STRATEGY_NUM_ACTIONS] = {
+    "FOLD", "CHECK", "CALL", "BET_1", "BET_1_5", "BET_2", "BET_3", "BET_4",
+    "BET_5", "BET_6", "BET_7", "ALL_IN", "DEAL", "POST_SB", "POST_BB"};
+
+static const int STRATEGY_NUM_ROUNDS = 4;
+static const char* const STRATEGY_ROUND_NAMES[STRATEGY_NUM_ROUNDS] = {"preflop", "flop", "turn", "river"};
+
+struct StrategyFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t rows;
+    uint64_t dictionaryOffset;
+    uint64_t indexOffset;
+    uint32_t numBlocks;
+    uint32_t blockRows;
+    uint32_t numHistories;
+    uint32_t numAbstractions;
+};
+static_assert(sizeof(StrategyFileHeader) == 56, "strategy file header layout");
+
+struct StrategyBlockEntry {
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t rows;
+    uint32_t probCount;
+    uint8_t firstRound;
+    uint8_t firstPlayer;
+    uint16_t firstAbstraction;
+    uint32_t firstHistory;
+    uint32_t firstPot;
+};
+static_assert(sizeof(StrategyBlockEntry) == 32, "strategy block index layout");
+
+// One row of a strategy file or CSV.
+struct StrategyRow {
+    uint8_t round = 0;
+    uint8_t player = 0;
+    std::string abstraction;  // "AKs" or the bucket, as the CSV has it
+    std::string history;      // "P2:BET_2|P0:CALL"
+    uint32_t potTenths = 0;
+    uint16_t actionMask = 0;
+    std::vector<double> probs;  // one per mask bit, lowest action first
+    uint32_t updateCount = 0;
+    bool raw = false;                   // strategySums and regretSums are set
+    std::vector<double> strategySums;   // like probs
+    std::vector<double> regretSums;
+
+    std::string potText() const {
+        return std::to_string(potTenths / 10) + "." + static_cast<char>('0' + potTenths % 10);
+    }
+
+    // The --aggregate key, "round|player|abstraction|history|pot"; sorted
+    // files are in increasing order of it.
+    std::string sortKey() const {
+        return std::string(STRATEGY_ROUND_NAMES[round]) + "|" + std::to_string(player) + "|" + abstraction + "|" +
+               history + "|" + potText();
+    }
+
+    std::map<std::string, double> actionProbs() const {
+        std::map<std::string, double> result;
+        size_t i = 0;
+        for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+            if (actionMask >> a & 1) result[STRATEGY_ACTION_NAMES[a]] = i < probs.size() ? probs[i++] : 0.0;
+        }
+        return result;
+    }
+
+    // Replaces the strategy and drops the raw sums; false if an action name
+    // is not one of STRATEGY_ACTION_NAMES.
+    bool setActionProbs(const std::map<std::string, double>& byName) {
+        double byAction[STRATEGY_NUM_ACTIONS] = {0};
+        actionMask = 0;
+        raw = false;
+        strategySums.clear();
+        regretSums.clear();
+        for (const auto& [name, prob] : byName) {
+            int a = 0;
+            while (a < STRATEGY_NUM_ACTIONS && name != STRATEGY_ACTION_NAMES[a]) a++;
+            if (a == STRATEGY_NUM_ACTIONS) return false;
+            actionMask |= static_cast<uint16_t>(1u << a);
+            byAction[a] = prob;
+        }
+        probs.clear();
+        for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+            if (actionMask >> a & 1) probs.push_back(byAction[a]);
+        }
+        return true;
+    }
+};
+
+inline bool strategyRoundFromName(const std::string& name, uint8_t& round) {
+    for (int r = 0; r < STRATEGY_NUM_ROUNDS; r++) {
+        if (name == STRATEGY_ROUND_NAMES[r]) {
+            round = static_cast<uint8_t>(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool strategyPotFromText(const std::string& text, uint32_t& potTenths) {
+    if (text.empty()) return false;
+    long tenths = std::lround(std::atof(text.c_str()) * 10.0);
+    if (tenths < 0 || tenths > static_cast<long>(UINT32_MAX)) return false;
+    potTenths = static_cast<uint32_t>(tenths);
+    return true;
+}
+
+// Parses "NAME:value|NAME:value" into values in mask order; false if the
+// names are not exactly the actions of mask.
+inline bool parseStrategyRawColumn(const std::string& text, uint16_t mask, std::vector<double>& values) {
+    double byAction[STRATEGY_NUM_ACTIONS] = {0};
+    uint16_t seen = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('|', pos);
+        if (end == std::string::npos) end = text.size();
+        size_t colon = text.find(':', pos);
+        if (colon == std::string::npos || colon > end) return false;
+        int a = 0;
+        while (a < STRATEGY_NUM_ACTIONS && text.compare(pos, colon - pos, STRATEGY_ACTION_NAMES[a]) != 0) a++;
+        if (a == STRATEGY_NUM_ACTIONS) return false;
+        seen |= static_cast<uint16_t>(1u << a);
+        byAction[a] = std::strtod(text.c_str() + colon + 1, nullptr);
+        pos = end + 1;
+    }
+    if (seen != mask) return false;
+    values.clear();
+    for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+        if (mask >> a & 1) values.push_back(byAction[a]);
+    }
+    return true;
+}
+
+// Parses one CSV data line; false for malformed rows or unknown names. The
+// raw sum columns are optional.
+inline bool parseStrategyCsvLine(const std::string& line, StrategyRow& row) {
+    std::string columns[9];
+    int numColumns = 0;
+    size_t start = 0;
+    while (numColumns < 9 && start <= line.size()) {
+        size_t end = numColumns < 8 ? line.find(',', start) : std::string::npos;
+        if (end == std::string::npos) end = line.size();
+        columns[numColumns++] = line.substr(start, end - start);
+        start = end + 1;
+    }
+    if (numColumns < 7) return false;
+    std::string& last = columns[numColumns - 1];
+    if (!last.empty() && last.back() == '\r') last.pop_back();
+
+    if (!strategyRoundFromName(columns[0], row.round)) return false;
+    int player = std::atoi(columns[1].c_str());
+    if (player < 0 || player > 255) return false;
+    row.player = static_cast<uint8_t>(player);
+    row.abstraction = columns[2];
+    row.history = columns[3];
+    if (!strategyPotFromText(columns[5], row.potTenths)) return false;
+    long count = std::atol(columns[6].c_str());
+    row.updateCount = static_cast<uint32_t>(std::max(0L, std::min(count, static_cast<long>(UINT32_MAX))));
+
+    std::map<std::string, double> byName;
+    size_t pos = 0;
+    const std::string& strategy = columns[4];
+    while (pos < strategy.size()) {
+        size_t end = strategy.find('|', pos);
+        if (end == std::string::npos) end = strategy.size();
+        size_t colon = strategy.find(':', pos);
+        if (colon == std::string::npos || colon > end) return false;
+        byName[strategy.substr(pos, colon - pos)] = std::atof(strategy.c_str() + colon + 1);
+        pos = end + 1;
+    }
+    if (!row.setActionProbs(byName)) return false;
+    if (numColumns == 9 && !columns[7].empty()) {
+        row.raw = parseStrategyRawColumn(columns[7], row.actionMask, row.strategySums) &&
+                  parseStrategyRawColumn(columns[8], row.actionMask, row.regretSums);
+    }
+    return true;
+}
+
+inline void appendStrategyRawColumn(const StrategyRow& row, const std::vector<double>& values, std::string& out) {
+    char value[40];
+    size_t i = 0;
+    for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+        if (!(row.actionMask >> a & 1)) continue;
+        if (i > 0) out += '|';
+        out += STRATEGY_ACTION_NAMES[a];
+        std::snprintf(value, sizeof(value), ":%.17g", i < values.size() ? values[i] : 0.0);
+        out += value;
+        i++;
+    }
+}
+
+// Appends the row as a CSV line, probabilities with six decimals. With
+// rawColumns the StrategySum and RegretSum columns follow, empty for rows
+// without raw sums.
+inline void appendStrategyCsvLine(const StrategyRow& row, std::string& out, bool rawColumns = false) {
+    out += STRATEGY_ROUND_NAMES[row.round];
+    out += ',';
+    out += std::to_string(row.player);
+    out += ',';
+    out += row.abstraction;
+    out += ',';
+    out += row.history;
+    out += ',';
+    char prob[32];
+    size_t i = 0;
+    for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+        if (!(row.actionMask >> a & 1)) continue;
+        if (i > 0) out += '|';
+        out += STRATEGY_ACTION_NAMES[a];
+        std::snprintf(prob, sizeof(prob), ":%.6f", i < row.probs.size() ? row.probs[i] : 0.0);
+        out += prob;
+        i++;
+    }
+    out += ',';
+    out += row.potText();
+    out += ',';
+    out += std::to_string(row.updateCount);
+    if (rawColumns) {
+        out += ',';
+        if (row.raw) appendStrategyRawColumn(row, row.strategySums, out);
+        out += ',';
+        if (row.raw) appendStrategyRawColumn(row, row.regretSums, out);
+    }
+    out += '\n';
+}
+
+// True if filename starts with the strategy file magic.
+inline bool isStrategyFile(const std::string& filename) {
+    char magic[sizeof(STRATEGY_FILE_MAGIC)] = {0};
+    std::ifstream probe(filename, std::ios::binary);
+    probe.read(magic, sizeof(magic));
+    return probe && std::memcmp(magic, STRATEGY_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+inline bool hasStrategyFileExtension(const std::string& filename) {
+    size_t length = std::strlen(STRATEGY_FILE_EXTENSION);
+    return filename.size() >= length &&
+           filename.compare(filename.size() - length, length, STRATEGY_FILE_EXTENSION) == 0;
+}
+
+// Streams rows into a strategy file, one block in memory at a time.
+class StrategyFileWriter {
+public:
+    ~StrategyFileWriter() {
+        if (file.is_open()) file.close();
+    }
+
+    // exactProbs stores the probabilities as doubles instead of quantizing;
+    // rawSums adds the strategySum and regretSum columns.
+    bool open(const std::string& filename, uint32_t rowsPerBlock = STRATEGY_FILE_BLOCK_ROWS, bool exactProbs = false,
+              bool rawSums = false) {
+        path = filename;
+        exact = exactProbs;
+        raw = rawSums;
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Unable to write strategy file: " << filename << std::endl;
+            return false;
+        }
+        blockRows = std::max<uint32_t>(rowsPerBlock, 1);
+        std::memset(&header, 0, sizeof(header));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(file);
+    }
+
+    // Adds one row; false if the dictionaries overflow.
+    bool add(const StrategyRow& row) {
+        if (row.round >= STRATEGY_NUM_ROUNDS) return false;
+        uint32_t historyId = intern(histories, historyIds, row.history);
+        uint32_t abstractionId = intern(abstractions, abstractionIds, row.abstraction);
+        if (abstractionId > UINT16_MAX) {
+            std::cerr << "Too many distinct abstractions for " << path << std::endl;
+            return false;
+        }
+
+        if (sorted) {
+            std::string key = row.sortKey();
+            if (header.rows > 0 && key < lastKey) sorted = false;
+            lastKey.swap(key);
+        }
+
+        historyCol.push_back(historyId);
+        potCol.push_back(row.potTenths);
+        countCol.push_back(row.updateCount);
+        abstractionCol.push_back(static_cast<uint16_t>(abstractionId));
+        maskCol.push_back(row.actionMask);
+        roundCol.push_back(row.round);
+        playerCol.push_back(row.player);
+        for (double prob : row.probs) {
+            if (exact) {
+                exactProbCol.push_back(prob);
+                continue;
+            }
+            long q = std::lround(std::max(0.0, std::min(1.0, prob)) * 65535.0);
+            probCol.push_back(static_cast<uint16_t>(q));
+        }
+        if (raw) {
+            bool hasSums = row.raw && row.strategySums.size() == row.probs.size() &&
+                           row.regretSums.size() == row.probs.size();
+            for (size_t i = 0; i < row.probs.size(); i++) {
+                strategySumCol.push_back(hasSums ? row.strategySums[i] : std::nan(""));
+                regretSumCol.push_back(hasSums ? row.regretSums[i] : std::nan(""));
+            }
+        }
+        header.rows++;
+        if (roundCol.size() >= blockRows) flushBlock();
+        return true;
+    }
+
+    // Writes the last block, the dictionaries and the index.
+    bool close() {
+        flushBlock();
+        header.dictionaryOffset = static_cast<uint64_t>(file.tellp());
+        writeDictionary(histories);
+        writeDictionary(abstractions);
+        header.indexOffset = static_cast<uint64_t>(file.tellp());
+        if (!index.empty()) {
+            file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(StrategyBlockEntry));
+        }
+
+        std::memcpy(header.magic, STRATEGY_FILE_MAGIC, sizeof(header.magic));
+        header.version = STRATEGY_FILE_VERSION;
+        header.flags = (sorted ? STRATEGY_FILE_SORTED : 0) | (exact ? STRATEGY_FILE_EXACT : 0) |
+                       (raw ? STRATEGY_FILE_RAW : 0);
+        header.numBlocks = static_cast<uint32_t>(index.size());
+        header.blockRows = blockRows;
+        header.numHistories = static_cast<uint32_t>(histories.size());
+        header.numAbstractions = static_cast<uint32_t>(abstractions.size());
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+        if (!file) {
+            std::cerr << "Error writing strategy file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t rows() const { return header.rows; }
+
+private:
+    static uint32_t intern(std::vector<std::string>& values, std::unordered_map<std::string, uint32_t>& ids,
+                           const std::string& value) {
+        auto it = ids.find(value);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(values.size());
+        values.push_back(value);
+        ids.emplace(value, id);
+        return id;
+    }
+
+    template <typename T>
+    void writeColumn(const std::vector<T>& column) {
+        if (!column.empty()) file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+    }
+
+    void flushBlock() {
+        if (roundCol.empty()) return;
+        StrategyBlockEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.offset = static_cast<uint64_t>(file.tellp());
+        entry.rows = static_cast<uint32_t>(roundCol.size());
+        entry.probCount = static_cast<uint32_t>(exact ? exactProbCol.size() : probCol.size());
+        entry.firstRound = roundCol[0];
+        entry.firstPlayer = playerCol[0];
+        entry.firstAbstraction = abstractionCol[0];
+        entry.firstHistory = historyCol[0];
+        entry.firstPot = potCol[0];
+
+        writeColumn(historyCol);
+        writeColumn(potCol);
+        writeColumn(countCol);
+        writeColumn(abstractionCol);
+        writeColumn(maskCol);
+        writeColumn(roundCol);
+        writeColumn(playerCol);
+        writeColumn(probCol);
+        writeColumn(exactProbCol);
+        writeColumn(strategySumCol);
+        writeColumn(regretSumCol);
+        entry.bytes = static_cast<uint32_t>(static_cast<uint64_t>(file.tellp()) - entry.offset);
+        index.push_back(entry);
+
+        historyCol.clear();
+        potCol.clear();
+        countCol.clear();
+        abstractionCol.clear();
+        maskCol.clear();
+        roundCol.clear();
+        playerCol.clear();
+        probCol.clear();
+        exactProbCol.clear();
+        strategySumCol.clear();
+        regretSumCol.clear();
+    }
+
+    void writeDictionary(const std::vector<std::string>& values) {
+        for (const auto& value : values) {
+            uint32_t length = static_cast<uint32_t>(value.size());
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(value.data(), length);
+        }
+    }
+
+    std::string path;
+    std::ofstream file;
+    StrategyFileHeader header;
+    uint32_t blockRows = STRATEGY_FILE_BLOCK_ROWS;
+    bool sorted = true;
+    bool exact = false;
+    bool raw = false;
+    std::string lastKey;
+
+    std::vector<std::string> histories, abstractions;
+    std::unordered_map<std::string, uint32_t> historyIds, abstractionIds;
+    std::vector<StrategyBlockEntry> index;
+
+    std::vector<uint32_t> historyCol, potCol, countCol;
+    std::vector<uint16_t> abstractionCol, maskCol, probCol;
+    std::vector<double> exactProbCol, strategySumCol, regretSumCol;
+    std::vector<uint8_t> roundCol, playerCol;
+};
+
+// Reads a strategy file block by block.
+class StrategyFileReader {
+public:
+    bool open(const std::string& filename) {
+        path = filename;
+        file.open(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Unable to open strategy file: " << filename << std::endl;
+            return false;
+        }
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, STRATEGY_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << "Not a strategy file: " << filename << std::endl;
+            return false;
+        }
+        if (header.version != STRATEGY_FILE_VERSION) {
+            std::cerr << "Unsupported strategy file version " << header.version << " in " << filename << std::endl;
+            return false;
+        }
+
+        file.seekg(header.dictionaryOffset);
+        if (!readDictionary(header.numHistories, histories) || !readDictionary(header.numAbstractions, abstractions)) {
+            std::cerr << "Corrupt dictionaries in strategy file: " << filename << std::endl;
+            return false;
+        }
+        index.resize(header.numBlocks);
+        file.seekg(header.indexOffset);
+        if (!index.empty()) {
+            file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(StrategyBlockEntry));
+        }
+        if (!file) {
+            std::cerr << "Corrupt block index in strategy file: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t rows() const { return header.rows; }
+    size_t numBlocks() const { return index.size(); }
+    bool sorted() const { return (header.flags & STRATEGY_FILE_SORTED) != 0; }
+    bool exact() const { return (header.flags & STRATEGY_FILE_EXACT) != 0; }
+    bool rawSums() const { return (header.flags & STRATEGY_FILE_RAW) != 0; }
+    size_t numHistories() const { return histories.size(); }
+    size_t numAbstractions() const { return abstractions.size(); }
+    const StrategyBlockEntry& block(size_t b) const { return index[b]; }
+
+    // Decodes block b into rows (replacing their contents).
+    bool readBlock(size_t b, std::vector<StrategyRow>& rows) {
+        const StrategyBlockEntry& entry = index[b];
+        const size_t n = entry.rows;
+        std::vector<char> bytes(entry.bytes);
+        file.clear();
+        file.seekg(entry.offset);
+        file.read(bytes.data(), bytes.size());
+        size_t probBytes = exact() ? sizeof(double) : sizeof(uint16_t);
+        if (rawSums()) probBytes += 2 * sizeof(double);
+        size_t expected = n * (3 * sizeof(uint32_t) + 2 * sizeof(uint16_t) + 2) + entry.probCount * probBytes;
+        if (!file || bytes.size() != expected) {
+            std::cerr << "Corrupt block " << b << " in strategy file: " << path << std::endl;
+            return false;
+        }
+
+        const char* cursor = bytes.data();
+        std::vector<uint32_t> historyCol(n), potCol(n), countCol(n);
+        std::vector<uint16_t> abstractionCol(n), maskCol(n), probCol(exact() ? 0 : entry.probCount);
+        std::vector<double> exactProbCol(exact() ? entry.probCount : 0);
+        std::vector<double> strategySumCol(rawSums() ? entry.probCount : 0), regretSumCol(strategySumCol.size());
+        std::vector<uint8_t> roundCol(n), playerCol(n);
+        readColumn(cursor, historyCol);
+        readColumn(cursor, potCol);
+        readColumn(cursor, countCol);
+        readColumn(cursor, abstractionCol);
+        readColumn(cursor, maskCol);
+        readColumn(cursor, roundCol);
+        readColumn(cursor, playerCol);
+        readColumn(cursor, probCol);
+        readColumn(cursor, exactProbCol);
+        readColumn(cursor, strategySumCol);
+        readColumn(cursor, regretSumCol);
+
+        rows.resize(n);
+        size_t p = 0;
+        for (size_t i = 0; i < n; i++) {
+            StrategyRow& row = rows[i];
+            if (historyCol[i] >= histories.size() || abstractionCol[i] >= abstractions.size() ||
+                roundCol[i] >= STRATEGY_NUM_ROUNDS) {
+                std::cerr << "Corrupt row in block " << b << " of strategy file: " << path << std::endl;
+                return false;
+            }
+            row.round = roundCol[i];
+            row.player = playerCol[i];
+            row.abstraction = abstractions[abstractionCol[i]];
+            row.history = histories[historyCol[i]];
+            row.potTenths = potCol[i];
+            row.actionMask = maskCol[i];
+            row.updateCount = countCol[i];
+            row.probs.clear();
+            row.strategySums.clear();
+            row.regretSums.clear();
+            row.raw = rawSums();
+            for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+                if (!(row.actionMask >> a & 1)) continue;
+                if (p >= entry.probCount) {
+                    std::cerr << "Corrupt probabilities in block " << b << " of strategy file: " << path << std::endl;
+                    return false;
+                }
+                row.probs.push_back(exact() ? exactProbCol[p] : probCol[p] / 65535.0);
+                if (rawSums()) {
+                    if (std::isnan(strategySumCol[p])) row.raw = false;
+                    row.strategySums.push_back(strategySumCol[p]);
+                    row.regretSums.push_back(regretSumCol[p]);
+                }
+                p++;
+            }
+            if (!row.raw) {
+                row.strategySums.clear();
+                row.regretSums.clear();
+            }
+        }
+        return true;
+    }
+
+    // Calls fn(row) for every row in file order; false on a read error.
+    template <typename Fn>
+    bool forEach(Fn fn) {
+        std::vector<StrategyRow> rows;
+        for (size_t b = 0; b < index.size(); b++) {
+            if (!readBlock(b, rows)) return false;
+            for (const auto& row : rows) fn(row);
+        }
+        return true;
+    }
+
+    // Finds the row with sortKey() == key. Sorted files read one block.
+    bool find(const std::string& key, StrategyRow& result) {
+        size_t first = 0, last = index.size();
+        if (sorted() && !index.empty()) {
+            // Last block whose first key is <= key.
+            size_t lo = 0, hi = index.size();
+            while (hi - lo > 1) {
+                size_t mid = (lo + hi) / 2;
+                if (firstKey(mid) <= key) lo = mid;
+                else hi = mid;
+            }
+            first = lo;
+            last = lo + 1;
+        }
+        std::vector<StrategyRow> rows;
+        for (size_t b = first; b < last; b++) {
+            if (!readBlock(b, rows)) return false;
+            for (const auto& row : rows) {
+                if (row.sortKey() == key) {
+                    result = row;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    template <typename T>
+    static void readColumn(const char*& cursor, std::vector<T>& column) {
+        if (column.empty()) return;
+        std::memcpy(column.data(), cursor, column.size() * sizeof(T));
+        cursor += column.size() * sizeof(T);
+    }
+
+    bool readDictionary(uint32_t count, std::vector<std::string>& values) {
+        values.resize(count);
+        for (auto& value : values) {
+            uint32_t length = 0;
+            file.read(reinterpret_cast<char*>(&length), sizeof(length));
+            if (!file || length > (1u << 20)) return false;
+            value.resize(length);
+            file.read(&value[0], length);
+        }
+        return static_cast<bool>(file);
+    }
+
+    std::string firstKey(size_t b) const {
+        const StrategyBlockEntry& entry = index[b];
+        StrategyRow row;
+        row.round = entry.firstRound < STRATEGY_NUM_ROUNDS ? entry.firstRound : 0;
+        row.player = entry.firstPlayer;
+        row.abstraction = entry.firstAbstraction < abstractions.size() ? abstractions[entry.firstAbstraction] : "";
+        row.history = entry.firstHistory < histories.size() ? histories[entry.firstHistory] : "";
+        row.potTenths = entry.firstPot;
+        return row.sortKey();
+    }
+
+    std::string path;
+    std::ifstream file;
+    StrategyFileHeader header;
+    std::vector<std::string> histories, abstractions;
+    std::vector<StrategyBlockEntry> index;
+};
+
+// Reads the rows of a strategy CSV or .sgs file in file order.
+class StrategyRowSource {
+public:
+    bool open(const std::string& filename) {
+        path = filename;
+        binary = isStrategyFile(filename);
+        if (binary) {
+            if (!reader.open(filename)) return false;
+            raw = reader.rawSums();
+            return true;
+        }
+        csv.open(filename);
+        if (!csv.is_open()) {
+            std::cerr << "Unable to open file: " << filename << std::endl;
+            return false;
+        }
+        std::string header;
+        std::getline(csv, header);
+        raw = header.find("StrategySum") != std::string::npos;
+        return true;
+    }
+
+    // True if the file has the raw sum columns (rows may still lack them).
+    bool hasRawSums() const { return raw; }
+
+    // False at the end of the file or on a read error (see failed()).
+    bool next(StrategyRow& row) {
+        if (binary) {
+            while (position >= block.size()) {
+                if (nextBlock >= reader.numBlocks()) return false;
+                if (!reader.readBlock(nextBlock++, block)) {
+                    error = true;
+                    return false;
+                }
+                position = 0;
+            }
+            row = std::move(block[position++]);
+            return true;
+        }
+        std::string line;
+        while (std::getline(csv, line)) {
+            if (line.empty()) continue;
+            if (parseStrategyCsvLine(line, row)) return true;
+            skipped++;
+        }
+        if (csv.bad()) {
+            std::cerr << "Error reading file: " << path << std::endl;
+            error = true;
+        }
+        return false;
+    }
+
+    size_t skippedRows() const { return skipped; }
+
+    // Whether next() stopped on a corrupt block or a read error rather than
+    // at the end of the file.
+    bool failed() const { return error; }
+
+private:
+    std::string path;
+    bool binary = false;
+    bool raw = false;
+    std::ifstream csv;
+    StrategyFileReader reader;
+    std::vector<StrategyRow> block;
+    size_t nextBlock = 0, position = 0, skipped = 0;
+    bool error = false;
+};
+
+// Writes rows as CSV, or as .sgs if the name ends in .sgs (or exactProbs
+// is set). rawSums adds the raw sum columns.
+class StrategyRowSink {
+public:
+    bool open(const std::string& filename, const std::string& csvHeader, bool exactProbs = false,
+              uint32_t blockRows = STRATEGY_FILE_BLOCK_ROWS, bool rawSums = false) {
+        path = filename;
+        raw = rawSums;
+        binary = exactProbs || hasStrategyFileExtension(filename);
+        if (binary) return writer.open(filename, blockRows, exactProbs, rawSums);
+        csv.open(filename, std::ios::binary | std::ios::trunc);
+        if (!csv.is_open()) {
+            std::cerr << "Unable to open output file: " << filename << std::endl;
+            return false;
+        }
+        csv << csvHeader << (rawSums ? STRATEGY_CSV_RAW_COLUMNS : "") << "\n";
+        return true;
+    }
+
+    // Returns false, and close() fails too, if the .sgs writer cannot take
+    // the row (e.g. its abstraction dictionary is full).
+    bool add(const StrategyRow& row) {
+        if (binary) {
+            if (!writer.add(row)) {
+                if (!failed) std::cerr << "Unable to write a row to " << path << std::endl;
+                failed = true;
+                return false;
+            }
+            rows++;
+            return true;
+        }
+        rows++;
+        appendStrategyCsvLine(row, buffer, raw);
+        if (buffer.size() >= (1 << 20)) {
+            csv.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        return true;
+    }
+
+    bool close() {
+        if (binary) return writer.close() && !failed;
+        csv.write(buffer.data(), buffer.size());
+        csv.close();
+        if (!csv) {
+            std::cerr << "Error writing file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t rowCount() const { return rows; }
+
+private:
+    std::string path;
+    bool binary = false;
+    bool raw = false;
+    std::ofstream csv;
+    std::string buffer;
+    StrategyFileWriter writer;
+    uint64_t rows = 0;
+    bool failed = false;
+};
+
+#endif // SPINGO_STRATEGY_FILE_CPP
@@ -0,0 +1,468 @@
+/*
+Parallel external-sort aggregation of strategy files (CSV or .sgs) with
+memory bounded independently of the input size.
+
+  1. The input files are parsed concurrently on the shared scheduler. Every
+     row goes to one of P partitions by a hash of its key. Each partition of
+     each file has a sort buffer; a full buffer is sorted by sortKey(), rows
+     with equal keys are combined, and the result is spilled to tempDir as
+     a sorted run (an exact .sgs file, so no precision is lost between
+     passes). The buffers share memoryBytes.
+  2. The partitions are merged in parallel: the runs of a partition are
+     merged k ways with a heap, at most maxFanIn at a time (more runs are
+     first merged into larger runs), combining equal keys as they meet.
+     memoryBytes is shared by the merges running at once, and a merge holds
+     one block of every run it reads: the runs' block size and the fan-in
+     are derived from that share (see strategyMergeLimits).
+  3. Partition p belongs to output shard p % outputShards. With as many
+     partitions as shards, step 2 writes the shards directly; otherwise the
+     partitions of each shard are merged into it, again in parallel. Keys
+     of different partitions are disjoint, so this only interleaves them.
+
+Every shard is in key order. P is the larger of outputShards and the
+scheduler's concurrency, rounded up to a multiple of outputShards. Shards
+are named out.<i>.csv (or .sgs) when there is more than one.
+
+Rows that carry raw sums (trainers' --raw-sums) are combined exactly: the
+strategySum and regretSum of every action are added up and the probability
+is the summed strategySum normalized, as Node::getAverageStrategy computes
+it. Aggregating independent runs this way gives the sums of one longer run,
+and the output, which keeps the sums when every input has them, can warm
+start further training. Keys that have a row without raw sums fall back to
+the weighted average the aggregator always did: each row weighs its update
+count minus updateCountOffset (the trainers whose counts start at 1 use an
+offset of 1), actions missing from a row count as 0 in it, and rows whose
+weights are all 0 keep the probabilities of the first of them. Either way
+the output count is the summed weight plus the offset.
+*/
+
+#ifndef SPINGO_STRATEGY_MERGE_CPP
+#define SPINGO_STRATEGY_MERGE_CPP
+
+#include "strategy_file.cpp"
+#include "scheduler.cpp"
+#include <filesystem>
+#include <memory>
+#include <queue>
+
+struct StrategyMergeOptions {
+    size_t memoryBytes = size_t(512) << 20;  // sort buffers, then merge buffers
+    int maxFanIn = 64;                       // runs merged at once, at most
+    int updateCountOffset = 0;               // initial count included in every row
+    std::string tempDir;                     // default: <output>.runs
+    std::string csvHeader = STRATEGY_CSV_HEADER;
+    int outputShards = 1;                    // output files
+    int threads = 0;                         // scheduler threads (0 = all cores) if it is not running yet
+};
+
+// Approximate memory of a buffered row, for the sort budget.
+inline size_t strategyRowBytes(const StrategyRow& row) {
+    return sizeof(StrategyRow) + row.abstraction.capacity() + row.history.capacity() +
+           (row.probs.capacity() + row.strategySums.capacity() + row.regretSums.capacity()) * sizeof(double) + 64;
+}
+
+// Estimated memory of a decoded row in a run block.
+static const size_t STRATEGY_MERGE_ROW_BYTES = sizeof(StrategyRow) + 192;
+
+// Block size of the runs and fan-in of the merges, chosen so that one merge
+// (a decoded block of each run it reads, one block of the run it writes and
+// reservedBytes of output buffer) stays within budgetBytes. Blocks shrink
+// first, down to 64 rows; then the fan-in, down to 2, which only costs merge
+// passes. Dictionaries of the runs come on top.
+struct StrategyMergeLimits {
+    uint32_t runBlockRows = 4096;
+    size_t fanIn = 64;
+};
+
+inline StrategyMergeLimits strategyMergeLimits(size_t budgetBytes, size_t reservedBytes, int maxFanIn) {
+    StrategyMergeLimits limits;
+    const size_t maxFan = static_cast<size_t>(std::max(maxFanIn, 2));
+    const size_t available = budgetBytes > reservedBytes ? budgetBytes - reservedBytes : 0;
+    size_t rows = available / ((maxFan + 1) * STRATEGY_MERGE_ROW_BYTES);
+    limits.runBlockRows = static_cast<uint32_t>(std::max<size_t>(64, std::min<size_t>(4096, rows)));
+    size_t blocks = available / (static_cast<size_t>(limits.runBlockRows) * STRATEGY_MERGE_ROW_BYTES);
+    limits.fanIn = std::max<size_t>(2, std::min(maxFan, blocks > 0 ? blocks - 1 : 0));
+    return limits;
+}
+
+// Combines the rows of one key: raw sums added up, or a weighted average.
+class StrategyAccumulator {
+public:
+    explicit StrategyAccumulator(int offset) : updateCountOffset(offset) {}
+
+    bool empty() const { return count == 0; }
+
+    void add(const StrategyRow& row) {
+        double weight = std::max(0.0, static_cast<double>(row.updateCount) - updateCountOffset);
+        allRaw = (count == 0 || allRaw) && row.raw;
+        if (count++ == 0) first = row;
+        size_t i = 0;
+        for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+            if (!(row.actionMask >> a & 1)) continue;
+            sums[a] += (i < row.probs.size() ? row.probs[i] : 0.0) * weight;
+            if (row.raw && i < row.strategySums.size() && i < row.regretSums.size()) {
+                strategySums[a] += row.strategySums[i];
+                regretSums[a] += row.regretSums[i];
+            }
+            i++;
+        }
+        mask |= row.actionMask;
+        totalWeight += weight;
+    }
+
+    // Writes the combined row to out and resets.
+    void finish(StrategyRow& out) {
+        out = std::move(first);
+        out.raw = allRaw;
+        out.strategySums.clear();
+        out.regretSums.clear();
+        if (allRaw) {
+            double total = 0.0;
+            int numActions = 0;
+            for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+                if (!(mask >> a & 1)) continue;
+                total += strategySums[a];
+                numActions++;
+            }
+            out.actionMask = mask;
+            out.probs.clear();
+            for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+                if (!(mask >> a & 1)) continue;
+                out.probs.push_back(total > 0 ? strategySums[a] / total : 1.0 / numActions);
+                out.strategySums.push_back(strategySums[a]);
+                out.regretSums.push_back(regretSums[a]);
+            }
+        } else if (totalWeight > 0) {
+            out.actionMask = mask;
+            out.probs.clear();
+            for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+                if (mask >> a & 1) out.probs.push_back(sums[a] / totalWeight);
+            }
+        }
+        double updates = std::min(totalWeight + updateCountOffset, static_cast<double>(UINT32_MAX));
+        out.updateCount = static_cast<uint32_t>(std::llround(updates));
+        std::fill(sums, sums + STRATEGY_NUM_ACTIONS, 0.0);
+        std::fill(strategySums, strategySums + STRATEGY_NUM_ACTIONS, 0.0);
+        std::fill(regretSums, regretSums + STRATEGY_NUM_ACTIONS, 0.0);
+        mask = 0;
+        totalWeight = 0.0;
+        count = 0;
+    }
+
+private:
+    int updateCountOffset;
+    StrategyRow first;
+    double sums[STRATEGY_NUM_ACTIONS] = {0};
+    double strategySums[STRATEGY_NUM_ACTIONS] = {0};
+    double regretSums[STRATEGY_NUM_ACTIONS] = {0};
+    bool allRaw = false;
+    uint16_t mask = 0;
+    double totalWeight = 0.0;
+    size_t count = 0;
+};
+
+// Temporary directory of sorted runs, shared by all buffers of one
+// aggregation. The directory is removed when empty at destruction. Runs
+// keep raw sums if any input has them.
+class StrategyRunDir {
+public:
+    StrategyRunDir(const std::string& dir, bool rawSums) : path(dir), raw(rawSums) {}
+
+    bool rawSums() const { return raw; }
+
+    ~StrategyRunDir() {
+        std::error_code error;
+        if (created) std::filesystem::remove(path, error);
+    }
+
+    std::string newRun() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!created) {
+            std::error_code error;
+            created = std::filesystem::create_directories(path, error);
+        }
+        return path + "/run" + std::to_string(counter++) + STRATEGY_FILE_EXTENSION;
+    }
+
+private:
+    std::string path;
+    bool raw;
+    std::mutex mutex;
+    size_t counter = 0;
+    bool created = false;
+};
+
+// Sorts the rows of one partition of one input into runs.
+class StrategyRunWriter {
+public:
+    StrategyRunWriter(StrategyRunDir& dir, size_t memoryBytes, int updateCountOffset, uint32_t runBlockRows)
+        : runDir(dir), limit(memoryBytes), blockRows(runBlockRows), accumulator(updateCountOffset) {}
+
+    // Buffers one row, spilling a sorted run when the buffer is full.
+    bool add(StrategyRow&& row) {
+        bufferBytes += strategyRowBytes(row);
+        buffer.push_back(std::move(row));
+        if (bufferBytes >= limit) return spill();
+        return true;
+    }
+
+    // Spills the rest and appends all runs written to runs.
+    bool finish(std::vector<std::string>& runs) {
+        bool ok = spill();
+        runs.insert(runs.end(), written.begin(), written.end());
+        written.clear();
+        return ok;
+    }
+
+private:
+    bool spill() {
+        if (buffer.empty()) return true;
+        std::vector<std::pair<std::string, size_t>> order(buffer.size());
+        for (size_t i = 0; i < buffer.size(); i++) order[i] = {buffer[i].sortKey(), i};
+        std::sort(order.begin(), order.end());
+
+        std::string run = runDir.newRun();
+        StrategyRowSink sink;
+        if (!sink.open(run, "", true, blockRows, runDir.rawSums())) return false;
+        StrategyRow combined;
+        bool ok = true;
+        for (size_t i = 0; ok && i < order.size(); i++) {
+            accumulator.add(buffer[order[i].second]);
+            if (i + 1 == order.size() || order[i + 1].first != order[i].first) {
+                accumulator.finish(combined);
+                ok = sink.add(combined);
+            }
+        }
+        buffer.clear();
+        buffer.shrink_to_fit();
+        bufferBytes = 0;
+        written.push_back(run);
+        return sink.close() && ok;
+    }
+
+    StrategyRunDir& runDir;
+    size_t limit;
+    uint32_t blockRows;
+    StrategyAccumulator accumulator;
+    std::vector<StrategyRow> buffer;
+    size_t bufferBytes = 0;
+    std::vector<std::string> written;
+};
+
+// k-way merge of sorted runs into sink, combining equal keys.
+inline bool mergeSortedRuns(const std::vector<std::string>& inputs, StrategyRowSink& sink, int updateCountOffset) {
+    struct Head {
+        std::string key;
+        size_t source;
+        bool operator>(const Head& other) const {
+            return key != other.key ? key > other.key : source > other.source;
+        }
+    };
+    std::vector<std::unique_ptr<StrategyRowSource>> sources;
+    std::vector<StrategyRow> heads(inputs.size());
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+    for (size_t s = 0; s < inputs.size(); s++) {
+        sources.emplace_back(new StrategyRowSource());
+        if (!sources[s]->open(inputs[s])) return false;
+        if (sources[s]->next(heads[s])) heap.push(Head{heads[s].sortKey(), s});
+    }
+
+    StrategyAccumulator accumulator(updateCountOffset);
+    std::string currentKey;
+    StrategyRow combined;
+    while (!heap.empty()) {
+        Head head = heap.top();
+        heap.pop();
+        if (!accumulator.empty() && head.key != currentKey) {
+            accumulator.finish(combined);
+            if (!sink.add(combined)) return false;
+        }
+        currentKey.swap(head.key);
+        accumulator.add(heads[head.source]);
+        if (sources[head.source]->next(heads[head.source])) {
+            heap.push(Head{heads[head.source].sortKey(), head.source});
+        }
+    }
+    if (!accumulator.empty()) {
+        accumulator.finish(combined);
+        return sink.add(combined);
+    }
+    return true;
+}
+
+// Merges runs into sink, in several passes if there are more than
+// limits.fanIn. The runs are removed.
+inline bool mergeRunsInto(std::vector<std::string> runs, StrategyRowSink& sink, StrategyRunDir& runDir,
+                          const StrategyMergeOptions& options, const StrategyMergeLimits& limits) {
+    const size_t fanIn = limits.fanIn;
+    bool ok = true;
+    std::error_code error;
+    while (ok && runs.size() > fanIn) {
+        std::vector<std::string> next;
+        for (size_t i = 0; ok && i < runs.size(); i += fanIn) {
+            std::vector<std::string> group(runs.begin() + i, runs.begin() + std::min(runs.size(), i + fanIn));
+            std::string run = runDir.newRun();
+            StrategyRowSink runSink;
+            ok = runSink.open(run, "", true, limits.runBlockRows, runDir.rawSums()) &&
+                 mergeSortedRuns(group, runSink, options.updateCountOffset) && runSink.close();
+            for (const auto& done : group) std::filesystem::remove(done, error);
+            next.push_back(run);
+        }
+        runs.swap(next);
+    }
+    ok = ok && mergeSortedRuns(runs, sink, options.updateCountOffset);
+    for (const auto& done : runs) std::filesystem::remove(done, error);
+    return ok;
+}
+
+// Name of output shard i of n: the output itself if n is 1, else
+// out.<i>.csv for out.csv.
+inline std::string strategyShardPath(const std::string& output, int shard, int numShards) {
+    if (numShards <= 1) return output;
+    size_t dot = output.find_last_of('.');
+    size_t slash = output.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return output + "." + std::to_string(shard);
+    }
+    return output.substr(0, dot) + "." + std::to_string(shard) + output.substr(dot);
+}
+
+// Aggregates the inputs (strategy CSVs or .sgs files, in any order) into
+// options.outputShards files named by strategyShardPath, written as .sgs if
+// outputFile ends in .sgs and as CSV otherwise. Fails, writing no output, if
+// an input cannot be opened or read to its end (rows that do not parse are
+// only counted).
+inline bool mergeStrategyFiles(const std::vector<std::string>& inputFiles, const std::string& outputFile,
+                               const StrategyMergeOptions& options = StrategyMergeOptions()) {
+    WorkStealingScheduler& scheduler = sharedScheduler(options.threads > 0 ? options.threads - 1 : 0);
+    const int numShards = std::max(options.outputShards, 1);
+    const int concurrency = scheduler.concurrency();
+    const int numPartitions = (std::max(numShards, concurrency) + numShards - 1) / numShards * numShards;
+    const size_t bufferBytes = options.memoryBytes / (static_cast<size_t>(concurrency) * numPartitions);
+
+    // Raw sums are kept in the runs if any input has them, and in the output
+    // if every input does.
+    bool anyRaw = false, allRaw = !inputFiles.empty();
+    for (const auto& filename : inputFiles) {
+        StrategyRowSource probe;
+        bool raw = probe.open(filename) && probe.hasRawSums();
+        anyRaw = anyRaw || raw;
+        allRaw = allRaw && raw;
+    }
+
+    // Up to concurrency partitions (then shards) are merged at once, each
+    // writing a run or a shard whose buffer is one .sgs block or the CSV
+    // writer's buffer
+    const size_t concurrentMerges = static_cast<size_t>(std::max(1, std::min(concurrency, numPartitions)));
+    const size_t shardBufferBytes = hasStrategyFileExtension(outputFile)
+        ? STRATEGY_FILE_BLOCK_ROWS * (16 + STRATEGY_NUM_ACTIONS * (allRaw ? 3 * sizeof(double) : sizeof(uint16_t)))
+        : size_t(2) << 20;
+    const StrategyMergeLimits limits =
+        strategyMergeLimits(options.memoryBytes / concurrentMerges, shardBufferBytes, options.maxFanIn);
+
+    StrategyRunDir runDir(options.tempDir.empty() ? outputFile + ".runs" : options.tempDir, anyRaw);
+    std::vector<std::vector<std::string>> partitionRuns(numPartitions);
+    std::mutex runsMutex, logMutex;
+    std::atomic<size_t> skipped(0);
+    std::atomic<bool> failed(false);
+
+    // 1. Parse the inputs concurrently into sorted runs per partition.
+    scheduler.parallelFor(0, static_cast<long>(inputFiles.size()), 1, [&](long begin, long end) {
+        for (long f = begin; f < end; f++) {
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cout << "Processing file: " << inputFiles[f] << std::endl;
+            }
+            StrategyRowSource source;
+            if (!source.open(inputFiles[f])) {
+                failed = true;
+                continue;
+            }
+            std::vector<std::unique_ptr<StrategyRunWriter>> writers;
+            for (int p = 0; p < numPartitions; p++) {
+                writers.emplace_back(
+                    new StrategyRunWriter(runDir, bufferBytes, options.updateCountOffset, limits.runBlockRows));
+            }
+            std::hash<std::string> hash;
+            StrategyRow row;
+            while (source.next(row)) {
+                size_t p = hash(row.sortKey()) % numPartitions;
+                if (!writers[p]->add(std::move(row))) failed = true;
+            }
+            if (source.failed()) failed = true;
+            skipped += source.skippedRows();
+            std::lock_guard<std::mutex> lock(runsMutex);
+            for (int p = 0; p < numPartitions; p++) {
+                if (!writers[p]->finish(partitionRuns[p])) failed = true;
+            }
+        }
+    });
+
+    // 2. Merge every partition, straight into its shard if it has one.
+    // Nothing is written when an input failed
+    const bool direct = numPartitions == numShards;
+    const bool writeOutput = !failed;
+    std::vector<std::string> partitionFiles(numPartitions);
+    std::vector<uint64_t> shardRows(numShards, 0);
+    scheduler.parallelFor(0, writeOutput ? numPartitions : 0, 1, [&](long begin, long end) {
+        for (long p = begin; p < end; p++) {
+            StrategyRowSink sink;
+            bool opened;
+            if (direct) {
+                opened = sink.open(strategyShardPath(outputFile, static_cast<int>(p), numShards), options.csvHeader,
+                                   false, STRATEGY_FILE_BLOCK_ROWS, allRaw);
+            } else {
+                partitionFiles[p] = runDir.newRun();
+                opened = sink.open(partitionFiles[p], "", true, limits.runBlockRows, anyRaw);
+            }
+            if (!opened || !mergeRunsInto(partitionRuns[p], sink, runDir, options, limits) || !sink.close()) {
+                failed = true;
+            }
+            if (direct) shardRows[p] = sink.rowCount();
+        }
+    });
+
+    // 3. Interleave the partitions of every shard.
+    if (writeOutput && !direct) {
+        scheduler.parallelFor(0, numShards, 1, [&](long begin, long end) {
+            for (long s = begin; s < end; s++) {
+                std::vector<std::string> parts;
+                for (int p = static_cast<int>(s); p < numPartitions; p += numShards) parts.push_back(partitionFiles[p]);
+                StrategyRowSink sink;
+                if (!sink.open(strategyShardPath(outputFile, static_cast<int>(s), numShards), options.csvHeader, false,
+                               STRATEGY_FILE_BLOCK_ROWS, allRaw) ||
+                    !mergeRunsInto(parts, sink, runDir, options, limits) || !sink.close()) {
+                    failed = true;
+                }
+                shardRows[s] = sink.rowCount();
+            }
+        });
+    }
+
+    if (failed) {
+        std::error_code error;
+        for (const auto& runs : partitionRuns) {
+            for (const auto& run : runs) std::filesystem::remove(run, error);
+        }
+        for (const auto& part : partitionFiles) {
+            if (!part.empty()) std::filesystem::remove(part, error);
+        }
+        // No partial blueprint is left behind
+        for (int s = 0; writeOutput && s < numShards; s++) {
+            std::filesystem::remove(strategyShardPath(outputFile, s, numShards), error);
+        }
+        std::cerr << "Aggregation into " << outputFile << " failed" << std::endl;
+        return false;
+    }
+    uint64_t rows = 0;
+    for (uint64_t count : shardRows) rows += count;
+    std::cout << "Aggregated " << rows << " strategies to " << outputFile;
+    if (numShards > 1) {
+        std::cout << " (" << numShards << " shards: " << strategyShardPath(outputFile, 0, numShards) << " ...)";
+    }
+    if (skipped > 0) std::cout << " (" << skipped << " unreadable rows skipped)";
+    std::cout << std::endl;
+    return true;
+}
+
+#endif // SPINGO_STRATEGY_MERGE_CPP
@@ -0,0 +1,654 @@
+/*
+Read-only strategy store: a blueprint compiled into one memory-mapped file
+and queried by game state.
+
+writeStrategyStore() compiles any StrategyProfile (a strategy CSV, an
+--aggregate result or a checkpoint) into the file. Each row is keyed by its
+integer fields: round index, player, abstraction (preflop class 0-168 or
+cluster bucket), pot in tenths of a big blind, and the round's action
+history packed one byte per action (player << 5 | action). The FNV-1a hash
+of those fields indexes the row. The fields are stored in the record as well
+and compared on lookup, which resolves hash collisions.
+
+File layout (host byte order):
+  header     magic "SGSTORE1", uint32 version, uint32 reserved, uint64 rows,
+             uint64 record bytes
+  directory  65537 x uint32: first index slot of each 16-bit hash prefix
+  index      rows x {uint64 hash, uint64 record offset}, sorted by hash
+  records    uint8 round, uint8 player, uint16 abstraction, uint32 pot
+             tenths, uint32 weight, uint8 history length, uint8 action
+             count, history bytes, action bytes, uint16 probabilities
+             (p * 65535)
+
+A lookup reads one directory entry and binary-searches the few index slots
+sharing the prefix; it does not allocate. The mapping is read-only and
+shared, so every process querying the same file shares one copy in the page
+cache. A rebuild writes a new file and renames it over the old one;
+processes that mapped the old file keep reading it until they reopen.
+
+query(state) does the abstraction itself: the preflop class of the acting
+player's cards or the bucket from the PostflopBucketFn, the current round's
+history and the pot. Probabilities are restricted to the state's legal
+actions and renormalized. An unknown infoset, or one with no mass on a legal
+action, gets a uniform strategy and query() returns false. Call
+preloadClusters() before querying from several threads.
+
+serveStrategyStore() answers one request per line on a Unix domain socket:
+  <hand> <board or -> <actions since the blinds, or ->
+  e.g. "AhKd 7c2s9d P2:BET_2|P0:CALL|P1:CALL|P0:CHECK"
+The hand belongs to the player to act after the actions. Replies:
+  OK <action>:<prob>|...    the stored strategy
+  MISS <action>:<prob>|...  no row for this infoset, uniform over legal actions
+  ERR <message>
+Each connection gets a thread; requests sent back to back are answered in
+one write.
+*/
+
+#ifndef SPINGO_STRATEGY_STORE_CPP
+#define SPINGO_STRATEGY_STORE_CPP
+
+#include "subgame_solver.cpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char STORE_MAGIC[8] = {'S', 'G', 'S', 'T', 'O', 'R', 'E', '1'};
+static const uint32_t STORE_VERSION = 1;
+static const int STORE_MAX_HISTORY = 64;
+static const int STORE_MAX_ACTIONS = 16;
+static const int STORE_DIRECTORY_SIZE = 65537;
+static const size_t STORE_HEADER_BYTES = 32;
+static const size_t STORE_RECORD_HEADER_BYTES = 14;
+
+struct StoreKey {
+    uint8_t round = 0;
+    uint8_t player = 0;
+    uint16_t abstraction = 0;
+    uint32_t potTenths = 0;
+    uint8_t historyLength = 0;
+    uint8_t history[STORE_MAX_HISTORY];
+
+    bool addAction(int actor, Action action) {
+        if (historyLength >= STORE_MAX_HISTORY) return false;
+        history[historyLength++] = static_cast<uint8_t>(actor << 5 | static_cast<int>(action));
+        return true;
+    }
+
+    uint64_t hash() const {
+        uint8_t fields[9] = {round, player};
+        std::memcpy(fields + 2, &abstraction, sizeof(abstraction));
+        std::memcpy(fields + 4, &potTenths, sizeof(potTenths));
+        fields[8] = historyLength;
+        uint64_t h = 1469598103934665603ULL;
+        for (uint8_t b : fields) h = (h ^ b) * 1099511628211ULL;
+        for (int i = 0; i < historyLength; i++) h = (h ^ history[i]) * 1099511628211ULL;
+        return h;
+    }
+};
+
+// One decoded row
+struct StoreEntry {
+    int numActions = 0;
+    Action actions[STORE_MAX_ACTIONS];
+    double probs[STORE_MAX_ACTIONS];
+    uint32_t weight = 0;
+};
+
+// Pot in tenths of a big blind, rounded as the trainer prints it ("%.1f").
+inline uint32_t potTenthsFromText(const std::string& pot) {
+    return static_cast<uint32_t>(std::llround(std::atof(pot.c_str()) * 10.0));
+}
+
+inline uint32_t potTenthsOf(double pot) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", pot);
+    return potTenthsFromText(text);
+}
+
+// Preflop class of a label such as "AKs" or "27o", or -1.
+inline int preflopClassFromLabel(const std::string& label) {
+    static const std::unordered_map<std::string, int> classes = [] {
+        std::unordered_map<std::string, int> byLabel;
+        for (int cls = 0; cls < NUM_PREFLOP_CLASSES; cls++) byLabel[preflopClassLabel(cls)] = cls;
+        return byLabel;
+    }();
+    auto it = classes.find(label);
+    return it == classes.end() ? -1 : it->second;
+}
+
+// Fills key from the text fields of a strategy row. Returns false for rows
+// the store cannot represent.
+inline bool storeKeyFromFields(const std::string& round, const std::string& player, const std::string& abstraction,
+                               const std::string& previousActions, const std::string& pot, StoreKey& key) {
+    int r = roundIndex(round);
+    int p = std::atoi(player.c_str());
+    if (r > 3 || p < 0 || p >= NUM_PLAYERS) return false;
+    int bucket = r == 0 ? preflopClassFromLabel(abstraction) : std::atoi(abstraction.c_str());
+    if (bucket < 0 || bucket > 0xFFFF) return false;
+    std::vector<std::pair<int, Action>> history;
+    if (!parseActionHistory(previousActions, history)) return false;
+
+    key.round = static_cast<uint8_t>(r);
+    key.player = static_cast<uint8_t>(p);
+    key.abstraction = static_cast<uint16_t>(bucket);
+    key.potTenths = potTenthsFromText(pot);
+    key.historyLength = 0;
+    for (const auto& step : history) {
+        if (!key.addAction(step.first, step.second)) return false;
+    }
+    return true;
+}
+
+// Compiles profile into a store file. Rows whose fields do not fit the store
+// are skipped and counted in skipped.
+bool writeStrategyStore(const StrategyProfile& profile, const std::string& filename, size_t& skipped) {
+    struct Slot {
+        uint64_t hash;
+        uint64_t offset;
+    };
+    std::vector<Slot> index;
+    std::string records;
+    skipped = 0;
+
+    index.reserve(profile.size());
+    profile.forEach([&](const std::string& rowKey, const std::map<std::string, double>& actionProbs, double weight) {
+        std::vector<std::string> fields;
+        std::stringstream ss(rowKey);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+        StoreKey key;
+        if (fields.size() != 5 || !storeKeyFromFields(fields[0], fields[1], fields[2], fields[3], fields[4], key) ||
+            actionProbs.empty() || actionProbs.size() > static_cast<size_t>(STORE_MAX_ACTIONS)) {
+            skipped++;
+            return;
+        }
+        std::vector<Action> actions;
+        std::vector<double> probs;
+        double total = 0.0;
+        for (const auto& [name, prob] : actionProbs) {
+            Action action = actionFromString(name);
+            if (action == Action::UNKNOWN) {
+                skipped++;
+                return;
+            }
+            actions.push_back(action);
+            probs.push_back(std::max(0.0, prob));
+            total += probs.back();
+        }
+
+        index.push_back(Slot{key.hash(), records.size()});
+        uint32_t count = static_cast<uint32_t>(std::min(weight, 4294967295.0));
+        char header[STORE_RECORD_HEADER_BYTES];
+        header[0] = static_cast<char>(key.round);
+        header[1] = static_cast<char>(key.player);
+        std::memcpy(header + 2, &key.abstraction, 2);
+        std::memcpy(header + 4, &key.potTenths, 4);
+        std::memcpy(header + 8, &count, 4);
+        header[12] = static_cast<char>(key.historyLength);
+        header[13] = static_cast<char>(actions.size());
+        records.append(header, sizeof(header));
+        records.append(reinterpret_cast<const char*>(key.history), key.historyLength);
+        for (Action action : actions) records.push_back(static_cast<char>(action));
+        for (double prob : probs) {
+            double share = total > 0.0 ? prob / total : 1.0 / probs.size();
+            uint16_t q = static_cast<uint16_t>(std::lround(share * 65535.0));
+            records.append(reinterpret_cast<const char*>(&q), 2);
+        }
+    });
+
+    std::sort(index.begin(), index.end(), [](const Slot& a, const Slot& b) { return a.hash < b.hash; });
+    std::vector<uint32_t> directory(STORE_DIRECTORY_SIZE);
+    size_t slot = 0;
+    for (int prefix = 0; prefix < STORE_DIRECTORY_SIZE; prefix++) {
+        while (slot < index.size() && (index[slot].hash >> 48) < static_cast<uint64_t>(prefix)) slot++;
+        directory[prefix] = static_cast<uint32_t>(slot);
+    }
+
+    std::string tempName = filename + ".tmp";
+    std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open store file for writing: " << tempName << std::endl;
+        return false;
+    }
+    uint64_t rows = index.size();
+    uint64_t recordBytes = records.size();
+    uint32_t reserved = 0;
+    out.write(STORE_MAGIC, sizeof(STORE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&STORE_VERSION), sizeof(STORE_VERSION));
+    out.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    out.write(reinterpret_cast<const char*>(&recordBytes), sizeof(recordBytes));
+    out.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));  // aligns the index to 8 bytes
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Slot));
+    out.write(records.data(), records.size());
+    out.close();
+    if (!out || std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to write store file: " << filename << std::endl;
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+class StrategyStore {
+public:
+    explicit StrategyStore(PostflopBucketFn bucketFn) : bucketFn(bucketFn) {}
+    ~StrategyStore() { close(); }
+
+    StrategyStore(const StrategyStore&) = delete;
+    StrategyStore& operator=(const StrategyStore&) = delete;
+
+    // Maps a file written by writeStrategyStore().
+    bool open(const std::string& filename);
+    void close();
+
+    size_t size() const { return static_cast<size_t>(rows); }
+
+    // The row with exactly these fields, if any.
+    bool lookup(const StoreKey& key, StoreEntry& entry) const;
+
+    // The key of the infoset the player to act is in at state.
+    bool keyFor(const SpinGoState& state, StoreKey& key) const;
+
+    // (action, probability) over the legal actions at state. Returns false,
+    // with a uniform strategy, if the store has nothing for the infoset.
+    bool query(const SpinGoState& state, std::vector<std::pair<Action, double>>& probs) const;
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint64_t offset;
+    };
+
+    PostflopBucketFn bucketFn;
+    char* mapping = nullptr;
+    size_t mappedSize = 0;
+    uint64_t rows = 0;
+    uint64_t recordBytes = 0;
+    const uint32_t* directory = nullptr;
+    const Slot* index = nullptr;
+    const char* records = nullptr;
+};
+
+bool StrategyStore::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Unable to open store file: " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < STORE_HEADER_BYTES) {
+        std::cerr << "Store file is too small: " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "Unable to map store file: " << filename << std::endl;
+        return false;
+    }
+    mapping = static_cast<char*>(p);
+    mappedSize = static_cast<size_t>(st.st_size);
+    madvise(mapping, mappedSize, MADV_RANDOM);
+
+    uint32_t version;
+    std::memcpy(&version, mapping + 8, sizeof(version));
+    std::memcpy(&rows, mapping + 16, sizeof(rows));
+    std::memcpy(&recordBytes, mapping + 24, sizeof(recordBytes));
+    size_t indexOffset = STORE_HEADER_BYTES + STORE_DIRECTORY_SIZE * sizeof(uint32_t) + sizeof(uint32_t);
+    size_t recordOffset = indexOffset + rows * sizeof(Slot);
+    if (std::memcmp(mapping, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 || version != STORE_VERSION ||
+        recordOffset + recordBytes != mappedSize) {
+        std::cerr << "Not a strategy store file (or a truncated one): " << filename << std::endl;
+        close();
+        return false;
+    }
+    directory = reinterpret_cast<const uint32_t*>(mapping + STORE_HEADER_BYTES);
+    index = reinterpret_cast<const Slot*>(mapping + indexOffset);
+    records = mapping + recordOffset;
+    return true;
+}
+
+void StrategyStore::close() {
+    if (mapping) munmap(mapping, mappedSize);
+    mapping = nullptr;
+    mappedSize = 0;
+    rows = 0;
+}
+
+bool StrategyStore::lookup(const StoreKey& key, StoreEntry& entry) const {
+    if (!mapping) return false;
+    uint64_t hash = key.hash();
+    uint32_t prefix = static_cast<uint32_t>(hash >> 48);
+    const Slot* first = index + directory[prefix];
+    const Slot* last = index + directory[prefix + 1];
+    const Slot* it = std::lower_bound(first, last, hash, [](const Slot& s, uint64_t h) { return s.hash < h; });
+    for (; it != last && it->hash == hash; ++it) {
+        if (it->offset + STORE_RECORD_HEADER_BYTES > recordBytes) continue;
+        const unsigned char* record = reinterpret_cast<const unsigned char*>(records + it->offset);
+        uint16_t abstraction;
+        uint32_t potTenths;
+        std::memcpy(&abstraction, record + 2, 2);
+        std::memcpy(&potTenths, record + 4, 4);
+        int historyLength = record[12];
+        int numActions = record[13];
+        if (record[0] != key.round || record[1] != key.player || abstraction != key.abstraction ||
+            potTenths != key.potTenths || historyLength != key.historyLength ||
+            std::memcmp(record + STORE_RECORD_HEADER_BYTES, key.history, historyLength) != 0) {
+            continue;
+        }
+        const unsigned char* actions = record + STORE_RECORD_HEADER_BYTES + historyLength;
+        const unsigned char* probs = actions + numActions;
+        entry.numActions = std::min(numActions, STORE_MAX_ACTIONS);
+        std::memcpy(&entry.weight, record + 8, 4);
+        for (int a = 0; a < entry.numActions; a++) {
+            uint16_t q;
+            std::memcpy(&q, probs + 2 * a, 2);
+            entry.actions[a] = static_cast<Action>(actions[a]);
+            entry.probs[a] = q / 65535.0;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool StrategyStore::keyFor(const SpinGoState& state, StoreKey& key) const {
+    if (state.game_over || state.is_chance_node()) return false;
+    int r = roundIndex(state.round);
+    int player = state.current_player();
+    if (r > 3 || player < 0) return false;
+    int hole1 = cardIndexFromStrings(state.cards[player * 2].rank, state.cards[player * 2].suit);
+    int hole2 = cardIndexFromStrings(state.cards[player * 2 + 1].rank, state.cards[player * 2 + 1].suit);
+    int bucket;
+    if (r == 0) {
+        bucket = preflopClassIndex(hole1, hole2);
+    } else {
+        int board[5] = {-1, -1, -1, -1, -1};
+        for (size_t i = 0; i < state.community_cards.size() && i < 5; i++) {
+            board[i] = cardIndexFromStrings(state.community_cards[i].rank, state.community_cards[i].suit);
+        }
+        bucket = std::max(0, bucketFn(r, hole1, hole2, board));
+    }
+
+    key.round = static_cast<uint8_t>(r);
+    key.player = static_cast<uint8_t>(player);
+    key.abstraction = static_cast<uint16_t>(bucket);
+    double totalPot = 0.0;
+    for (int p = 0; p < NUM_PLAYERS; p++) totalPot += state.pot[p] + state.cumulative_pot[p];
+    key.potTenths = potTenthsOf(totalPot);
+    key.historyLength = 0;
+    for (int i = 0; i < state.action_history.round_length(); i++) {
+        if (!key.addAction(state.action_history.player(i), state.action_history.action(i))) return false;
+    }
+    return true;
+}
+
+bool StrategyStore::query(const SpinGoState& state, std::vector<std::pair<Action, double>>& probs) const {
+    probs.clear();
+    if (state.game_over || state.is_chance_node()) return false;
+    StoreKey key;
+    StoreEntry entry;
+    bool found = keyFor(state, key) && lookup(key, entry);
+    double total = 0.0;
+    for (Action action : state.legal_actions()) {
+        double prob = 0.0;
+        for (int a = 0; found && a < entry.numActions; a++) {
+            if (entry.actions[a] == action) prob = entry.probs[a];
+        }
+        probs.emplace_back(action, prob);
+        total += prob;
+    }
+    if (total <= 0.0) {
+        for (auto& entryProb : probs) entryProb.second = 1.0 / probs.size();
+        return false;
+    }
+    for (auto& entryProb : probs) entryProb.second /= total;
+    return true;
+}
+
+// Replays a hand from the blinds with the given board dealt in order. Other
+// seats hold placeholder cards (preflop, a class for which each action is
+// legal), and the player to act at the end gets heroCards. Fails if an
+// action is out of turn or illegal, or if the line does not end at a
+// decision on the round the board belongs to.
+bool replayPublicLine(const std::vector<int>& board, const std::vector<std::pair<int, Action>>& history,
+                      const int* heroCards, SpinGoState& state, std::string& error) {
+    if (board.size() != 0 && board.size() != 3 && board.size() != 4 && board.size() != 5) {
+        error = "the board must have 0, 3, 4 or 5 cards";
+        return false;
+    }
+    std::vector<int> known = board;
+    known.push_back(heroCards[0]);
+    known.push_back(heroCards[1]);
+    for (size_t i = 0; i < known.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (known[i] == known[j]) {
+                error = "a card appears twice between the board and the hand";
+                return false;
+            }
+        }
+    }
+
+    state = SpinGoState();
+    state.cards.clear();
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        state.cards.push_back(cardFromIndex(12 * 4 + 0));
+        state.cards.push_back(cardFromIndex(12 * 4 + 1));
+    }
+    state.deck.clear();
+    for (int i = static_cast<int>(board.size()) - 1; i >= 0; i--) state.deck.push_back(cardFromIndex(board[i]));
+    state.defer_allin_runout = true;
+
+    for (size_t i = 0; i < history.size(); i++) {
+        const auto& step = history[i];
+        while (state.is_chance_node()) {
+            if (state.deck.empty()) {
+                error = "action " + std::to_string(i + 1) + " needs board cards that were not given";
+                return false;
+            }
+            state.apply_action(Action::DEAL);
+        }
+        if (state.game_over || state.current_player() != step.first) {
+            error = "action " + std::to_string(i + 1) + " (P" + std::to_string(step.first) + ":" +
+                    action_to_string(step.second) + ") is out of turn";
+            return false;
+        }
+        std::vector<Action> legal = state.legal_actions();
+        if (std::find(legal.begin(), legal.end(), step.second) == legal.end()) {
+            VectorPublicNode layout = state.round == "preflop" ? makePublicNode(state) : VectorPublicNode();
+            auto found = std::find(layout.actions.begin(), layout.actions.end(), step.second);
+            if (found == layout.actions.end()) {
+                error = "action " + std::to_string(i + 1) + " (" + action_to_string(step.second) + ") is not legal there";
+                return false;
+            }
+            preflopClassRepresentative(layout.representative[found - layout.actions.begin()],
+                                       state.cards[step.first * 2], state.cards[step.first * 2 + 1]);
+        }
+        state.apply_action(step.second);
+    }
+    while (state.is_chance_node() && !state.deck.empty()) {
+        state.apply_action(Action::DEAL);
+    }
+    if (state.game_over) {
+        error = "the hand is already over";
+        return false;
+    }
+    if (state.is_chance_node() || state.community_cards.size() != board.size()) {
+        error = "the actions end on the " + state.round + " with " + std::to_string(state.community_cards.size()) +
+                " board cards, not on the round the board belongs to";
+        return false;
+    }
+    int actor = state.current_player();
+    state.cards[actor * 2] = cardFromIndex(heroCards[0]);
+    state.cards[actor * 2 + 1] = cardFromIndex(heroCards[1]);
+    return true;
+}
+
+// Answers one request line (format at the top of the file), without the
+// newline.
+std::string answerStoreRequest(const StrategyStore& store, const std::string& request) {
+    std::istringstream in(request);
+    std::string handText, boardText, actionsText;
+    in >> handText >> boardText;
+    std::getline(in, actionsText);
+    actionsText.erase(0, actionsText.find_first_not_of(" \t"));
+    actionsText.erase(actionsText.find_last_not_of(" \t\r") + 1);
+    if (boardText == "-") boardText.clear();
+    if (actionsText == "-") actionsText.clear();
+
+    std::vector<int> hand, board;
+    std::vector<std::pair<int, Action>> history;
+    if (!parseCards(handText, hand) || hand.size() != 2) return "ERR cannot parse hand: " + handText;
+    if (!parseCards(boardText, board)) return "ERR cannot parse board: " + boardText;
+    if (!parseActionHistory(actionsText, history)) return "ERR cannot parse actions: " + actionsText;
+
+    SpinGoState state;
+    std::string error;
+    if (!replayPublicLine(board, history, hand.data(), state, error)) return "ERR " + error;
+    std::vector<std::pair<Action, double>> probs;
+    bool found = store.query(state, probs);
+
+    std::ostringstream reply;
+    reply << (found ? "OK " : "MISS ") << std::fixed << std::setprecision(6);
+    for (size_t a = 0; a < probs.size(); a++) {
+        if (a > 0) reply << "|";
+        reply << action_to_string(probs[a].first) << ":" << probs[a].second;
+    }
+    return reply.str();
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void serveStoreConnection(const StrategyStore& store, int fd) {
+    std::string pending, reply;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<size_t>(n));
+        reply.clear();
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            reply += answerStoreRequest(store, pending.substr(start, end - start));
+            reply += '\n';
+            start = end + 1;
+        }
+        pending.erase(0, start);
+        if (!reply.empty() && !sendAll(fd, reply)) break;
+    }
+    ::close(fd);
+}
+
+// Serves queries on a Unix domain socket until the process is killed.
+// Returns false if the socket cannot be set up or accept fails.
+bool serveStrategyStore(const StrategyStore& store, const std::string& socketPath) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Unable to create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 128) != 0) {
+        std::cerr << "Unable to listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+    std::cout << "Serving " << store.size() << " infosets on " << socketPath << std::endl;
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        std::thread([&store, client]() { serveStoreConnection(store, client); }).detach();
+    }
+    ::close(listener);
+    return false;
+}
+
+// Client side of the socket protocol.
+class StrategyStoreClient {
+public:
+    ~StrategyStoreClient() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool connect(const std::string& socketPath) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+        std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cerr << "Unable to connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Sends one request and waits for its reply line.
+    bool ask(const std::string& request, std::string& reply) {
+        if (fd < 0 || !sendAll(fd, request + "\n")) return false;
+        size_t end;
+        char buffer[4096];
+        while ((end = pending.find('\n')) == std::string::npos) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            pending.append(buffer, static_cast<size_t>(n));
+        }
+        reply = pending.substr(0, end);
+        pending.erase(0, end + 1);
+        return true;
+    }
+
+private:
+    int fd = -1;
+    std::string pending;
+};
+
+#endif // SPINGO_STRATEGY_STORE_CPP
@@ -0,0 +1,556 @@
+/*
+Real-time re-solving of turn and river subgames.
+
+The blueprint plays the abstracted game. Postflop hands are merged into
+cluster buckets, and one strategy covers every board that lands in a bucket.
+At play time the cards are known, so the rest of the hand can be solved
+again without that abstraction:
+
+1. The hand so far (board and public actions) is replayed from the deal with
+   SpinGoState. Stacks and pot follow from the actions. At every decision, the
+   acting player's range over the 1326 hole-card combos is multiplied by the
+   probability the blueprint gives the observed action, looked up with each
+   combo's bucket at that point. This gives the ranges everybody brings into
+   the subgame; card removal against the board is exact.
+2. From the current decision on, the tree is built from SpinGoState with
+   every combo as its own infoset, so hands are ranked exactly.
+3. Vector-form CFR+ (regrets floored at zero, averages weighted by iteration)
+   runs on that tree until the time budget or the iteration cap runs out.
+
+River subgames run to showdown. Turn subgames are depth-limited at the end of
+the turn betting. A river deal is a leaf, valued as the showdown of the
+current pot averaged over the river cards, i.e. the hand is checked down. That
+ignores river betting, and in exchange a turn decision fits in a couple of
+hundred milliseconds. Hands that are all-in on the turn are scored the same
+way. Each iteration averages over riverSamples randomly drawn river cards
+rather than all 48, which is what keeps a turn iteration cheap; the samples
+change every iteration, so the average strategy still sees every river.
+
+This is plain (unsafe) re-solving: the ranges are the blueprint's, nothing
+keeps the new strategy from being exploitable at the subgame root, and as
+in vector_cfr.cpp card removal between the two opponents is ignored.
+
+Include after spingo/best_response.cpp.
+*/
+
+#ifndef SPINGO_SUBGAME_SOLVER_CPP
+#define SPINGO_SUBGAME_SOLVER_CPP
+
+#include "best_response.cpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The decision to re-solve: the public cards and every action since the blinds.
+struct SubgameSpec {
+    std::vector<int> board;                       // 4 (turn) or 5 (river) card indices
+    std::vector<std::pair<int, Action>> history;  // (player, action) in order, without DEAL
+    int heroCards[2] = {-1, -1};                  // acting player's cards to report, optional
+};
+
+struct SubgameOptions {
+    double budgetMs = 200.0;  // wall time per decision, setup included (at least one iteration runs)
+    int maxIterations = 0;    // 0 = as many as fit in the budget
+    int riverSamples = 12;    // turn leaves: river cards per iteration, 0 = all 48
+    unsigned seed = 0;        // 0 = random
+};
+
+struct SubgameResult {
+    int actor = -1;
+    std::string round;
+    std::vector<Action> actions;
+    int iterations = 0;
+    double setupMs = 0.0;
+    double solveMs = 0.0;
+    std::vector<double> rangeStrategy;      // the actor's action frequencies over its whole range
+    std::vector<double> heroStrategy;       // re-solved strategy of the hero's hand
+    std::vector<double> blueprintStrategy;  // the blueprint's strategy for the same hand
+    double heroReach = 0.0;                 // blueprint weight of the hero's hand in the actor's range
+};
+
+// Parses cards such as "Ah Kd 7c", "AhKd7c" or "10h,Td".
+inline bool parseCards(const std::string& text, std::vector<int>& cards) {
+    cards.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == ' ' || c == ',') {
+            i++;
+            continue;
+        }
+        std::string rank;
+        if (c == '1' && i + 1 < text.size() && text[i + 1] == '0') {
+            rank = "10";
+            i += 2;
+        } else {
+            char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            rank = upper == 'T' ? "10" : std::string(1, upper);
+            i++;
+        }
+        if (i >= text.size()) return false;
+        int card = cardIndexFromStrings(rank, std::string(1, static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])))));
+        if (card < 0) return false;
+        cards.push_back(card);
+        i++;
+    }
+    return true;
+}
+
+// The action named as action_to_string prints it, or UNKNOWN.
+inline Action actionFromString(const std::string& name) {
+    for (int a = 0; a < static_cast<int>(Action::UNKNOWN); a++) {
+        if (action_to_string(static_cast<Action>(a)) == name) return static_cast<Action>(a);
+    }
+    return Action::UNKNOWN;
+}
+
+// Parses "P2:CALL|P0:CALL|P1:CHECK" (also separated by commas or spaces).
+inline bool parseActionHistory(const std::string& text, std::vector<std::pair<int, Action>>& history) {
+    history.clear();
+    std::string item;
+    for (size_t i = 0; i <= text.size(); i++) {
+        if (i < text.size() && text[i] != '|' && text[i] != ',' && text[i] != ' ') {
+            item += text[i];
+            continue;
+        }
+        if (item.empty()) continue;
+        size_t colon = item.find(':');
+        if (item[0] != 'P' || colon == std::string::npos) return false;
+        int player = std::atoi(item.substr(1, colon - 1).c_str());
+        Action action = actionFromString(item.substr(colon + 1));
+        if (action == Action::UNKNOWN || player < 0 || player >= NUM_PLAYERS) return false;
+        history.emplace_back(player, action);
+        item.clear();
+    }
+    return true;
+}
+
+class SubgameSolver {
+public:
+    SubgameSolver(const StrategyProfile& blueprint, PostflopBucketFn bucketFn)
+        : blueprint(blueprint), bucketFn(bucketFn) {}
+
+    // Replays the hand and builds the blueprint ranges. Returns false with a
+    // message in error if the spec is not a turn or river decision of a line
+    // the engine allows.
+    bool setup(const SubgameSpec& spec, std::string& error);
+
+    SubgameResult solve(const SubgameOptions& options);
+
+    const PlayerHandVectors& ranges() const { return rootReach; }
+
+private:
+    // The subgame tree is built once; walks only follow indices
+    struct TreeNode {
+        enum Kind { DECISION, TERMINAL, CHECK_DOWN } kind = DECISION;
+        int player = -1;
+        std::vector<Action> actions;
+        std::vector<int> children;
+        SpinGoState state;                // terminals and check-down leaves: pot and active players
+        std::vector<double> regret;       // [combo * actions + a]
+        std::vector<double> strategySum;
+    };
+
+    // Scratch vectors of one tree depth
+    struct Frame {
+        std::vector<double> sigma;
+        std::vector<PlayerHandVectors> childUtil;
+        PlayerHandVectors childReach;
+    };
+
+    const StrategyProfile& blueprint;
+    PostflopBucketFn bucketFn;
+
+    SubgameSpec spec;
+    SpinGoState root;
+    PlayerHandVectors rootReach;
+    double setupMs = 0.0;
+
+    SampledBoard base;                    // the known board: fold and river showdown terminals
+    std::vector<SampledBoard> rivers;     // turn subgames: one per possible river card
+    std::vector<int> activeRivers;        // rivers averaged over in this iteration
+    std::mt19937 rng;
+    std::vector<TreeNode> tree;           // tree[0] is the decision being re-solved
+    std::vector<Frame> frames;
+    int iteration = 0;
+
+    void blueprintStrategy(const SpinGoState& state, const VectorPublicNode& layout, int combo, double* probs,
+                           std::vector<std::vector<int>>& bucketCache) const;
+    int buildTree(const SpinGoState& state, int depth);
+    void checkDownValues(const SpinGoState& state, const PlayerHandVectors& reach, PlayerHandVectors& util) const;
+    void walk(int index, int depth, const PlayerHandVectors& reach, PlayerHandVectors& util);
+};
+
+// Blueprint strategy of one combo at a replayed decision, in layout's action
+// order. Buckets are computed once per round and combo.
+void SubgameSolver::blueprintStrategy(const SpinGoState& state, const VectorPublicNode& layout, int combo,
+                                      double* probs, std::vector<std::vector<int>>& bucketCache) const {
+    const HoleComboTable& combos = holeCombos();
+    int r = roundIndex(state.round);
+    int bucket;
+    if (r == 0) {
+        bucket = combos.preflopClass[combo];
+    } else {
+        std::vector<int>& cache = bucketCache[r];
+        if (cache.empty()) cache.assign(NUM_HOLE_COMBOS, -1);
+        if (cache[combo] < 0) {
+            int board[5] = {-1, -1, -1, -1, -1};
+            std::copy(spec.board.begin(), spec.board.end(), board);
+            cache[combo] = std::max(0, bucketFn(r, combos.cards[combo][0], combos.cards[combo][1], board));
+        }
+        bucket = cache[combo];
+    }
+    std::string abstraction = r == 0 ? preflopClassLabel(bucket) : std::to_string(bucket);
+    std::string key = StrategyProfile::key(layout.round, std::to_string(layout.player), abstraction, layout.history,
+                                           layout.pot);
+    blueprint.strategy(key, layout, r == 0 ? bucket : 0, probs);
+}
+
+bool SubgameSolver::setup(const SubgameSpec& subgame, std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+    spec = subgame;
+    tree.clear();
+    iteration = 0;
+    if (spec.board.size() != 4 && spec.board.size() != 5) {
+        error = "the board must have 4 (turn) or 5 (river) cards";
+        return false;
+    }
+    std::vector<int> known = spec.board;
+    if (spec.heroCards[0] >= 0 || spec.heroCards[1] >= 0) {
+        if (spec.heroCards[0] < 0 || spec.heroCards[1] < 0) {
+            error = "the hand needs two cards";
+            return false;
+        }
+        known.push_back(spec.heroCards[0]);
+        known.push_back(spec.heroCards[1]);
+    }
+    for (size_t i = 0; i < known.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (known[i] == known[j]) {
+                error = "a card appears twice between the board and the hand";
+                return false;
+            }
+        }
+    }
+
+    // Placeholder hole cards (only the acting player's class matters, and it
+    // is set per action preflop) and a deck that deals the known board
+    root = SpinGoState();
+    root.cards.clear();
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        root.cards.push_back(cardFromIndex(12 * 4 + 0));
+        root.cards.push_back(cardFromIndex(12 * 4 + 1));
+    }
+    root.deck.clear();
+    for (int i = static_cast<int>(spec.board.size()) - 1; i >= 0; i--) root.deck.push_back(cardFromIndex(spec.board[i]));
+    root.defer_allin_runout = true;
+
+    int fullBoard[5] = {-1, -1, -1, -1, -1};
+    std::copy(spec.board.begin(), spec.board.end(), fullBoard);
+    base = SampledBoard();
+    if (spec.board.size() == 5) {
+        base.deal(fullBoard, [](int, int, int, const int*) { return 0; });
+    } else {
+        const HoleComboTable& combos = holeCombos();
+        std::copy(fullBoard, fullBoard + 5, base.board);
+        base.available.assign(NUM_HOLE_COMBOS, 0);
+        base.handScore.assign(NUM_HOLE_COMBOS, 0);
+        for (int h = 0; h < NUM_HOLE_COMBOS; h++) {
+            bool clash = false;
+            for (int card : spec.board) clash = clash || combos.cards[h][0] == card || combos.cards[h][1] == card;
+            if (clash) continue;
+            base.available[h] = 1;
+            base.availableHands.push_back(h);
+        }
+        base.sortedHands = base.availableHands;  // only fold terminals use it
+    }
+
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        rootReach[p].assign(NUM_HOLE_COMBOS, 0.0);
+        for (int h : base.availableHands) rootReach[p][h] = 1.0;
+    }
+
+    // Replay, narrowing each actor's range by the blueprint
+    std::vector<std::vector<int>> bucketCache(4);
+    std::vector<double> probs;
+    for (size_t i = 0; i < spec.history.size(); i++) {
+        const auto& step = spec.history[i];
+        while (root.is_chance_node()) {
+            if (root.deck.empty()) {
+                error = "action " + std::to_string(i + 1) + " needs board cards that were not given";
+                return false;
+            }
+            root.apply_action(Action::DEAL);
+        }
+        if (root.game_over || root.current_player() != step.first) {
+            error = "action " + std::to_string(i + 1) + " (P" + std::to_string(step.first) + ":" +
+                    action_to_string(step.second) + ") is out of turn";
+            return false;
+        }
+        VectorPublicNode layout = makePublicNode(root);
+        auto found = std::find(layout.actions.begin(), layout.actions.end(), step.second);
+        if (found == layout.actions.end()) {
+            error = "action " + std::to_string(i + 1) + " (" + action_to_string(step.second) + ") is not legal there";
+            return false;
+        }
+        int chosen = static_cast<int>(found - layout.actions.begin());
+        probs.assign(layout.actions.size(), 0.0);
+        for (int h : base.availableHands) {
+            if (rootReach[step.first][h] == 0.0) continue;
+            blueprintStrategy(root, layout, h, probs.data(), bucketCache);
+            rootReach[step.first][h] *= probs[chosen];
+        }
+        if (!layout.representative.empty()) {
+            preflopClassRepresentative(layout.representative[chosen], root.cards[step.first * 2],
+                                       root.cards[step.first * 2 + 1]);
+        }
+        root.apply_action(step.second);
+    }
+    while (root.is_chance_node() && !root.deck.empty()) {
+        root.apply_action(Action::DEAL);
+    }
+    if (root.game_over) {
+        error = "the hand is already over";
+        return false;
+    }
+    if (root.community_cards.size() != spec.board.size() || (root.round != "turn" && root.round != "river")) {
+        error = "the actions end on the " + root.round + " with " + std::to_string(root.community_cards.size()) +
+                " board cards, not on the round the board belongs to";
+        return false;
+    }
+
+    // A line the blueprint never plays leaves no range; solve it from uniform
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        double total = 0.0;
+        for (int h : base.availableHands) total += rootReach[p][h];
+        if (total == 0.0) {
+            std::cerr << "Warning: the blueprint never plays this line for player " << p
+                      << "; using a uniform range" << std::endl;
+            for (int h : base.availableHands) rootReach[p][h] = 1.0;
+        }
+    }
+
+    rivers.clear();
+    if (spec.board.size() == 4) {
+        for (int card = 0; card < 52; card++) {
+            if (std::find(spec.board.begin(), spec.board.end(), card) != spec.board.end()) continue;
+            fullBoard[4] = card;
+            rivers.emplace_back();
+            rivers.back().deal(fullBoard, [](int, int, int, const int*) { return 0; });
+        }
+    }
+    frames.clear();
+    buildTree(root, 0);
+    setupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+int SubgameSolver::buildTree(const SpinGoState& state, int depth) {
+    int index = static_cast<int>(tree.size());
+    tree.emplace_back();
+    if (static_cast<int>(frames.size()) <= depth) frames.resize(depth + 1);
+    if (state.game_over || state.is_chance_node()) {
+        // A chance node is the river deal of a turn subgame: the depth limit
+        tree[index].kind = state.game_over && !state.runout_pending() ? TreeNode::TERMINAL : TreeNode::CHECK_DOWN;
+        tree[index].state = state;
+        return index;
+    }
+    std::vector<Action> actions = state.legal_actions();
+    std::vector<int> children;
+    for (Action action : actions) {
+        SpinGoState next = state;
+        next.apply_action(action);
+        children.push_back(buildTree(next, depth + 1));
+    }
+    TreeNode& node = tree[index];
+    node.player = state.current_player();
+    node.actions = actions;
+    node.children = children;
+    node.regret.assign(static_cast<size_t>(NUM_HOLE_COMBOS) * actions.size(), 0.0);
+    node.strategySum.assign(node.regret.size(), 0.0);
+    return index;
+}
+
+// Showdown of the current pot averaged over this iteration's river cards.
+// A combo only averages over the rivers it does not hold.
+void SubgameSolver::checkDownValues(const SpinGoState& state, const PlayerHandVectors& reach,
+                                    PlayerHandVectors& util) const {
+    std::vector<int> count(NUM_HOLE_COMBOS, 0);
+    for (int p = 0; p < NUM_PLAYERS; p++) util[p].assign(NUM_HOLE_COMBOS, 0.0);
+    PlayerHandVectors riverUtil;
+    for (int index : activeRivers) {
+        const SampledBoard& river = rivers[index];
+        river.terminalUtilities(state, reach, riverUtil);
+        for (int h : river.availableHands) {
+            count[h]++;
+            for (int p = 0; p < NUM_PLAYERS; p++) util[p][h] += riverUtil[p][h];
+        }
+    }
+    for (int h : base.availableHands) {
+        if (count[h] == 0) continue;
+        for (int p = 0; p < NUM_PLAYERS; p++) util[p][h] /= count[h];
+    }
+}
+
+void SubgameSolver::walk(int index, int depth, const PlayerHandVectors& reach, PlayerHandVectors& util) {
+    TreeNode& node = tree[index];
+    if (node.kind == TreeNode::TERMINAL) {
+        base.terminalUtilities(node.state, reach, util);
+        return;
+    }
+    if (node.kind == TreeNode::CHECK_DOWN) {
+        checkDownValues(node.state, reach, util);
+        return;
+    }
+
+    int zeroPlayers = 0;
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        if (base.allZero(reach[p])) zeroPlayers++;
+    }
+    if (zeroPlayers >= 2) {
+        for (int p = 0; p < NUM_PLAYERS; p++) util[p].assign(NUM_HOLE_COMBOS, 0.0);
+        return;
+    }
+
+    const int player = node.player;
+    const int numActions = static_cast<int>(node.actions.size());
+    const std::vector<int>& hands = base.availableHands;
+    Frame& frame = frames[depth];
+    if (static_cast<int>(frame.childUtil.size()) < numActions) frame.childUtil.resize(numActions);
+
+    // Regret matching per combo
+    std::vector<double>& sigma = frame.sigma;
+    sigma.resize(static_cast<size_t>(NUM_HOLE_COMBOS) * numActions);
+    for (int h : hands) {
+        double* s = &sigma[static_cast<size_t>(h) * numActions];
+        const double* regret = &node.regret[static_cast<size_t>(h) * numActions];
+        double normalizingSum = 0.0;
+        for (int a = 0; a < numActions; a++) normalizingSum += regret[a];
+        for (int a = 0; a < numActions; a++) s[a] = normalizingSum > 0 ? regret[a] / normalizingSum : 1.0 / numActions;
+    }
+
+    PlayerHandVectors& childReach = frame.childReach;
+    childReach = reach;
+    for (int a = 0; a < numActions; a++) {
+        for (int h : hands) childReach[player][h] = reach[player][h] * sigma[static_cast<size_t>(h) * numActions + a];
+        walk(node.children[a], depth + 1, childReach, frame.childUtil[a]);
+    }
+
+    const std::vector<PlayerHandVectors>& childUtil = frame.childUtil;
+    for (int p = 0; p < NUM_PLAYERS; p++) util[p].assign(NUM_HOLE_COMBOS, 0.0);
+    for (int a = 0; a < numActions; a++) {
+        for (int h : hands) {
+            double weight = sigma[static_cast<size_t>(h) * numActions + a];
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                util[p][h] += (p == player) ? weight * childUtil[a][p][h] : childUtil[a][p][h];
+            }
+        }
+    }
+
+    // CFR+: regrets floored at zero, averages weighted by the iteration
+    for (int h : hands) {
+        size_t offset = static_cast<size_t>(h) * numActions;
+        double ownReach = reach[player][h];
+        for (int a = 0; a < numActions; a++) {
+            node.regret[offset + a] = std::max(0.0, node.regret[offset + a] + childUtil[a][player][h] - util[player][h]);
+            node.strategySum[offset + a] += iteration * ownReach * sigma[offset + a];
+        }
+    }
+}
+
+SubgameResult SubgameSolver::solve(const SubgameOptions& options) {
+    rng.seed(options.seed ? options.seed : std::random_device{}());
+    SubgameResult result;
+    result.actor = root.current_player();
+    result.round = root.round;
+    result.setupMs = setupMs;
+
+    std::vector<int> allRivers(rivers.size());
+    for (size_t i = 0; i < rivers.size(); i++) allRivers[i] = static_cast<int>(i);
+    bool sampleRivers = options.riverSamples > 0 && options.riverSamples < static_cast<int>(rivers.size());
+
+    auto start = std::chrono::steady_clock::now();
+    PlayerHandVectors util;
+    while (options.maxIterations <= 0 || iteration < options.maxIterations) {
+        activeRivers = allRivers;
+        if (sampleRivers) {
+            std::shuffle(activeRivers.begin(), activeRivers.end(), rng);
+            activeRivers.resize(options.riverSamples);
+        }
+        iteration++;
+        walk(0, 0, rootReach, util);
+        result.solveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (setupMs + result.solveMs >= options.budgetMs) break;
+    }
+    result.iterations = iteration;
+
+    const TreeNode& node = tree[0];
+    const int numActions = static_cast<int>(node.actions.size());
+    result.actions = node.actions;
+    auto average = [&](int h, std::vector<double>& probs) {
+        probs.assign(numActions, 0.0);
+        double total = 0.0;
+        for (int a = 0; a < numActions; a++) total += node.strategySum[static_cast<size_t>(h) * numActions + a];
+        for (int a = 0; a < numActions; a++) {
+            probs[a] = total > 0 ? node.strategySum[static_cast<size_t>(h) * numActions + a] / total : 1.0 / numActions;
+        }
+    };
+
+    result.rangeStrategy.assign(numActions, 0.0);
+    double rangeMass = 0.0;
+    std::vector<double> probs;
+    for (int h : base.availableHands) {
+        double weight = rootReach[result.actor][h];
+        if (weight == 0.0) continue;
+        average(h, probs);
+        for (int a = 0; a < numActions; a++) result.rangeStrategy[a] += weight * probs[a];
+        rangeMass += weight;
+    }
+    for (double& p : result.rangeStrategy) p = rangeMass > 0 ? p / rangeMass : 0.0;
+
+    int c1 = spec.heroCards[0], c2 = spec.heroCards[1];
+    if (c1 >= 0 && c2 >= 0) {
+        int h = holeCombos().index[c1][c2];
+        {
+            average(h, result.heroStrategy);
+            result.heroReach = rootReach[result.actor][h];
+            VectorPublicNode layout = makePublicNode(root);
+            std::vector<std::vector<int>> bucketCache(4);
+            result.blueprintStrategy.assign(layout.actions.size(), 0.0);
+            blueprintStrategy(root, layout, h, result.blueprintStrategy.data(), bucketCache);
+        }
+    }
+    return result;
+}
+
+inline void printSubgameResult(const SubgameResult& result, std::ostream& out = std::cout) {
+    out << "Re-solved " << result.round << " decision of player " << result.actor << ": " << result.iterations
+        << " CFR+ iterations in " << std::fixed << std::setprecision(1) << result.solveMs << " ms (setup "
+        << result.setupMs << " ms)" << std::endl;
+    auto print = [&](const char* label, const std::vector<double>& probs) {
+        out << "  " << label;
+        for (size_t a = 0; a < result.actions.size() && a < probs.size(); a++) {
+            out << " " << action_to_string(result.actions[a]) << ":" << std::setprecision(3) << probs[a];
+        }
+        out << std::endl;
+    };
+    print("Range:    ", result.rangeStrategy);
+    if (!result.heroStrategy.empty()) {
+        print("Hand:     ", result.heroStrategy);
+        print("Blueprint:", result.blueprintStrategy);
+        if (result.heroReach == 0.0) {
+            out << "  (the blueprint would not have reached this spot with this hand)" << std::endl;
+        }
+    }
+    out.unsetf(std::ios::fixed);
+}
+
+#endif // SPINGO_SUBGAME_SOLVER_CPP
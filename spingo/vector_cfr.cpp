@@ -0,0 +1,633 @@
+/*
+Vector-form public-tree CFR for the Spin and Go engine.
+
+Instead of sampling one deal and following one infoset per player (MCCFR),
+each iteration samples a board, then walks every public betting sequence once
+while carrying, for every player, a reach vector and a utility vector over all
+1326 hole-card combinations. At a decision node the acting player's combos are
+mapped to their abstraction bucket (169 preflop classes, postflop clusters)
+and the per-bucket strategies are applied to the whole vector at once, so a
+single tree walk updates every bucket of every public node it visits.
+
+The betting tree comes straight from SpinGoState: legal_actions() (including
+the preflop fold charts, which are evaluated per hand class) and
+apply_action() drive the walk, and the terminal payoffs follow returns(): the
+folded players lose their contribution and the remaining players split the
+whole pot by best hand.
+
+Card removal is exact between a hand and each opponent's range. Between the
+two opponents it is ignored (their ranges are treated as independent), which
+keeps terminal evaluation linear in the number of combos.
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_VECTOR_CFR_CPP
+#define SPINGO_VECTOR_CFR_CPP
+
+#include "fast_eval.cpp"
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <random>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstdint>
+
+static const int NUM_HOLE_COMBOS = 1326;
+static const int NUM_PREFLOP_CLASSES = 169;
+
+typedef std::vector<double> HandVector;
+typedef std::array<HandVector, NUM_PLAYERS> PlayerHandVectors;
+
+// Maps a postflop round (1 = flop, 2 = turn, 3 = river), two hole cards and the
+// five sampled board cards to an abstraction bucket.
+typedef std::function<int(int roundIdx, int hole1, int hole2, const int* board)> PostflopBucketFn;
+
+// Hole-card combination tables shared by all vector-form code.
+struct HoleComboTable {
+    int cards[NUM_HOLE_COMBOS][2];
+    int preflopClass[NUM_HOLE_COMBOS];
+    int index[52][52];
+
+    HoleComboTable() {
+        int h = 0;
+        for (int c1 = 0; c1 < 52; c1++) {
+            index[c1][c1] = -1;
+            for (int c2 = c1 + 1; c2 < 52; c2++) {
+                cards[h][0] = c1;
+                cards[h][1] = c2;
+                index[c1][c2] = h;
+                index[c2][c1] = h;
+                preflopClass[h] = preflopClassIndex(c1, c2);
+                h++;
+            }
+        }
+    }
+};
+
+inline const HoleComboTable& holeCombos() {
+    static const HoleComboTable table;
+    return table;
+}
+
+inline int roundIndex(const std::string& round) {
+    if (round == "preflop") return 0;
+    if (round == "flop") return 1;
+    if (round == "turn") return 2;
+    if (round == "river") return 3;
+    return 4;
+}
+
+inline Card cardFromIndex(int card) {
+    Card c;
+    c.rank = RANKS[cardRankIndex(card)];
+    c.suit = std::string(1, SUITS[cardSuitIndex(card)]);
+    return c;
+}
+
+// Preflop class label in the trainer's abstraction format ("2As", "JJo", "79o").
+inline std::string preflopClassLabel(int cls) {
+    int row = cls / 13, col = cls % 13;
+    int lo = std::min(row, col), hi = std::max(row, col);
+    bool suited = row < col;
+    return RANKS[lo] + RANKS[hi] + (suited ? "s" : "o");
+}
+
+// Two concrete cards belonging to a preflop class.
+inline void preflopClassRepresentative(int cls, Card& first, Card& second) {
+    int row = cls / 13, col = cls % 13;
+    int lo = std::min(row, col), hi = std::max(row, col);
+    bool suited = row < col;
+    first = cardFromIndex(lo * 4 + 0);
+    second = cardFromIndex(hi * 4 + (suited ? 0 : 1));
+}
+
+// All buckets of one public node.
+struct VectorPublicNode {
+    int player = -1;
+    std::string round;
+    std::string history;  // "P2:BET_2|P0:FOLD"
+    std::string pot;
+    std::vector<Action> actions;
+    std::vector<uint32_t> legalMask;  // preflop: bit a set when actions[a] is legal for the class
+    std::vector<double> regretSum;    // [bucket * actions.size() + a]
+    std::vector<double> strategySum;
+    std::vector<int> updateCount;
+    std::vector<int> representative;  // preflop: class used to apply actions[a]
+
+    int numBuckets() const { return static_cast<int>(updateCount.size()); }
+
+    void ensureBuckets(int n) {
+        if (n <= numBuckets()) return;
+        regretSum.resize(static_cast<size_t>(n) * actions.size(), 0.0);
+        strategySum.resize(static_cast<size_t>(n) * actions.size(), 0.0);
+        updateCount.resize(n, 0);
+    }
+
+    bool isLegal(int bucket, int a) const {
+        return legalMask.empty() || (legalMask[bucket] >> a) & 1u;
+    }
+};
+
+// Chance data for one sampled board: the combos that do not clash with it,
+// their showdown scores and their abstraction bucket in every round.
+struct SampledBoard {
+    int board[5];
+    std::vector<char> available;
+    std::vector<int> availableHands;
+    std::vector<int> sortedHands;  // available hands by ascending showdown score
+    std::vector<int> handScore;
+    std::vector<int> buckets[4];
+    int bucketCount[4];
+
+    void deal(const int* cards, const PostflopBucketFn& bucketFn);
+    bool allZero(const HandVector& v) const;
+    void exclusionMass(const HandVector& reach, HandVector& mass) const;
+    void showdownMass(const HandVector& reach, HandVector& lower, HandVector& equal) const;
+    // Counterfactual terminal utilities. With onlyPlayer >= 0 only that
+    // player's utility is computed and its own reach is ignored.
+    void terminalUtilities(const SpinGoState& state, const PlayerHandVectors& reach,
+                           PlayerHandVectors& util, int onlyPlayer = -1) const;
+    // Opponent mass faced by all combos together when every reach is 1, used
+    // to turn summed root utilities into per-hand values.
+    double rootNormalizer() const;
+};
+
+// Draws five distinct board cards.
+inline void sampleBoard(std::mt19937& rng, int* board) {
+    int deck[52];
+    for (int c = 0; c < 52; c++) deck[c] = c;
+    for (int i = 0; i < 5; i++) {
+        std::uniform_int_distribution<int> pick(i, 51);
+        std::swap(deck[i], deck[pick(rng)]);
+        board[i] = deck[i];
+    }
+}
+
+// Root state for a walk over the public tree: placeholder hole cards (only
+// the acting player's class matters, and it is set per action) and a deck
+// that deals the given board.
+inline SpinGoState publicTreeRoot(const int* board) {
+    SpinGoState root;
+    root.cards.clear();
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        root.cards.push_back(cardFromIndex(12 * 4 + 0));
+        root.cards.push_back(cardFromIndex(12 * 4 + 1));
+    }
+    root.deck.clear();
+    for (int i = 4; i >= 0; i--) root.deck.push_back(cardFromIndex(board[i]));
+    return root;
+}
+
+// Key of the public node at state, made of the same public fields as the
+// trainer's infoset key.
+std::string publicNodeKey(const SpinGoState& state);
+
+// Actions, per-class legality and history/pot labels of the public node at
+// state, with no buckets allocated.
+VectorPublicNode makePublicNode(const SpinGoState& state);
+
+class PublicTreeCFR {
+public:
+    explicit PublicTreeCFR(PostflopBucketFn bucketFn, unsigned seed = std::random_device{}())
+        : bucketFn(bucketFn), rng(seed), totalValue(NUM_PLAYERS, 0.0), iterations(0) {}
+
+    // Samples a board and walks the public tree once.
+    void iterate();
+
+    int completedIterations() const { return iterations; }
+    size_t numPublicNodes() const { return nodes.size(); }
+    size_t numInfosets() const;
+    // Average root value per player over all iterations, in big blinds.
+    std::vector<double> averageValues() const;
+
+    // Writes the average strategies in the same CSV layout as saveInfoSetsToFile.
+    void writeCSV(const std::string& filename) const;
+
+private:
+    PostflopBucketFn bucketFn;
+    std::mt19937 rng;
+    std::unordered_map<std::string, VectorPublicNode> nodes;
+    std::vector<double> totalValue;
+    int iterations;
+
+    SampledBoard chance;  // this iteration's board
+
+    VectorPublicNode& publicNode(const SpinGoState& state);
+    void walk(const SpinGoState& state, const PlayerHandVectors& reach, PlayerHandVectors& util);
+};
+
+bool SampledBoard::allZero(const HandVector& v) const {
+    for (int h : availableHands) {
+        if (v[h] != 0.0) return false;
+    }
+    return true;
+}
+
+size_t PublicTreeCFR::numInfosets() const {
+    size_t count = 0;
+    for (const auto& entry : nodes) {
+        for (int c : entry.second.updateCount) {
+            if (c > 0) count++;
+        }
+    }
+    return count;
+}
+
+std::vector<double> PublicTreeCFR::averageValues() const {
+    std::vector<double> avg(NUM_PLAYERS, 0.0);
+    for (int p = 0; p < NUM_PLAYERS && iterations > 0; p++) {
+        avg[p] = totalValue[p] / iterations;
+    }
+    return avg;
+}
+
+// Opponent mass that does not share a card with each hand:
+// total - mass through card 1 - mass through card 2 + the hand itself.
+void SampledBoard::exclusionMass(const HandVector& reach, HandVector& mass) const {
+    const HoleComboTable& combos = holeCombos();
+    double total = 0.0;
+    double perCard[52] = {0.0};
+    for (int h : availableHands) {
+        double r = reach[h];
+        total += r;
+        perCard[combos.cards[h][0]] += r;
+        perCard[combos.cards[h][1]] += r;
+    }
+    for (int h : availableHands) {
+        mass[h] = total - perCard[combos.cards[h][0]] - perCard[combos.cards[h][1]] + reach[h];
+    }
+}
+
+// Opponent mass with a strictly lower and with an equal showdown score,
+// excluding combos that share a card with the hand.
+void SampledBoard::showdownMass(const HandVector& reach, HandVector& lower, HandVector& equal) const {
+    const HoleComboTable& combos = holeCombos();
+    double below = 0.0;
+    double belowCard[52] = {0.0};
+    double groupCard[52] = {0.0};  // cleared again by the hands that set it
+    size_t i = 0;
+    while (i < sortedHands.size()) {
+        size_t j = i;
+        int score = handScore[sortedHands[i]];
+        double group = 0.0;
+        while (j < sortedHands.size() && handScore[sortedHands[j]] == score) {
+            int h = sortedHands[j];
+            group += reach[h];
+            groupCard[combos.cards[h][0]] += reach[h];
+            groupCard[combos.cards[h][1]] += reach[h];
+            j++;
+        }
+        for (size_t k = i; k < j; k++) {
+            int h = sortedHands[k];
+            int c1 = combos.cards[h][0], c2 = combos.cards[h][1];
+            lower[h] = below - belowCard[c1] - belowCard[c2];
+            equal[h] = group - groupCard[c1] - groupCard[c2] + reach[h];
+        }
+        below += group;
+        for (size_t k = i; k < j; k++) {
+            int h = sortedHands[k];
+            int c1 = combos.cards[h][0], c2 = combos.cards[h][1];
+            belowCard[c1] += reach[h];
+            belowCard[c2] += reach[h];
+            groupCard[c1] = 0.0;
+            groupCard[c2] = 0.0;
+        }
+        i = j;
+    }
+}
+
+void SampledBoard::terminalUtilities(const SpinGoState& state, const PlayerHandVectors& reach,
+                                     PlayerHandVectors& util, int onlyPlayer) const {
+    double totalPot = 0.0;
+    for (double c : state.cumulative_pot) totalPot += c;
+
+    bool showdown = state.active_players.size() > 1;
+    PlayerHandVectors excl, lower, equal;
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        if (p == onlyPlayer) continue;
+        excl[p].assign(NUM_HOLE_COMBOS, 0.0);
+        exclusionMass(reach[p], excl[p]);
+        if (showdown && state.active_players.count(p)) {
+            lower[p].assign(NUM_HOLE_COMBOS, 0.0);
+            equal[p].assign(NUM_HOLE_COMBOS, 0.0);
+            showdownMass(reach[p], lower[p], equal[p]);
+        }
+    }
+
+    for (int q = 0; q < NUM_PLAYERS; q++) {
+        if (onlyPlayer >= 0 && q != onlyPlayer) continue;
+        int j = (q + 1) % NUM_PLAYERS, k = (q + 2) % NUM_PLAYERS;
+        double contribution = state.cumulative_pot[q];
+        bool qActive = state.active_players.count(q) > 0;
+        bool jActive = state.active_players.count(j) > 0;
+        bool kActive = state.active_players.count(k) > 0;
+        HandVector& u = util[q];
+        u.assign(NUM_HOLE_COMBOS, 0.0);
+
+        for (int h : availableHands) {
+            double both = excl[j][h] * excl[k][h];
+            if (!showdown) {
+                u[h] = (qActive ? totalPot - contribution : -contribution) * both;
+            } else if (!qActive) {
+                u[h] = -contribution * both;
+            } else if (jActive && kActive) {
+                double lj = lower[j][h], ej = equal[j][h];
+                double lk = lower[k][h], ek = equal[k][h];
+                u[h] = totalPot * lj * lk
+                     + totalPot / 2.0 * (lj * ek + ej * lk)
+                     + totalPot / 3.0 * ej * ek
+                     - contribution * both;
+            } else {
+                int o = jActive ? j : k;
+                int f = jActive ? k : j;
+                u[h] = excl[f][h] * (totalPot * lower[o][h] + totalPot / 2.0 * equal[o][h])
+                     - contribution * both;
+            }
+        }
+    }
+}
+
+// Total pot with one decimal, as it appears in the trainer's infoset keys and
+// CSV.
+static std::string publicNodePot(const SpinGoState& state) {
+    std::ostringstream potStream;
+    double totalPot = 0.0;
+    for (int p = 0; p < NUM_PLAYERS; p++) totalPot += state.pot[p] + state.cumulative_pot[p];
+    potStream << std::fixed << std::setprecision(1) << totalPot;
+    return potStream.str();
+}
+
+std::string publicNodeKey(const SpinGoState& state) {
+    int player = state.current_player();
+    std::string key = "P" + std::to_string(player) + ": Round:" + state.round + " Actions:";
+    state.action_history.append_key(key);
+    return key + " Pot:" + publicNodePot(state)
+         + " CurrentBet:" + std::to_string(state.current_bet)
+         + " ActivePlayers:" + std::to_string(state.active_players.size())
+         + " CurrentPlayer:" + std::to_string(player);
+}
+
+VectorPublicNode makePublicNode(const SpinGoState& state) {
+    int player = state.current_player();
+
+    VectorPublicNode node;
+    node.player = player;
+    node.round = state.round;
+    node.history = state.action_history.round_text();
+    node.pot = publicNodePot(state);
+
+    if (state.round == "preflop") {
+        // The fold charts make preflop legality depend on the hand class, so
+        // take the union over classes and keep a per-class mask.
+        std::vector<std::vector<Action>> perClass(NUM_PREFLOP_CLASSES);
+        SpinGoState probe = state;
+        uint32_t seen = 0;
+        for (int cls = 0; cls < NUM_PREFLOP_CLASSES; cls++) {
+            preflopClassRepresentative(cls, probe.cards[player * 2], probe.cards[player * 2 + 1]);
+            perClass[cls] = probe.legal_actions();
+            for (Action a : perClass[cls]) seen |= 1u << static_cast<int>(a);
+        }
+        for (int a = 0; a < 32; a++) {
+            if (seen & (1u << a)) node.actions.push_back(static_cast<Action>(a));
+        }
+        node.legalMask.assign(NUM_PREFLOP_CLASSES, 0);
+        node.representative.assign(node.actions.size(), -1);
+        for (int cls = 0; cls < NUM_PREFLOP_CLASSES; cls++) {
+            for (Action a : perClass[cls]) {
+                size_t idx = std::find(node.actions.begin(), node.actions.end(), a) - node.actions.begin();
+                node.legalMask[cls] |= 1u << idx;
+                if (node.representative[idx] < 0) node.representative[idx] = cls;
+            }
+        }
+    } else {
+        node.actions = state.legal_actions();
+    }
+    return node;
+}
+
+VectorPublicNode& PublicTreeCFR::publicNode(const SpinGoState& state) {
+    std::string key = publicNodeKey(state);
+    auto it = nodes.find(key);
+    if (it != nodes.end()) return it->second;
+    return nodes.emplace(key, makePublicNode(state)).first->second;
+}
+
+void PublicTreeCFR::walk(const SpinGoState& state, const PlayerHandVectors& reach, PlayerHandVectors& util) {
+    if (state.game_over) {
+        chance.terminalUtilities(state, reach, util);
+        return;
+    }
+
+    if (state.is_chance_node()) {
+        // The board was sampled up front; dealing just reveals it.
+        SpinGoState next = state;
+        next.apply_action(Action::DEAL);
+        walk(next, reach, util);
+        return;
+    }
+
+    // Every counterfactual value carries the other two players' reach, so once
+    // two reach vectors are empty the whole subtree is worth zero.
+    int zeroPlayers = 0;
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        if (chance.allZero(reach[p])) zeroPlayers++;
+    }
+    if (zeroPlayers >= 2) {
+        for (int p = 0; p < NUM_PLAYERS; p++) util[p].assign(NUM_HOLE_COMBOS, 0.0);
+        return;
+    }
+
+    int player = state.current_player();
+    int r = roundIndex(state.round);
+    VectorPublicNode& node = publicNode(state);
+    node.ensureBuckets(chance.bucketCount[r]);
+    const std::vector<int>& bucketOf = chance.buckets[r];
+    const std::vector<int>& availableHands = chance.availableHands;
+    const int numActions = static_cast<int>(node.actions.size());
+    const int numBuckets = chance.bucketCount[r];
+
+    // Regret matching for every bucket
+    std::vector<double> sigma(static_cast<size_t>(numBuckets) * numActions, 0.0);
+    for (int b = 0; b < numBuckets; b++) {
+        double* s = &sigma[static_cast<size_t>(b) * numActions];
+        const double* regret = &node.regretSum[static_cast<size_t>(b) * numActions];
+        double normalizingSum = 0.0;
+        int legalCount = 0;
+        for (int a = 0; a < numActions; a++) {
+            if (!node.isLegal(b, a)) continue;
+            legalCount++;
+            s[a] = regret[a] > 0 ? regret[a] : 0.0;
+            normalizingSum += s[a];
+        }
+        for (int a = 0; a < numActions; a++) {
+            if (!node.isLegal(b, a)) continue;
+            s[a] = normalizingSum > 0 ? s[a] / normalizingSum : 1.0 / legalCount;
+        }
+    }
+
+    std::vector<PlayerHandVectors> childUtil(numActions);
+    PlayerHandVectors childReach = reach;
+    for (int a = 0; a < numActions; a++) {
+        SpinGoState next = state;
+        if (!node.representative.empty()) {
+            preflopClassRepresentative(node.representative[a], next.cards[player * 2], next.cards[player * 2 + 1]);
+        }
+        next.apply_action(node.actions[a]);
+
+        HandVector& own = childReach[player];
+        for (int h : availableHands) {
+            own[h] = reach[player][h] * sigma[static_cast<size_t>(bucketOf[h]) * numActions + a];
+        }
+        walk(next, childReach, childUtil[a]);
+    }
+
+    for (int p = 0; p < NUM_PLAYERS; p++) util[p].assign(NUM_HOLE_COMBOS, 0.0);
+    for (int a = 0; a < numActions; a++) {
+        for (int h : availableHands) {
+            double weight = sigma[static_cast<size_t>(bucketOf[h]) * numActions + a];
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                util[p][h] += (p == player) ? weight * childUtil[a][p][h] : childUtil[a][p][h];
+            }
+        }
+    }
+
+    // Regret and average-strategy updates, summed over the combos of each bucket
+    std::vector<char> touched(numBuckets, 0);
+    for (int h : availableHands) {
+        int b = bucketOf[h];
+        size_t base = static_cast<size_t>(b) * numActions;
+        double ownReach = reach[player][h];
+        for (int a = 0; a < numActions; a++) {
+            if (!node.isLegal(b, a)) continue;
+            node.regretSum[base + a] += childUtil[a][player][h] - util[player][h];
+            node.strategySum[base + a] += ownReach * sigma[base + a];
+        }
+        if (ownReach > 0) touched[b] = 1;
+    }
+    for (int b = 0; b < numBuckets; b++) {
+        if (touched[b]) node.updateCount[b]++;
+    }
+}
+
+void SampledBoard::deal(const int* cards, const PostflopBucketFn& bucketFn) {
+    const HoleComboTable& combos = holeCombos();
+    std::copy(cards, cards + 5, board);
+
+    available.assign(NUM_HOLE_COMBOS, 0);
+    availableHands.clear();
+    handScore.assign(NUM_HOLE_COMBOS, 0);
+    for (int h = 0; h < NUM_HOLE_COMBOS; h++) {
+        bool clash = false;
+        for (int i = 0; i < 5; i++) {
+            if (combos.cards[h][0] == board[i] || combos.cards[h][1] == board[i]) clash = true;
+        }
+        if (clash) continue;
+        available[h] = 1;
+        availableHands.push_back(h);
+        handScore[h] = fastHandScore(combos.cards[h][0], combos.cards[h][1], board, 5);
+    }
+    sortedHands = availableHands;
+    std::sort(sortedHands.begin(), sortedHands.end(),
+              [this](int a, int b) { return handScore[a] < handScore[b]; });
+
+    for (int r = 0; r < 4; r++) {
+        buckets[r].assign(NUM_HOLE_COMBOS, 0);
+        bucketCount[r] = (r == 0) ? NUM_PREFLOP_CLASSES : 1;
+    }
+    for (int h : availableHands) {
+        buckets[0][h] = combos.preflopClass[h];
+        for (int r = 1; r < 4; r++) {
+            int b = std::max(0, bucketFn(r, combos.cards[h][0], combos.cards[h][1], board));
+            buckets[r][h] = b;
+            bucketCount[r] = std::max(bucketCount[r], b + 1);
+        }
+    }
+}
+
+double SampledBoard::rootNormalizer() const {
+    HandVector ones(NUM_HOLE_COMBOS, 0.0), excl(NUM_HOLE_COMBOS, 0.0);
+    for (int h : availableHands) ones[h] = 1.0;
+    exclusionMass(ones, excl);
+    double norm = 0.0;
+    for (int h : availableHands) norm += excl[h] * excl[h];
+    return norm;
+}
+
+void PublicTreeCFR::iterate() {
+    int board[5];
+    sampleBoard(rng, board);
+    chance.deal(board, bucketFn);
+
+    PlayerHandVectors reach, util;
+    for (int p = 0; p < NUM_PLAYERS; p++) {
+        reach[p].assign(NUM_HOLE_COMBOS, 0.0);
+        for (int h : chance.availableHands) reach[p][h] = 1.0;
+    }
+    walk(publicTreeRoot(board), reach, util);
+
+    // Normalise root values by the opponent mass each combo faces
+    double norm = chance.rootNormalizer();
+    for (int p = 0; p < NUM_PLAYERS && norm > 0; p++) {
+        double sum = 0.0;
+        for (int h : chance.availableHands) sum += util[p][h];
+        totalValue[p] += sum / norm;
+    }
+    iterations++;
+}
+
+void PublicTreeCFR::writeCSV(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Unable to open file: " << filename << std::endl;
+        return;
+    }
+
+    file << "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,StrategyUpdateCount\n";
+
+    size_t rows = 0;
+    for (const auto& entry : nodes) {
+        const VectorPublicNode& node = entry.second;
+        const int numActions = static_cast<int>(node.actions.size());
+        for (int b = 0; b < node.numBuckets(); b++) {
+            if (node.updateCount[b] == 0) continue;
+            const double* sum = &node.strategySum[static_cast<size_t>(b) * numActions];
+            double total = 0.0;
+            int legalCount = 0;
+            for (int a = 0; a < numActions; a++) {
+                if (!node.isLegal(b, a)) continue;
+                total += sum[a];
+                legalCount++;
+            }
+
+            std::stringstream strategyStr;
+            bool first = true;
+            for (int a = 0; a < numActions; a++) {
+                if (!node.isLegal(b, a)) continue;
+                double prob = total > 0 ? sum[a] / total : 1.0 / legalCount;
+                if (!first) strategyStr << "|";
+                strategyStr << action_to_string(node.actions[a]) << ":" << std::fixed << std::setprecision(6) << prob;
+                first = false;
+            }
+
+            std::string abstraction = node.round == "preflop" ? preflopClassLabel(b) : std::to_string(b);
+            file << node.round << ","
+                 << node.player << ","
+                 << abstraction << ","
+                 << node.history << ","
+                 << strategyStr.str() << ","
+                 << node.pot << ","
+                 << node.updateCount[b] << "\n";
+            rows++;
+        }
+    }
+
+    file.close();
+    std::cout << "Saved " << rows << " infosets from " << nodes.size() << " public nodes to " << filename << std::endl;
+}
+
+#endif // SPINGO_VECTOR_CFR_CPP
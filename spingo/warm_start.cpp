@@ -0,0 +1,227 @@
+/*
+Warm start: seeds the infosets of a new training run from an earlier strategy.
+
+The prior comes from a strategy CSV (a trainer's output, or an --aggregate
+result) or from a binary checkpoint/snapshot of any abstraction. Priors are
+indexed three ways, and a new infoset takes the first that matches:
+
+- the full infoset key (checkpoints only; the CSV drops some key fields)
+- the CSV fields: round, player, abstraction, previous actions and pot
+- the same without the pot, so lines whose bet sizes moved a little still
+  find their prior
+
+Actions are matched by name. Actions the prior does not know start at 0, and
+prior actions that are no longer legal are dropped; the rest is renormalized.
+Bucket numbers are taken as they are, so a changed cluster count maps bucket
+i onto bucket i. That is fine when the clusters were only refined, but not
+when the new clustering is unrelated to the old one.
+
+A matched node gets regretSum = strategySum = weight * p, where p is the prior
+strategy and weight = scale * max(updateCount, 1). Regret matching then plays
+the prior from the first visit, and the prior counts as many visits as it had
+in its own run (times scale). Its influence fades once the new run has
+visited the node a comparable number of times.
+
+Priors with raw sums (a --raw-sums export, or an --aggregate of such
+exports) are continued instead: a matched node gets scale times the prior's
+own strategySum and regretSum per action, and its update count, so the new
+run picks up exactly where the prior runs stopped. Rows merged into one
+index entry add their sums; if any of them lacks raw sums the entry falls
+back to the averaged strategy above. Checkpoint priors use the averaged
+strategy as before.
+
+Nodes are seeded when the trainer creates them, so an infoset the new run
+never reaches costs nothing. After load() the table is read-only and can be
+shared by all workers; only the match counters are atomic.
+
+Include after spingo/spingo.cpp.
+*/
+
+#ifndef SPINGO_WARM_START_CPP
+#define SPINGO_WARM_START_CPP
+
+#include "strategy_file.cpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class WarmStartTable {
+public:
+    struct Prior {
+        std::map<std::string, double> actionProbs;  // action name -> probability
+        double weight = 0.0;                        // summed update counts of the rows merged here
+        bool raw = false;                           // every row merged here had raw sums
+        std::map<std::string, std::pair<double, double>> rawSums;  // action name -> (strategySum, regretSum)
+    };
+
+    // How a node found its prior
+    enum MatchLevel { MATCH_KEY, MATCH_FIELDS, MATCH_LINE, MATCH_NONE };
+
+    bool enabled() const { return !byFields.empty() || !byKey.empty(); }
+    size_t size() const { return priorRows; }
+
+    static std::string fieldsKey(const std::string& round, const std::string& player, const std::string& abstraction,
+                                 const std::string& previousActions, const std::string& pot) {
+        return round + "," + player + "," + abstraction + "," + previousActions + "," + pot;
+    }
+
+    static std::string lineKey(const std::string& round, const std::string& player, const std::string& abstraction,
+                               const std::string& previousActions) {
+        return round + "," + player + "," + abstraction + "," + previousActions;
+    }
+
+    // Adds one prior row; fullKey may be empty (CSV rows). Rows landing on
+    // the same index entry are averaged by their update counts, and their
+    // raw sums (if all of them have some) added up.
+    void add(const std::string& fullKey, const std::string& round, const std::string& player,
+             const std::string& abstraction, const std::string& previousActions, const std::string& pot,
+             const std::map<std::string, double>& actionProbs, int updateCount,
+             const std::map<std::string, std::pair<double, double>>* rawSums = nullptr) {
+        double weight = std::max(updateCount, 1);
+        if (!fullKey.empty()) merge(byKey[fullKey], actionProbs, weight, rawSums);
+        merge(byFields[fieldsKey(round, player, abstraction, previousActions, pot)], actionProbs, weight, rawSums);
+        merge(byLine[lineKey(round, player, abstraction, previousActions)], actionProbs, weight, rawSums);
+        priorRows++;
+    }
+
+    // Loads the rows of a strategy CSV or binary strategy file, with their
+    // raw sums if it has them.
+    bool loadCSV(const std::string& filename) {
+        StrategyRowSource source;
+        if (!source.open(filename)) {
+            std::cerr << "Unable to open warm-start file: " << filename << std::endl;
+            return false;
+        }
+        StrategyRow row;
+        std::map<std::string, std::pair<double, double>> rawSums;
+        while (source.next(row)) {
+            if (row.raw) {
+                rawSums.clear();
+                size_t i = 0;
+                for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+                    if (!(row.actionMask >> a & 1)) continue;
+                    rawSums[STRATEGY_ACTION_NAMES[a]] = {row.strategySums[i], row.regretSums[i]};
+                    i++;
+                }
+            }
+            add("", STRATEGY_ROUND_NAMES[row.round], std::to_string(row.player), row.abstraction, row.history,
+                row.potText(), row.actionProbs(), static_cast<int>(std::min<uint32_t>(row.updateCount, INT32_MAX)),
+                row.raw ? &rawSums : nullptr);
+        }
+        if (source.skippedRows() > 0) {
+            std::cerr << "Warm start: skipped " << source.skippedRows() << " malformed rows of " << filename
+                      << std::endl;
+        }
+        return true;
+    }
+
+    // The prior for a new infoset, or nullptr. Counts the match.
+    const Prior* lookup(const std::string& fullKey, const std::string& round, const std::string& player,
+                        const std::string& abstraction, const std::string& previousActions,
+                        const std::string& pot) const {
+        auto it = byKey.find(fullKey);
+        if (it != byKey.end()) return found(MATCH_KEY, it->second);
+        it = byFields.find(fieldsKey(round, player, abstraction, previousActions, pot));
+        if (it != byFields.end()) return found(MATCH_FIELDS, it->second);
+        it = byLine.find(lineKey(round, player, abstraction, previousActions));
+        if (it != byLine.end()) return found(MATCH_LINE, it->second);
+        matches[MATCH_NONE]++;
+        return nullptr;
+    }
+
+    // Seeds a fresh node (see the top of the file). Returns false, leaving the
+    // node untouched, if the prior puts no mass on any of its actions.
+    template <typename NodeT>
+    bool seed(NodeT& node, const Prior& prior, double scale) const {
+        size_t numActions = std::min(node.actions.size(), node.regretSum.size());
+        if (prior.raw) return seedRaw(node, prior, scale, numActions);
+        std::vector<double> probs(numActions, 0.0);
+        double total = 0.0;
+        for (size_t a = 0; a < numActions; a++) {
+            auto it = prior.actionProbs.find(action_to_string(node.actions[a]));
+            if (it != prior.actionProbs.end()) probs[a] = std::max(0.0, it->second);
+            total += probs[a];
+        }
+        if (total <= 0.0) return false;
+        double weight = scale * prior.weight;
+        for (size_t a = 0; a < numActions; a++) {
+            node.regretSum[a] = weight * probs[a] / total;
+            node.strategySum[a] = weight * probs[a] / total;
+        }
+        return true;
+    }
+
+    void printSummary(std::ostream& out = std::cout) const {
+        uint64_t seeded = matches[MATCH_KEY] + matches[MATCH_FIELDS] + matches[MATCH_LINE];
+        out << "Warm start: " << seeded << " new infosets seeded (" << matches[MATCH_KEY] << " by key, "
+            << matches[MATCH_FIELDS] << " by fields, " << matches[MATCH_LINE] << " ignoring the pot), "
+            << matches[MATCH_NONE] << " without a prior" << std::endl;
+    }
+
+private:
+    std::unordered_map<std::string, Prior> byKey;
+    std::unordered_map<std::string, Prior> byFields;
+    std::unordered_map<std::string, Prior> byLine;
+    size_t priorRows = 0;
+    mutable std::atomic<uint64_t> matches[4] = {};
+
+    template <typename NodeT>
+    static bool seedRaw(NodeT& node, const Prior& prior, double scale, size_t numActions) {
+        double mass = 0.0;
+        for (size_t a = 0; a < numActions; a++) {
+            auto it = prior.rawSums.find(action_to_string(node.actions[a]));
+            if (it != prior.rawSums.end()) mass += std::max(0.0, it->second.first);
+        }
+        if (mass <= 0.0) return false;
+        for (size_t a = 0; a < numActions; a++) {
+            auto it = prior.rawSums.find(action_to_string(node.actions[a]));
+            node.strategySum[a] = it != prior.rawSums.end() ? scale * it->second.first : 0.0;
+            node.regretSum[a] = it != prior.rawSums.end() ? scale * it->second.second : 0.0;
+        }
+        node.strategyUpdateCount = static_cast<int>(std::min(scale * prior.weight, static_cast<double>(INT32_MAX)));
+        return true;
+    }
+
+    static void merge(Prior& prior, const std::map<std::string, double>& actionProbs, double weight,
+                      const std::map<std::string, std::pair<double, double>>* rawSums) {
+        if (prior.weight == 0.0) {
+            prior.actionProbs = actionProbs;
+            prior.weight = weight;
+            prior.raw = rawSums != nullptr;
+            if (rawSums) prior.rawSums = *rawSums;
+            return;
+        }
+        if (prior.raw && rawSums) {
+            for (const auto& [action, sums] : *rawSums) {
+                prior.rawSums[action].first += sums.first;
+                prior.rawSums[action].second += sums.second;
+            }
+        } else if (prior.raw) {
+            prior.raw = false;
+            prior.rawSums.clear();
+        }
+        for (auto& entry : prior.actionProbs) {
+            entry.second *= prior.weight;
+        }
+        for (const auto& [action, prob] : actionProbs) {
+            prior.actionProbs[action] += prob * weight;
+        }
+        prior.weight += weight;
+        for (auto& entry : prior.actionProbs) {
+            entry.second /= prior.weight;
+        }
+    }
+
+    const Prior* found(MatchLevel level, const Prior& prior) const {
+        matches[level]++;
+        return &prior;
+    }
+};
+
+#endif // SPINGO_WARM_START_CPP
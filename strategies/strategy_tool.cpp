@@ -0,0 +1,146 @@
+/*
+Converts and inspects binary strategy files (spingo/strategy_file.cpp).
+
+  strategy-tool export-csv <in.sgs> <out.csv>
+  strategy-tool import-csv <in.csv> <out.sgs> [rows per block]
+  strategy-tool stats <in.sgs>
+  strategy-tool lookup <in.sgs> "<round>|<player>|<abstraction>|<history>|<pot>" ...
+
+export-csv writes the same header and columns the trainers write (with the
+raw sum columns if the file has them), so the output can go wherever a
+strategy CSV is expected. import-csv converts a
+trainer CSV or --aggregate result; rows it cannot encode are counted and
+skipped. lookup takes --aggregate style keys, e.g. "preflop|2|AAo||1.5".
+
+Build: g++ -std=c++17 -O2 strategies/strategy_tool.cpp -o strategy-tool
+*/
+
+#include "../spingo/strategy_file.cpp"
+#include <iomanip>
+
+static bool exportCsv(const std::string& input, const std::string& output) {
+    StrategyFileReader reader;
+    if (!reader.open(input)) return false;
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Unable to write file: " << output << std::endl;
+        return false;
+    }
+    file << STRATEGY_CSV_HEADER << (reader.rawSums() ? STRATEGY_CSV_RAW_COLUMNS : "") << "\n";
+    std::string buffer;
+    bool ok = reader.forEach([&](const StrategyRow& row) {
+        appendStrategyCsvLine(row, buffer, reader.rawSums());
+        if (buffer.size() >= (1 << 20)) {
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    });
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    if (!ok || !file) return false;
+    std::cout << "Exported " << reader.rows() << " rows to " << output << std::endl;
+    return true;
+}
+
+static bool importCsv(const std::string& input, const std::string& output, uint32_t blockRows) {
+    std::ifstream file(input);
+    if (!file.is_open()) {
+        std::cerr << "Unable to open file: " << input << std::endl;
+        return false;
+    }
+    std::string line;
+    std::getline(file, line);  // header
+    StrategyFileWriter writer;
+    if (!writer.open(output, blockRows, false, line.find("StrategySum") != std::string::npos)) return false;
+    StrategyRow row;
+    size_t skipped = 0;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        if (!parseStrategyCsvLine(line, row) || !writer.add(row)) skipped++;
+    }
+    if (!writer.close()) return false;
+    std::cout << "Imported " << writer.rows() << " rows to " << output;
+    if (skipped > 0) std::cout << " (" << skipped << " rows skipped)";
+    std::cout << std::endl;
+    return true;
+}
+
+static bool printStats(const std::string& input) {
+    StrategyFileReader reader;
+    if (!reader.open(input)) return false;
+
+    uint64_t perRound[STRATEGY_NUM_ROUNDS] = {0};
+    uint64_t actionCount[STRATEGY_NUM_ACTIONS] = {0};
+    uint64_t totalActions = 0, totalUpdates = 0, zeroUpdates = 0;
+    uint32_t maxUpdates = 0;
+    bool ok = reader.forEach([&](const StrategyRow& row) {
+        perRound[row.round]++;
+        for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+            if (row.actionMask >> a & 1) actionCount[a]++;
+        }
+        totalActions += row.probs.size();
+        totalUpdates += row.updateCount;
+        if (row.updateCount <= 1) zeroUpdates++;
+        maxUpdates = std::max(maxUpdates, row.updateCount);
+    });
+    if (!ok) return false;
+
+    std::ifstream sizeProbe(input, std::ios::binary | std::ios::ate);
+    uint64_t bytes = static_cast<uint64_t>(sizeProbe.tellg());
+    uint64_t rows = std::max<uint64_t>(reader.rows(), 1);
+
+    std::cout << input << ": " << reader.rows() << " rows in " << reader.numBlocks() << " blocks, "
+              << (reader.sorted() ? "sorted" : "unsorted") << (reader.exact() ? ", exact" : "")
+              << (reader.rawSums() ? ", raw sums" : "") << ", " << bytes
+              << " bytes (" << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / rows << " bytes/row)\n";
+    std::cout << "  dictionaries: " << reader.numHistories() << " histories, " << reader.numAbstractions()
+              << " abstractions\n";
+    std::cout << "  rows by round:";
+    for (int r = 0; r < STRATEGY_NUM_ROUNDS; r++) std::cout << " " << STRATEGY_ROUND_NAMES[r] << "=" << perRound[r];
+    std::cout << "\n  actions per row: " << std::setprecision(2) << static_cast<double>(totalActions) / rows << "\n";
+    std::cout << "  rows with action:";
+    for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+        if (actionCount[a] > 0) std::cout << " " << STRATEGY_ACTION_NAMES[a] << "=" << actionCount[a];
+    }
+    std::cout << "\n  strategy updates: total " << totalUpdates << ", mean " << std::setprecision(1)
+              << static_cast<double>(totalUpdates) / rows << ", max " << maxUpdates << ", rows with <= 1: "
+              << zeroUpdates << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string command = argc >= 2 ? argv[1] : "";
+
+    if (command == "export-csv" && argc >= 4) {
+        return exportCsv(argv[2], argv[3]) ? 0 : 1;
+    }
+    if (command == "import-csv" && argc >= 4) {
+        uint32_t blockRows = argc >= 5 ? static_cast<uint32_t>(std::stoul(argv[4])) : STRATEGY_FILE_BLOCK_ROWS;
+        return importCsv(argv[2], argv[3], blockRows) ? 0 : 1;
+    }
+    if (command == "stats" && argc >= 3) {
+        return printStats(argv[2]) ? 0 : 1;
+    }
+    if (command == "lookup" && argc >= 4) {
+        StrategyFileReader reader;
+        if (!reader.open(argv[2])) return 1;
+        for (int i = 3; i < argc; i++) {
+            StrategyRow row;
+            if (!reader.find(argv[i], row)) {
+                std::cout << "MISS " << argv[i] << std::endl;
+                continue;
+            }
+            std::string line;
+            appendStrategyCsvLine(row, line);
+            std::cout << line << std::flush;
+        }
+        return 0;
+    }
+
+    std::cerr << "Usage:\n"
+              << "  " << argv[0] << " export-csv <in.sgs> <out.csv>\n"
+              << "  " << argv[0] << " import-csv <in.csv> <out.sgs> [rows per block]\n"
+              << "  " << argv[0] << " stats <in.sgs>\n"
+              << "  " << argv[0] << " lookup <in.sgs> \"<round>|<player>|<abstraction>|<history>|<pot>\" ..." << std::endl;
+    return 1;
+}
@@ -0,0 +1,87 @@
+/*
+Builds, serves and queries read-only strategy stores (spingo/strategy_store.cpp).
+
+  strategy_server build <strategies.csv|checkpoint> <strategy.store>
+  strategy_server serve <strategy.store> <socket path>
+  strategy_server query <socket path> "<hand> <board|-> <actions|->" ...
+  strategy_server bench <socket path> "<request>" [count]
+
+build accepts everything --best-response does: a trainer CSV, an --aggregate
+result or a checkpoint of the current configuration. serve maps the store,
+loads the clusters and answers on the socket until killed; run several
+servers on the same file to spread table processes over cores. Processes
+that link the store directly can open the same file and call query()
+instead of going through the socket. bench sends count requests one at a
+time and reports the round-trip rate.
+
+Build: g++ -std=c++17 -O2 -pthread strategy_server.cpp -o strategy_server
+*/
+
+#define SPINGO_TRAINER_NO_MAIN
+#include "train_optimized.cpp"
+#include "spingo/strategy_store.cpp"
+
+int main(int argc, char* argv[]) {
+    std::string command = argc >= 2 ? argv[1] : "";
+
+    if (command == "build" && argc >= 4) {
+        StrategyProfile profile;
+        if (!loadStrategyProfile(argv[2], profile)) {
+            return 1;
+        }
+        size_t skipped = 0;
+        if (!writeStrategyStore(profile, argv[3], skipped)) {
+            return 1;
+        }
+        std::cout << "Wrote " << (profile.size() - skipped) << " infosets to " << argv[3];
+        if (skipped > 0) std::cout << " (" << skipped << " rows skipped)";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    if (command == "serve" && argc >= 4) {
+        StrategyStore store(postflopBucket);
+        if (!store.open(argv[2])) {
+            return 1;
+        }
+        preloadClusters();
+        return serveStrategyStore(store, argv[3]) ? 0 : 1;
+    }
+
+    if ((command == "query" || command == "bench") && argc >= 4) {
+        StrategyStoreClient client;
+        if (!client.connect(argv[2])) {
+            return 1;
+        }
+        std::string reply;
+        if (command == "query") {
+            for (int i = 3; i < argc; i++) {
+                if (!client.ask(argv[i], reply)) {
+                    std::cerr << "Connection closed by the server" << std::endl;
+                    return 1;
+                }
+                std::cout << reply << std::endl;
+            }
+            return 0;
+        }
+        long count = argc >= 5 ? std::stol(argv[4]) : 10000;
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < count; i++) {
+            if (!client.ask(argv[3], reply)) {
+                std::cerr << "Connection closed by the server" << std::endl;
+                return 1;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << count << " queries in " << std::fixed << std::setprecision(3) << seconds << " s ("
+                  << std::setprecision(0) << count / seconds << " queries/s); last reply: " << reply << std::endl;
+        return 0;
+    }
+
+    std::cerr << "Usage:\n"
+              << "  " << argv[0] << " build <strategies.csv|checkpoint> <strategy.store>\n"
+              << "  " << argv[0] << " serve <strategy.store> <socket path>\n"
+              << "  " << argv[0] << " query <socket path> \"<hand> <board|-> <actions|->\" ...\n"
+              << "  " << argv[0] << " bench <socket path> \"<request>\" [count]" << std::endl;
+    return 1;
+}
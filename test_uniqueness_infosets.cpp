@@ -1,48 +1,67 @@
+#include "spingo/duplicate_check.cpp"
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <unordered_map>
 
+// test_uniqueness_infosets <csv_filename> [--key-columns N] [--header]
+//     [--memory-mb N] [--threads N] [--temp-dir DIR] [--max-report N]
+// Reports the lines of csv_filename that occur more than once, with their
+// line numbers, using the partitioned fingerprint check of
+// spingo/duplicate_check.cpp. --key-columns compares only the first N
+// comma-separated fields (5 for the infoset key of a strategy CSV), --header
+// leaves line 1 out. Returns 1 if duplicates were found.
 int main(int argc, char* argv[]) {
     // Check if a filename was provided
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <csv_filename>" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " <csv_filename> [--key-columns N] [--header] [--memory-mb N] [--threads N]"
+                     " [--temp-dir DIR] [--max-report N]"
+                  << std::endl;
         return 1;
     }
 
-    // Open the CSV file
     std::string filename = argv[1];
-    std::ifstream file(filename);
-    
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
+    DuplicateCheckOptions options;
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--key-columns" && hasValue) options.keyColumns = std::stoi(argv[++i]);
+            else if (arg == "--header") options.skipHeader = true;
+            else if (arg == "--memory-mb" && hasValue) options.memoryBytes = std::stoul(argv[++i]) << 20;
+            else if (arg == "--threads" && hasValue) options.threads = std::stoi(argv[++i]);
+            else if (arg == "--temp-dir" && hasValue) options.tempDir = argv[++i];
+            else if (arg == "--max-report" && hasValue) options.maxReported = std::stoul(argv[++i]);
+            else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
 
-    // Map to store line counts
-    std::unordered_map<std::string, int> line_counts;
-    std::string line;
-    int line_number = 0;
-    bool duplicates_found = false;
+    DuplicateReport report;
+    if (!findDuplicates(filename, report, options)) return 1;
 
-    // Read the file line by line
-    while (std::getline(file, line)) {
-        line_number++;
-        line_counts[line]++;
-        
-        // If this is the second occurrence, report it
-        if (line_counts[line] == 2) {
-            std::cout << "Duplicate found: \"" << line << "\"" << std::endl;
-            duplicates_found = true;
-        }
+    for (const DuplicateGroup& group : report.reported) {
+        std::cout << "Duplicate found: \"" << group.key << "\" (lines";
+        for (size_t i = 0; i < group.lines.size(); i++) std::cout << (i ? ", " : " ") << group.lines[i];
+        std::cout << ")";
+        if (!group.confirmed) std::cout << " [fingerprint collision, lines differ]";
+        std::cout << std::endl;
+    }
+    if (report.groups > report.reported.size()) {
+        std::cout << "... and " << report.groups - report.reported.size() << " more duplicated keys" << std::endl;
     }
 
     // Report the result
-    if (!duplicates_found) {
-        std::cout << "No duplicates found in " << filename << std::endl;
+    if (report.groups == 0) {
+        std::cout << "No duplicates found in " << filename << " (" << report.lines << " lines)" << std::endl;
         return 0;
     } else {
-        std::cout << "Duplicates found in " << filename << std::endl;
+        std::cout << "Duplicates found in " << filename << ": " << report.groups << " keys on more than one line, "
+                  << report.duplicateLines << " repeated lines of " << report.lines << std::endl;
         return 1;  // Return non-zero to indicate duplicates were found
     }
 }
@@ -1,4 +1,5 @@
 #include "spingo/spingo.cpp"
+#include "spingo/strategy_merge.cpp"
 #include <iostream>
 #include <sstream>
 #include <random>
@@ -592,20 +593,12 @@ std::string getInformationSet(const SpinGoState* state, int player) {
         }
     }
     
-    // Add action sequence with more detailed information
-    ss << " Actions:";
+    // Add the current round's actions as packed codes (two hex digits each)
+    std::string actions;
+    state->action_history.append_key(actions);
+    ss << " Actions:" << actions;
     
-    // Include detailed bet amounts for each player
-    const auto& bets = state->bets;
     const auto& pot = state->cumulative_pot;
-
-    auto hist_it = state->round_action_history.find(state->round);
-    if (hist_it != state->round_action_history.end()) {
-        const auto& current_round_actions = hist_it->second;
-        for (const auto& action_pair : current_round_actions) {
-            ss << "[P" << action_pair.first << ":" << action_to_string(action_pair.second) << "]";
-        }
-    }
     
     // Add pot information with individual contributions
     ss << " Pot:" << (pot[0] + pot[1] + pot[2]);
@@ -926,30 +919,7 @@ void saveInfoSetsToFile(const std::string& filename) {
         size_t actionsPos = infoSet.find("Actions:");
         size_t actionsEndPos = infoSet.find(" Pot:", actionsPos);
         if (actionsPos != std::string::npos && actionsEndPos != std::string::npos) {
-            std::string rawActions = infoSet.substr(actionsPos + 8, actionsEndPos - actionsPos - 8);
-            
-            // Parse the actions to extract them in order
-            std::vector<std::string> actionsList;
-            size_t pos = 0;
-            while (pos < rawActions.length()) {
-                size_t startPos = rawActions.find("[", pos);
-                if (startPos == std::string::npos) break;
-                
-                size_t endPos = rawActions.find("]", startPos);
-                if (endPos == std::string::npos) break;
-                
-                std::string action = rawActions.substr(startPos + 1, endPos - startPos - 1);
-                actionsList.push_back(action);
-                pos = endPos + 1;
-            }
-            
-            // Format actions in chronological order
-            for (size_t i = 0; i < actionsList.size(); ++i) {
-                previousActions += actionsList[i];
-                if (i < actionsList.size() - 1) {
-                    previousActions += "|";
-                }
-            }
+            previousActions = action_history_text(infoSet.substr(actionsPos + 8, actionsEndPos - actionsPos - 8));
         }
         
         // Extract cumulative pot instead of pot
@@ -991,139 +961,14 @@ void saveInfoSetsToFile(const std::string& filename) {
     std::cout << "InfoSets saved to " << filename << std::endl;
 }
 
-// Add a simple utility to aggregate strategies from multiple files
-void aggregateStrategies(const std::vector<std::string>& inputFiles, const std::string& outputFile) {
-    // Structure to hold aggregated strategy data
-    struct StrategyEntry {
-        std::string round;
-        std::string player;
-        std::string abstraction;
-        std::string previousActions;
-        std::string pot;
-        std::map<std::string, double> actionProbs;  // Action -> probability
-        int totalVisits;
-    };
-    
-    // Map from infoset key to aggregated strategy
-    std::map<std::string, StrategyEntry> aggregatedStrategies;
-    
-    // Process each input file
-    for (const auto& filename : inputFiles) {
-        std::cout << "Processing file: " << filename << std::endl;
-        std::ifstream file(filename);
-        
-        if (!file.is_open()) {
-            std::cerr << "Unable to open file: " << filename << std::endl;
-            continue;
-        }
-        
-        std::string line;
-        // Skip header
-        std::getline(file, line);
-        
-        // Process each line
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string round, player, abstraction, previousActions, strategyStr, pot, visitCountStr;
-            
-            std::getline(ss, round, ',');
-            std::getline(ss, player, ',');
-            std::getline(ss, abstraction, ',');
-            std::getline(ss, previousActions, ',');
-            std::getline(ss, strategyStr, ',');
-            std::getline(ss, pot, ',');
-            std::getline(ss, visitCountStr, ',');
-            
-            int visitCount = std::stoi(visitCountStr);
-            
-            // Create a key for this infoset
-            std::string key = round + "|" + player + "|" + abstraction + "|" + previousActions + "|" + pot;
-            
-            // Parse strategy string
-            std::map<std::string, double> actionProbs;
-            std::stringstream stratSS(strategyStr);
-            std::string actionProb;
-            
-            while (std::getline(stratSS, actionProb, '|')) {
-                size_t colonPos = actionProb.find(':');
-                if (colonPos != std::string::npos) {
-                    std::string action = actionProb.substr(0, colonPos);
-                    double prob = std::stod(actionProb.substr(colonPos + 1));
-                    actionProbs[action] = prob;
-                }
-            }
-            
-            // If this is the first time seeing this infoset, initialize it
-            if (aggregatedStrategies.find(key) == aggregatedStrategies.end()) {
-                StrategyEntry entry;
-                entry.round = round;
-                entry.player = player;
-                entry.abstraction = abstraction;
-                entry.previousActions = previousActions;
-                entry.pot = pot;
-                entry.actionProbs = actionProbs;
-                entry.totalVisits = visitCount;
-                aggregatedStrategies[key] = entry;
-            } else {
-                // We've seen this infoset before, update with weighted average
-                auto& entry = aggregatedStrategies[key];
-                
-                // For each action in the current strategy
-                for (const auto& [action, prob] : actionProbs) {
-                    // If we haven't seen this action before, initialize it
-                    if (entry.actionProbs.find(action) == entry.actionProbs.end()) {
-                        entry.actionProbs[action] = 0.0;
-                    }
-                    
-                    // Update with weighted average
-                    double oldWeight = static_cast<double>(entry.totalVisits);
-                    double newWeight = static_cast<double>(visitCount);
-                    double totalWeight = oldWeight + newWeight;
-                    
-                    entry.actionProbs[action] = (entry.actionProbs[action] * oldWeight + prob * newWeight) / totalWeight;
-                }
-                
-                // Update total visits
-                entry.totalVisits += visitCount;
-            }
-        }
-        
-        file.close();
-    }
-    
-    // Write aggregated strategies to output file
-    std::ofstream outFile(outputFile);
-    if (!outFile.is_open()) {
-        std::cerr << "Unable to open output file: " << outputFile << std::endl;
-        return;
-    }
-    
-    // Write CSV header
-    outFile << "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,VisitCount\n";
-    
-    // Write each aggregated strategy
-    for (const auto& [key, entry] : aggregatedStrategies) {
-        // Format strategy string
-        std::stringstream strategyStr;
-        bool first = true;
-        for (const auto& [action, prob] : entry.actionProbs) {
-            if (!first) strategyStr << "|";
-            strategyStr << action << ":" << std::fixed << std::setprecision(6) << prob;
-            first = false;
-        }
-        
-        // Write CSV row
-        outFile << entry.round << "," 
-                << entry.player << "," 
-                << entry.abstraction << "," 
-                << entry.previousActions << "," 
-                << strategyStr.str() << "," 
-                << entry.pot << "," 
-                << entry.totalVisits << "\n";
-    }
-    
-    outFile.close();
-    std::cout << "Aggregated " << aggregatedStrategies.size() << " strategies to " << outputFile << std::endl;
+// Aggregates strategy CSVs or .sgs files into outputFile (.sgs output if the
+// name ends in .sgs) with the bounded-memory external merge of
+// spingo/strategy_merge.cpp.
+// The last column holds visit counts.
+bool aggregateStrategies(const std::vector<std::string>& inputFiles, const std::string& outputFile) {
+    StrategyMergeOptions options;
+    options.csvHeader = "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,VisitCount";
+    return mergeStrategyFiles(inputFiles, outputFile, options);
 }
 
 // Add this to main function to handle aggregation command
@@ -1142,8 +987,7 @@ int main(int argc, char* argv[]) {
             inputFiles.push_back(argv[i]);
         }
         
-        aggregateStrategies(inputFiles, outputFile);
-        return 0;
+        return aggregateStrategies(inputFiles, outputFile) ? 0 : 1;
     }
     
     // Original training code
@@ -0,0 +1,567 @@
+/*
+Distributed MCCFR over MPI, for abstractions that need the RAM of several
+machines.
+
+Every rank owns the infosets whose key hashes to it (fnv1a64(key) % ranks)
+and is the only one that stores them. All ranks run traversals. A traversal
+reads owned nodes directly. For a node owned by another rank it reads a
+cached copy of that node's regrets, or a fresh (uniform) node if it has not
+seen one yet. Regret and strategy-sum increments for remote nodes are summed
+per key and shipped to their owners every --exchange-every iterations per rank in
+an MPI_Alltoallv. Owners apply them and answer with the updated regrets of
+every key they received, which refreshes the senders' caches. Remote strategies therefore lag by at
+most one exchange, and the cache only holds keys a rank has touched (it is
+dropped when it exceeds --cache-entries).
+
+Each rank writes its own infosets to <output>.rank<r>.csv. Rank 0 then
+concatenates the shards into <output> when it can read them all (always on
+one machine; shards are left in place otherwise, and are disjoint, so
+`train_optimized --aggregate` merges them too). --checkpoint-every writes
+one checkpoint per rank at exchange boundaries, tied to the rank count.
+--ram-budget gives every rank a cold tier as in the other trainers.
+
+Build: mpicxx -std=c++17 -O2 -pthread train_mpi.cpp -o train_mpi
+Run:   mpirun -np 4 ./train_mpi 100000 strategies.csv [--exchange-every 100]
+           [--cache-entries 2000000] [--checkpoint-every N] [--resume] [--ram-budget MB]
+           [--warm-start strategies.csv|checkpoint] [--warm-start-weight 1.0]
+*/
+
+#define SPINGO_TRAINER_NO_MAIN
+#include "train_optimized.cpp"
+#include <mpi.h>
+#include <climits>
+#include <cstdio>
+
+int mpiRank = 0;
+int mpiSize = 1;
+
+int ownerOf(const std::string& infoSet) {
+    return static_cast<int>(fnv1a64(infoSet) % static_cast<uint64_t>(mpiSize));
+}
+
+// Summed increments for one infoset owned by another rank
+struct PendingUpdate {
+    std::vector<Action> actions;
+    std::vector<double> regretDelta;
+    std::vector<double> strategyDelta;
+    int32_t updateCount = 0;
+    InfosetFields fields;  // so the owner's node gets its CSV fields
+};
+
+// Outgoing increments by owner rank, and cached copies of remote nodes
+std::vector<std::unordered_map<std::string, PendingUpdate>> pendingUpdates;
+std::unordered_map<std::string, Node> remoteCache;
+size_t remoteCacheLimit = 2000000;
+uint64_t remoteCacheHits = 0;
+uint64_t remoteCacheMisses = 0;
+
+// The node a traversal reads: owned, cached, or fresh with a uniform strategy.
+// Each rank is single-threaded, so the table is used without its locks.
+Node readNode(const SpinGoState* state, const std::string& infoSet, const std::vector<Action>& legalActions) {
+    if (ownerOf(infoSet) == mpiRank) {
+        auto& partition = nodeMap.partitionFor(infoSet);
+        Node* existing = partition.find(infoSet);
+        if (existing && existing->strategy.size() == legalActions.size()) {
+            return *existing;
+        }
+        Node fresh = newNode(state, infoSet, legalActions);
+        if (!existing) {
+            metricAdd(METRIC_NEW_INFOSETS);
+        }
+        partition.store(infoSet, fresh);
+        return fresh;
+    }
+    auto it = remoteCache.find(infoSet);
+    if (it != remoteCache.end() && it->second.strategy.size() == legalActions.size()) {
+        remoteCacheHits++;
+        return it->second;
+    }
+    remoteCacheMisses++;
+    return newNode(nullptr, infoSet, legalActions);
+}
+
+void addToNode(Node& node, const std::vector<double>& regretDelta, const std::vector<double>& strategyDelta,
+               int updateCount) {
+    for (size_t i = 0; i < regretDelta.size() && i < node.regretSum.size(); i++) {
+        node.regretSum[i] += regretDelta[i];
+    }
+    for (size_t i = 0; i < strategyDelta.size() && i < node.strategySum.size(); i++) {
+        node.strategySum[i] += strategyDelta[i];
+    }
+    node.strategyUpdateCount += updateCount;
+}
+
+// Applies increments to an owned node, or queues them for the owner (and
+// applies them to the cached copy so this rank sees its own updates). A new
+// node's fields come from state, or from received for updates that came
+// from another rank.
+void addUpdate(const std::string& infoSet, const std::vector<Action>& actions, const std::vector<double>& regretDelta,
+               const std::vector<double>& strategyDelta, int updateCount, const SpinGoState* state,
+               const InfosetFields& received = InfosetFields()) {
+    int owner = ownerOf(infoSet);
+    if (owner == mpiRank) {
+        auto& partition = nodeMap.partitionFor(infoSet);
+        Node* node = partition.find(infoSet);
+        if (!node || node->regretSum.size() != actions.size()) {
+            // First seen here through another rank's update: build it as
+            // readNode() would, so it gets its actions and warm-start seed
+            Node fresh = newNode(state, infoSet, actions);
+            if (!state) fresh.fields = received;
+            if (!node) {
+                metricAdd(METRIC_NEW_INFOSETS);
+            }
+            node = &partition.store(infoSet, fresh);
+        }
+        addToNode(*node, regretDelta, strategyDelta, updateCount);
+        return;
+    }
+    PendingUpdate& update = pendingUpdates[owner][infoSet];
+    if (update.actions.size() != actions.size()) {
+        update.actions = actions;
+        update.regretDelta.assign(actions.size(), 0.0);
+        update.strategyDelta.assign(actions.size(), 0.0);
+        update.updateCount = 0;
+        update.fields = state ? InfosetFields::fromState(*state, postflopBucket) : received;
+    }
+    for (size_t i = 0; i < regretDelta.size(); i++) update.regretDelta[i] += regretDelta[i];
+    for (size_t i = 0; i < strategyDelta.size(); i++) update.strategyDelta[i] += strategyDelta[i];
+    update.updateCount += updateCount;
+
+    auto cached = remoteCache.find(infoSet);
+    if (cached != remoteCache.end() && cached->second.regretSum.size() == actions.size()) {
+        addToNode(cached->second, regretDelta, strategyDelta, updateCount);
+    }
+}
+
+// MCCFR traversal as in mccfr(), but every node change is expressed as an
+// increment so it can be applied on the owning rank.
+double mccfrDistributed(SpinGoState* state, int player, std::vector<double>& reachProb) {
+    if (state->game_over) {
+        metricAdd(METRIC_TERMINAL_EVALS);
+        return state->runout_pending() ? allInExpectedReturns(*state)[player] : state->returns()[player];
+    }
+
+    if (state->is_chance_node()) {
+        state->apply_action(Action::DEAL);
+        return mccfrDistributed(state, player, reachProb);
+    }
+
+    int currPlayer = state->current_player();
+    std::string infoSet = getInformationSet(state);
+    metricAdd(METRIC_NODES_TOUCHED);
+
+    std::vector<Action> legalActions = state->legal_actions();
+    if (legalActions.empty()) {
+        std::cerr << "Error: No legal actions available for player " << currPlayer << std::endl;
+        return 0.0;
+    }
+
+    Node node = readNode(state, infoSet, legalActions);
+    std::vector<double> strategy = node.getStrategy(0.0);
+    size_t numActions = legalActions.size();
+
+    double opponent_reach_prod = 1.0;
+    for (int i = 0; i < NUM_PLAYERS; ++i) {
+        if (i != currPlayer) {
+            opponent_reach_prod *= reachProb[i];
+        }
+    }
+
+    // Strategy sums grow by the opponents' reach (and, for the traverser,
+    // its own reach, as getStrategy() adds in mccfr())
+    std::vector<double> strategyDelta(numActions, 0.0);
+    bool strategyUpdated = false;
+    for (size_t i = 0; i < numActions; i++) {
+        if (currPlayer == player) {
+            strategyDelta[i] += reachProb[player] * strategy[i];
+        }
+        if (numActions > 1 && opponent_reach_prod > 0) {
+            strategyDelta[i] += opponent_reach_prod * strategy[i];
+        }
+        if (strategyDelta[i] != 0.0) {
+            strategyUpdated = true;
+        }
+    }
+
+    if (currPlayer == player) {
+        double nodeUtil = 0.0;
+        std::vector<double> actionUtils(numActions);
+        SpinGoState stateCopy = *state;
+
+        for (size_t i = 0; i < numActions; i++) {
+            SpinGoState& nextState = (i == 0) ? stateCopy : (stateCopy = *state);
+            nextState.apply_action(legalActions[i]);
+
+            double originalReachProb = reachProb[player];
+            reachProb[player] *= strategy[i];
+            actionUtils[i] = mccfrDistributed(&nextState, player, reachProb);
+            reachProb[player] = originalReachProb;
+
+            nodeUtil += strategy[i] * actionUtils[i];
+        }
+
+        std::vector<double> regretDelta(numActions);
+        for (size_t i = 0; i < numActions; i++) {
+            regretDelta[i] = opponent_reach_prod * (actionUtils[i] - nodeUtil);
+        }
+        addUpdate(infoSet, legalActions, regretDelta, strategyDelta, strategyUpdated ? 1 : 0, state);
+        return nodeUtil;
+    }
+
+    addUpdate(infoSet, legalActions, std::vector<double>(), strategyDelta, strategyUpdated ? 1 : 0, state);
+
+    int actionIndex = sampleAction(strategy);
+    if (actionIndex < 0 || actionIndex >= static_cast<int>(numActions)) {
+        actionIndex = 0;
+    }
+
+    double originalReachProb = reachProb[currPlayer];
+    reachProb[currPlayer] *= strategy[actionIndex];
+    state->apply_action(legalActions[actionIndex]);
+    double result = mccfrDistributed(state, player, reachProb);
+    reachProb[currPlayer] = originalReachProb;
+    return result;
+}
+
+// Wire format of both exchange messages: uint32 keyLength, key,
+// uint32 numActions, numActions x uint8 action, then numActions doubles per
+// array (regretDelta and strategyDelta plus int32 updateCount and the
+// InfosetFields bytes for updates, regretSum for replies).
+template <typename T>
+void appendPod(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readPodAt(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+void appendKeyAndActions(std::string& buffer, const std::string& key, const std::vector<Action>& actions) {
+    appendPod<uint32_t>(buffer, static_cast<uint32_t>(key.size()));
+    buffer.append(key);
+    appendPod<uint32_t>(buffer, static_cast<uint32_t>(actions.size()));
+    for (Action action : actions) appendPod<uint8_t>(buffer, static_cast<uint8_t>(action));
+}
+
+void readKeyAndActions(const char*& p, std::string& key, std::vector<Action>& actions) {
+    uint32_t keyLength = readPodAt<uint32_t>(p);
+    key.assign(p, keyLength);
+    p += keyLength;
+    uint32_t numActions = readPodAt<uint32_t>(p);
+    actions.resize(numActions);
+    for (uint32_t a = 0; a < numActions; a++) actions[a] = static_cast<Action>(readPodAt<uint8_t>(p));
+}
+
+// Sends one buffer to every rank and returns what every rank sent to this
+// one, concatenated in rank order (offsets[r] marks where rank r's part starts).
+bool allToAll(const std::vector<std::string>& outgoing, std::string& incoming, std::vector<int>& offsets) {
+    std::vector<int> sendCounts(mpiSize), recvCounts(mpiSize), sendOffsets(mpiSize);
+    long total = 0;
+    for (int r = 0; r < mpiSize; r++) {
+        if (outgoing[r].size() > static_cast<size_t>(INT_MAX) || total + static_cast<long>(outgoing[r].size()) > INT_MAX) {
+            std::cerr << "Rank " << mpiRank << ": exchange buffer over 2 GB; lower --exchange-every" << std::endl;
+            return false;
+        }
+        sendCounts[r] = static_cast<int>(outgoing[r].size());
+        sendOffsets[r] = static_cast<int>(total);
+        total += sendCounts[r];
+    }
+    std::string sendBuffer;
+    sendBuffer.reserve(total);
+    for (const auto& part : outgoing) sendBuffer.append(part);
+
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    offsets.assign(mpiSize + 1, 0);
+    for (int r = 0; r < mpiSize; r++) {
+        if (static_cast<long>(offsets[r]) + recvCounts[r] > INT_MAX) {
+            std::cerr << "Rank " << mpiRank << ": incoming exchange over 2 GB; lower --exchange-every" << std::endl;
+            return false;
+        }
+        offsets[r + 1] = offsets[r] + recvCounts[r];
+    }
+    incoming.assign(offsets[mpiSize], '\0');
+    MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendOffsets.data(), MPI_CHAR,
+                  &incoming[0], recvCounts.data(), offsets.data(), MPI_CHAR, MPI_COMM_WORLD);
+    return true;
+}
+
+// Ships queued increments to their owners, applies the ones received, and
+// refreshes the cache with the owners' regrets. Returns the bytes this rank
+// sent, or -1 on failure (every rank sees the failure through the reduction
+// in the caller).
+long exchangeUpdates() {
+    std::vector<std::string> requests(mpiSize);
+    for (int r = 0; r < mpiSize; r++) {
+        for (const auto& entry : pendingUpdates[r]) {
+            const PendingUpdate& update = entry.second;
+            appendKeyAndActions(requests[r], entry.first, update.actions);
+            requests[r].append(reinterpret_cast<const char*>(update.regretDelta.data()), update.regretDelta.size() * sizeof(double));
+            requests[r].append(reinterpret_cast<const char*>(update.strategyDelta.data()), update.strategyDelta.size() * sizeof(double));
+            appendPod<int32_t>(requests[r], update.updateCount);
+            appendPod<InfosetFields>(requests[r], update.fields);
+        }
+        pendingUpdates[r].clear();
+    }
+    long sent = 0;
+    for (const auto& part : requests) sent += part.size();
+
+    std::string incoming;
+    std::vector<int> offsets;
+    if (!allToAll(requests, incoming, offsets)) return -1;
+
+    // Apply and answer with the node as it is now
+    std::vector<std::string> replies(mpiSize);
+    std::string key;
+    std::vector<Action> actions;
+    for (int r = 0; r < mpiSize; r++) {
+        const char* p = incoming.data() + offsets[r];
+        const char* end = incoming.data() + offsets[r + 1];
+        while (p < end) {
+            readKeyAndActions(p, key, actions);
+            std::vector<double> regretDelta(actions.size()), strategyDelta(actions.size());
+            std::memcpy(regretDelta.data(), p, actions.size() * sizeof(double));
+            p += actions.size() * sizeof(double);
+            std::memcpy(strategyDelta.data(), p, actions.size() * sizeof(double));
+            p += actions.size() * sizeof(double);
+            int32_t updateCount = readPodAt<int32_t>(p);
+            InfosetFields fields = readPodAt<InfosetFields>(p);
+            addUpdate(key, actions, regretDelta, strategyDelta, updateCount, nullptr, fields);
+
+            const Node& node = *nodeMap.partitionFor(key).find(key);
+            appendKeyAndActions(replies[r], key, actions);
+            replies[r].append(reinterpret_cast<const char*>(node.regretSum.data()), node.regretSum.size() * sizeof(double));
+        }
+    }
+    for (const auto& part : replies) sent += part.size();
+
+    if (!allToAll(replies, incoming, offsets)) return -1;
+    if (remoteCache.size() > remoteCacheLimit) {
+        remoteCache.clear();
+    }
+    const char* p = incoming.data();
+    const char* end = incoming.data() + incoming.size();
+    while (p < end) {
+        readKeyAndActions(p, key, actions);
+        Node& cached = remoteCache[key];
+        if (cached.regretSum.size() != actions.size()) {
+            cached = Node(actions);
+        }
+        std::memcpy(cached.regretSum.data(), p, actions.size() * sizeof(double));
+        p += actions.size() * sizeof(double);
+    }
+    return sent;
+}
+
+// Loads this rank's checkpoint; every rank must be at the same iteration.
+bool resumeDistributed(const std::string& checkpointFile, CheckpointInfo& info) {
+    bool haveFile = std::ifstream(checkpointFile).good();
+    int ok = haveFile ? (loadCheckpoint(checkpointFile, nodeMap, info, info.configHash) ? 1 : 0) : 1;
+    if (haveFile && ok) {
+        restoreSamplerRng(info.rngState);
+    }
+    long iteration = haveFile && ok ? static_cast<long>(info.iteration) : 0;
+    int allOk = 0;
+    long minIteration = 0, maxIteration = 0;
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&iteration, &minIteration, 1, MPI_LONG, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&iteration, &maxIteration, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (!allOk || minIteration != maxIteration) {
+        if (mpiRank == 0) {
+            std::cerr << "Rank checkpoints are missing or from different iterations (" << minIteration << " to "
+                      << maxIteration << "); not resuming" << std::endl;
+        }
+        return false;
+    }
+    if (mpiRank == 0 && maxIteration > 0) {
+        std::cout << "Resumed all ranks at iteration " << maxIteration << std::endl;
+    }
+    return true;
+}
+
+// Rank 0 concatenates the rank shards into one CSV; they hold disjoint keys.
+bool mergeShards(const std::string& outputFilename) {
+    std::ofstream out(outputFilename);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open file: " << outputFilename << std::endl;
+        return false;
+    }
+    for (int r = 0; r < mpiSize; r++) {
+        std::ifstream shard(outputFilename + ".rank" + std::to_string(r) + ".csv");
+        if (!shard.is_open()) {
+            std::cerr << "Shard of rank " << r << " is not readable from rank 0; leaving the shards in place" << std::endl;
+            return false;
+        }
+        std::string line;
+        bool header = true;
+        while (std::getline(shard, line)) {
+            if (header) {
+                header = false;
+                if (r > 0) continue;
+            }
+            out << line << '\n';
+        }
+    }
+    out.close();
+    if (!out) return false;
+    for (int r = 0; r < mpiSize; r++) {
+        std::remove((outputFilename + ".rank" + std::to_string(r) + ".csv").c_str());
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    long iterations = 10000;
+    std::string outputFilename = "spingo_strategies_mpi.csv";
+    int exchangeEvery = 100;  // iterations per rank between exchanges
+    int checkpointEvery = 0;
+    bool resume = false;
+    long ramBudgetMB = 0;
+    std::string warmStartFile;
+
+    if (argc >= 2) {
+        try {
+            iterations = std::stol(argv[1]);
+        } catch (...) {
+            if (mpiRank == 0) std::cerr << "Invalid iterations value. Using default: " << iterations << std::endl;
+        }
+    }
+    if (argc >= 3) {
+        outputFilename = argv[2];
+    }
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--exchange-every" && i + 1 < argc) {
+            exchangeEvery = std::max(1, std::stoi(argv[++i]));
+        } else if (std::string(argv[i]) == "--cache-entries" && i + 1 < argc) {
+            remoteCacheLimit = std::stoul(argv[++i]);
+        } else if (std::string(argv[i]) == "--checkpoint-every" && i + 1 < argc) {
+            checkpointEvery = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--resume") {
+            resume = true;
+        } else if (std::string(argv[i]) == "--ram-budget" && i + 1 < argc) {
+            ramBudgetMB = std::stol(argv[++i]);
+        } else if (std::string(argv[i]) == "--warm-start" && i + 1 < argc) {
+            warmStartFile = argv[++i];
+        } else if (std::string(argv[i]) == "--warm-start-weight" && i + 1 < argc) {
+            warmStartScale = std::stod(argv[++i]);
+        }
+    }
+
+    std::string shardPrefix = outputFilename + ".rank" + std::to_string(mpiRank);
+    if (ramBudgetMB > 0 && !nodeMap.enableColdTier(shardPrefix + ".cold", static_cast<uint64_t>(ramBudgetMB) << 20)) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    pendingUpdates.resize(mpiSize);
+    samplerSeedRng.seed(static_cast<unsigned>(std::time(0)) ^ (0x9E3779B9u * static_cast<unsigned>(mpiRank + 1)));
+
+    preloadClusters();
+    SpinGoGame game;
+    // Every rank loads the whole prior: remote nodes are seeded too until
+    // their owner's regrets arrive
+    if (!warmStartFile.empty() && !loadWarmStart(warmStartFile)) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (mpiRank == 0) {
+        std::cout << "Distributed training with " << iterations << " iterations on " << mpiSize << " ranks" << std::endl;
+        std::cout << "Exchange every " << exchangeEvery << " iterations per rank; results will be saved to: "
+                  << outputFilename << std::endl;
+    }
+
+    // Checkpoints depend on the rank count through the key ownership
+    std::string checkpointFile = shardPrefix + ".ckpt";
+    CheckpointInfo info;
+    info.configHash = fnv1a64("ranks=" + std::to_string(mpiSize), computeConfigHash());
+    info.totalUtility.assign(NUM_PLAYERS, 0.0);
+    if (resume && !resumeDistributed(checkpointFile, info)) {
+        MPI_Finalize();
+        return 1;
+    }
+
+    long done = static_cast<long>(info.iteration);
+    long sinceCheckpoint = 0;
+    double totalBytes = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < iterations) {
+        // The same split on every rank, so all of them reach every exchange
+        long roundTotal = std::min(static_cast<long>(exchangeEvery) * mpiSize, iterations - done);
+        long mine = roundTotal / mpiSize + (mpiRank < roundTotal % mpiSize ? 1 : 0);
+        for (long it = 0; it < mine; it++) {
+            seedSamplerRng();
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                SpinGoState state = game.new_initial_state();
+                state.defer_allin_runout = true;
+                std::vector<double> reachProb(NUM_PLAYERS, 1.0);
+                info.totalUtility[p] += mccfrDistributed(&state, p, reachProb);
+            }
+            metricAdd(METRIC_ITERATIONS);
+        }
+
+        long sent = exchangeUpdates();
+        long failed = sent < 0 ? 1 : 0, anyFailed = 0;
+        MPI_Allreduce(&failed, &anyFailed, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+        if (anyFailed) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        double roundBytes = 0.0, mineBytes = static_cast<double>(sent);
+        long owned = static_cast<long>(nodeMap.size()), totalOwned = 0;
+        MPI_Reduce(&mineBytes, &roundBytes, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&owned, &totalOwned, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        done += roundTotal;
+        sinceCheckpoint += roundTotal;
+        totalBytes += roundBytes;
+
+        if (mpiRank == 0) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "\rIteration " << done << " (" << std::fixed << std::setprecision(4)
+                      << 100.0 * done / iterations << "% completed), " << totalOwned << " infosets, "
+                      << std::setprecision(1) << totalBytes / (1024.0 * 1024.0) << " MB exchanged, "
+                      << elapsed << " s" << std::flush;
+        }
+
+        if (checkpointEvery > 0 && (sinceCheckpoint >= checkpointEvery || done == iterations)) {
+            sinceCheckpoint = 0;
+            info.iteration = done;
+            info.rngState = samplerRngState();
+            int ok = saveCheckpoint(checkpointFile, nodeMap, info) ? 1 : 0, allOk = 0;
+            MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+            if (mpiRank == 0) {
+                std::cout << "\nCheckpoint at iteration " << done << (allOk ? " written by every rank" : " FAILED on some rank")
+                          << std::endl;
+            }
+        }
+    }
+    if (mpiRank == 0) {
+        std::cout << "\nTraining completed." << std::endl;
+    }
+
+    std::vector<double> totalUtility(NUM_PLAYERS, 0.0);
+    MPI_Reduce(info.totalUtility.data(), totalUtility.data(), NUM_PLAYERS, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    uint64_t hits[2] = {remoteCacheHits, remoteCacheMisses}, allHits[2] = {0, 0};
+    MPI_Reduce(hits, allHits, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    saveInfoSetsToFile(shardPrefix + ".csv");
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (mpiRank == 0) {
+        if (allHits[0] + allHits[1] > 0) {
+            std::cout << "Remote node cache hit rate: " << std::fixed << std::setprecision(2)
+                      << 100.0 * allHits[0] / (allHits[0] + allHits[1]) << "%" << std::endl;
+        }
+        if (done > 0) {
+            saveFinalResults(totalUtility, static_cast<int>(done));
+        }
+        if (mergeShards(outputFilename)) {
+            std::cout << "Merged " << mpiSize << " rank shards into " << outputFilename << std::endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -1,4 +1,19 @@
 #include "spingo/spingo.cpp"
+#include "spingo/vector_cfr.cpp"
+#include "spingo/infoset_fields.cpp"
+#include "spingo/infoset_census.cpp"
+#include "spingo/strategy_merge.cpp"
+#include "spingo/allin_equity.cpp"
+#include "spingo/checkpoint.cpp"
+#include "spingo/snapshot.cpp"
+#include "spingo/metrics.cpp"
+#include "spingo/scheduler.cpp"
+#include "spingo/infoset_index.cpp"
+#include "spingo/node_table.cpp"
+#include "spingo/infoset_trie.cpp"
+#include "spingo/best_response.cpp"
+#include "spingo/warm_start.cpp"
+#include "spingo/subgame_solver.cpp"
 #include <iostream>
 #include <sstream>
 #include <random>
@@ -24,23 +39,28 @@ public:
     std::vector<double> getStrategy(double realizationWeight);
     std::vector<double> getAverageStrategy() const;
     std::vector<Action> getActions() const;
-    std::vector<double> regretSum;
-    std::vector<double> strategy;
-    std::vector<double> strategySum;
-    std::vector<Action> actions;
+    NodeVector<double> regretSum;
+    NodeVector<double> strategy;
+    NodeVector<double> strategySum;
+    NodeVector<Action> actions;
     int strategyUpdateCount;  // Replaced visitCount
+    InfosetFields fields;     // CSV columns, unset for nodes created without a state
 };
 
 // Add these global variables to cache cluster data
 std::unordered_map<std::string, std::unordered_map<std::string, std::string>> clusterCache;
 bool clustersLoaded = false;
 
-// Initialize global nodeMap
-std::unordered_map<std::string, Node> nodeMap;
+// Initialize global nodeMap (partitions and NUMA layout set by --partitions / --numa)
+PartitionedNodeTable<Node> nodeMap;
+// Path index into nodeMap for the MCCFR traversal (off with --no-trie or --ram-budget)
+InfosetTrie<PartitionedNodeTable<Node>> infosetTrie;
 
 static int mccfr_depth = 0;
-// Add mutex for nodeMap access
-std::mutex nodeMapMutex;
+// Pin the parallel trainer's worker threads to CPUs (--pin-threads)
+bool pinWorkerThreads = false;
+// Export each node's strategySum and regretSum next to the strategy (--raw-sums)
+bool exportRawSums = false;
 
 // Node implementation
 Node::Node() : regretSum(5, 0.0), strategy(5, 0.0), strategySum(5, 0.0), strategyUpdateCount(0) {}
@@ -54,11 +74,11 @@ Node::Node(const std::vector<Action>& legalActions) :
     regretSum(legalActions.size(), 0.0), 
     strategy(legalActions.size(), 0.0),
     strategySum(legalActions.size(), 0.0),
-    actions(legalActions),
+    actions(legalActions.begin(), legalActions.end()),
     strategyUpdateCount(0) {}
 
 std::vector<double> Node::getStrategy(double realizationWeight) {
-    std::vector<double> result = strategy;
+    std::vector<double> result(strategy.begin(), strategy.end());
     double normalizingSum = 0;
     int numActions = regretSum.size();
     
@@ -95,7 +115,7 @@ std::vector<double> Node::getAverageStrategy() const {
 }
 
 std::vector<Action> Node::getActions() const {
-    return actions;
+    return std::vector<Action>(actions.begin(), actions.end());
 }
 
 // Helper function to determine if two cards are suited
@@ -552,8 +572,23 @@ int getRiverCluster(const std::vector<Card>& communityCards, const std::vector<C
     }
 }
 
-// Now define getInformationSet after SpinGoState is fully defined
-std::string getInformationSet(const SpinGoState* state) {
+// Postflop bucket of two hole cards on a five-card board (1 = flop, 2 = turn,
+// 3 = river), for the vector-form solvers.
+int postflopBucket(int roundIdx, int hole1, int hole2, const int* board) {
+    std::vector<Card> holeCards = {cardFromIndex(hole1), cardFromIndex(hole2)};
+    std::vector<Card> communityCards;
+    for (int i = 0; i < roundIdx + 2; i++) {
+        communityCards.push_back(cardFromIndex(board[i]));
+    }
+    if (roundIdx == 1) return getFlopCluster(communityCards, holeCards);
+    if (roundIdx == 2) return getTurnCluster(communityCards, holeCards);
+    return getRiverCluster(communityCards, holeCards);
+}
+
+// Now define getInformationSet after SpinGoState is fully defined. A bucket
+// >= 0 is used as the postflop cluster instead of the one of the actor's
+// cards (keys of enumerated infosets).
+std::string getInformationSet(const SpinGoState* state, int bucket = -1) {
     if (state->is_chance_node()) {
         return "";
     }
@@ -602,37 +637,27 @@ std::string getInformationSet(const SpinGoState* state) {
     if (state->round == "flop" || state->round == "turn" || state->round == "river" || state->round == "showdown") {
         // For flop, turn, and river, add cluster information
         if (state->round == "flop") {
-            int flopCluster = getFlopCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
+            int flopCluster = bucket >= 0 ? bucket : getFlopCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
             result.append(" FlopCluster:");
             result.append(std::to_string(flopCluster));
         } else if (state->round == "turn") {
-            int turnCluster = getTurnCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
+            int turnCluster = bucket >= 0 ? bucket : getTurnCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
             result.append(" TurnCluster:");
             result.append(std::to_string(turnCluster));
         } else if (state->round == "river" || state->round == "showdown") {
-            int riverCluster = getRiverCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
+            int riverCluster = bucket >= 0 ? bucket : getRiverCluster(state->community_cards, {cards[player*2], cards[player*2+1]});
             result.append(" RiverCluster:");
             result.append(std::to_string(riverCluster));
         }
     }
     
-    // Add action sequence with more detailed information
+    // Add the current round's actions as packed codes (two hex digits each);
+    // parseInfoSetKey spells them out for export
     result.append(" Actions:");
+    state->action_history.append_key(result);
     
-    // Include detailed bet amounts for each player
-    const auto& bets = state->bets;
     const auto& pot = state->pot;
     const auto& cumulative_pot = state->cumulative_pot;
-
-    auto hist_it = state->round_action_history.find(state->round);
-    if (hist_it != state->round_action_history.end()) {
-        const auto& current_round_actions = hist_it->second;
-        std::stringstream ss;  // Declare the stringstream here
-        for (const auto& action_pair : current_round_actions) {
-            ss << "[P" << action_pair.first << ":" << action_to_string(action_pair.second) << "]";
-        }
-        result.append(ss.str());
-    }
     
     // Add pot information with individual contributions
     result.append(" Pot:");
@@ -657,9 +682,34 @@ std::string getInformationSet(const SpinGoState* state) {
     return result;
 }
 
+// Action sampling uses a per-thread RNG that seedSamplerRng() reseeds from
+// samplerSeedRng at the start of every iteration, so workers never share an
+// engine. Checkpoints save and restore samplerSeedRng, which only changes
+// under samplerSeedMutex.
+std::mt19937 samplerSeedRng((unsigned)std::time(0));
+std::mutex samplerSeedMutex;
+thread_local std::mt19937 samplerRng;
+
+void seedSamplerRng() {
+    std::lock_guard<std::mutex> lock(samplerSeedMutex);
+    samplerRng.seed(samplerSeedRng());
+}
+
+std::string samplerRngState() {
+    std::lock_guard<std::mutex> lock(samplerSeedMutex);
+    std::ostringstream rngStream;
+    rngStream << samplerSeedRng;
+    return rngStream.str();
+}
+
+void restoreSamplerRng(const std::string& state) {
+    std::lock_guard<std::mutex> lock(samplerSeedMutex);
+    std::istringstream rngStream(state);
+    rngStream >> samplerSeedRng;
+}
+
 int sampleAction(const std::vector<double>& probs) {
-    static std::mt19937 rng((unsigned)std::time(0));
-    double r = std::uniform_real_distribution<>(0, 1)(rng);
+    double r = std::uniform_real_distribution<>(0, 1)(samplerRng);
     double cumulative = 0.0;
     for (size_t i = 0; i < probs.size(); i++) {
         cumulative += probs[i];
@@ -669,25 +719,57 @@ int sampleAction(const std::vector<double>& probs) {
     return probs.size() - 1;
 }
 
-// MCCFR implementation
-double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
+void parseInfoSetKey(const std::string& infoSet, std::string& round, std::string& player,
+                     std::string& abstraction, std::string& previousActions, std::string& pot);
+
+// Prior strategy that new infosets are seeded from (--warm-start)
+WarmStartTable warmStart;
+double warmStartScale = 1.0;
+
+// Node for an infoset seen for the first time, with its CSV fields taken
+// from state (when given) and seeded from the warm-start prior when it has one
+Node newNode(const SpinGoState* state, const std::string& infoSet, const std::vector<Action>& legalActions) {
+    Node node(legalActions);
+    if (state) node.fields = InfosetFields::fromState(*state, postflopBucket);
+    if (warmStart.enabled()) {
+        std::string round, player, abstraction, previousActions, pot;
+        parseInfoSetKey(infoSet, round, player, abstraction, previousActions, pot);
+        if (const WarmStartTable::Prior* prior = warmStart.lookup(infoSet, round, player, abstraction, previousActions, pot)) {
+            warmStart.seed(node, *prior, warmStartScale);
+        }
+    }
+    return node;
+}
+
+// MCCFR implementation. at is the infoset trie node of state's public
+// action sequence (nullptr with the trie off).
+double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb,
+             InfosetTrie<PartitionedNodeTable<Node>>::PublicNode* at = nullptr) {
     mccfr_depth++;
     
     if (state->game_over) {
-        double result = state->returns()[player];
+        metricAdd(METRIC_TERMINAL_EVALS);
+        // All-in hands are scored by their exact expectation over the runout
+        double result = state->runout_pending() ? allInExpectedReturns(*state)[player] : state->returns()[player];
         if (mccfr_depth > 0) mccfr_depth--;
         return result;
     }
 
     if (state->is_chance_node()) {
         state->apply_action(Action::DEAL);
-        double result = mccfr(state, player, reachProb);
+        double result = mccfr(state, player, reachProb, infosetTrie.child(at, Action::DEAL));
         if (mccfr_depth > 0) mccfr_depth--;
         return result;
     }
 
     int currPlayer = state->current_player();
-    std::string infoSet = getInformationSet(state);
+    // An infoset seen before on this action sequence is reached through its
+    // trie entry; otherwise the key is built and hashed
+    auto* entry = infosetTrie.entry(at, *state);
+    Node* known = entry ? entry->node.load(std::memory_order_acquire) : nullptr;
+    std::string infoSet = known ? std::string() : getInformationSet(state);
+    auto& partition = known ? *entry->partition.load(std::memory_order_relaxed) : nodeMap.partitionFor(infoSet);
+    metricAdd(METRIC_NODES_TOUCHED);
 
     std::vector<Action> legalActions = state->legal_actions();
     
@@ -702,15 +784,23 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
     bool nodeExists = false;
     
     {
-        std::lock_guard<std::mutex> lock(nodeMapMutex);
-        auto nodeIt = nodeMap.find(infoSet);
-        if (nodeIt != nodeMap.end() && nodeIt->second.strategy.size() == legalActions.size()) {
-            localNode = nodeIt->second;  // Make a copy
+        auto lock = metricsLock(partition.mutex);
+        Node* existing = known ? known : partition.find(infoSet);
+        if (existing && existing->strategy.size() == legalActions.size()) {
+            localNode = *existing;  // Make a copy
             nodeExists = true;
         } else {
-            localNode = Node(legalActions);
-            nodeMap[infoSet] = localNode;  // Store a copy in the map
+            if (infoSet.empty()) infoSet = getInformationSet(state);
+            localNode = newNode(state, infoSet, legalActions);
+            if (!existing) {
+                metricAdd(METRIC_NEW_INFOSETS);
+                metricAdd(METRIC_BYTES_ALLOCATED, sizeof(Node) + infoSet.size()
+                          + legalActions.size() * (3 * sizeof(double) + sizeof(Action)));
+            }
+            existing = &partition.store(infoSet, localNode);  // Store a copy in the map
         }
+        if (entry && !known) infosetTrie.fill(entry, partition, existing);
+        known = entry ? existing : nullptr;
     }
     
     if (currPlayer == player) {
@@ -744,7 +834,7 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
             
             double originalReachProb = reachProb[player];
             reachProb[player] *= strategy[i];
-            actionUtils[i] = mccfr(&nextState, player, reachProb);
+            actionUtils[i] = mccfr(&nextState, player, reachProb, infosetTrie.child(at, legalActions[i]));
             reachProb[player] = originalReachProb;
             
             nodeUtil += strategy[i] * actionUtils[i];
@@ -758,8 +848,8 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
         
         // Update the global node with our changes
         {
-            std::lock_guard<std::mutex> lock(nodeMapMutex);
-            auto& globalNode = nodeMap[infoSet];
+            auto lock = metricsLock(partition.mutex);
+            auto& globalNode = known ? *known : partition.get(infoSet);
             
             // Update regret sums
             for (size_t i = 0; i < localNode.regretSum.size() && i < globalNode.regretSum.size(); i++) {
@@ -787,8 +877,8 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
         
         // Update the strategy sums and strategyUpdateCount in the global node
         {
-            std::lock_guard<std::mutex> lock(nodeMapMutex);
-            auto& globalNode = nodeMap[infoSet];
+            auto lock = metricsLock(partition.mutex);
+            auto& globalNode = known ? *known : partition.get(infoSet);
             
             // Update strategy sums and strategyUpdateCount
             bool strategyActuallyUpdated = false;
@@ -821,7 +911,7 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
         reachProb[currPlayer] *= strategy[actionIndex];
         
         state->apply_action(legalActions[actionIndex]);
-        double result = mccfr(state, player, reachProb);
+        double result = mccfr(state, player, reachProb, infosetTrie.child(at, legalActions[actionIndex]));
         
         reachProb[currPlayer] = originalReachProb;
         
@@ -830,53 +920,49 @@ double mccfr(SpinGoState* state, int player, std::vector<double>& reachProb) {
     }
 }
 
-void trainMCCFR(SpinGoGame& game, int iterations) {
+// Runs `iterations` MCCFR iterations and returns the summed root utility per player.
+std::vector<double> trainMCCFR(SpinGoGame& game, int iterations) {
     std::cout << "Training progress:\n";
     
     std::vector<double> totalUtility(NUM_PLAYERS, 0.0);
-    std::vector<double> finalResults(NUM_PLAYERS, 0.0);
     
     auto start_time = std::chrono::steady_clock::now();
     
     for (int it = 1; it <= iterations; it++) {
-        double percentage = (static_cast<double>(it) / iterations) * 100;
-        
-        // Calculate remaining iterations and time per iteration
-        auto current_time = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time);
-        double seconds_per_iter = elapsed.count() / static_cast<double>(it);
-        int remaining_iters = iterations - it;
-        int remaining_seconds = static_cast<int>(seconds_per_iter * remaining_iters);
-        
-        // Convert to hours, minutes, seconds
-        int hours = remaining_seconds / 3600;
-        int minutes = (remaining_seconds % 3600) / 60;
-        int seconds = remaining_seconds % 60;
-        
-        std::cout << "\rIteration " << it << " (" << std::fixed << std::setprecision(4) 
-                  << percentage << "% completed, ETA: " << hours << "h " 
-                  << minutes << "m " << seconds << "s)" << std::flush;
+        // Progress every 100 iterations, as in the parallel trainer
+        if (it % 100 == 0 || it == iterations) {
+            double percentage = (static_cast<double>(it) / iterations) * 100;
+            
+            // Calculate remaining iterations and time per iteration
+            auto current_time = std::chrono::steady_clock::now();
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time);
+            double seconds_per_iter = elapsed.count() / static_cast<double>(it);
+            int remaining_iters = iterations - it;
+            int remaining_seconds = static_cast<int>(seconds_per_iter * remaining_iters);
+            
+            // Convert to hours, minutes, seconds
+            int hours = remaining_seconds / 3600;
+            int minutes = (remaining_seconds % 3600) / 60;
+            int seconds = remaining_seconds % 60;
+            
+            std::cout << "\rIteration " << it << " (" << std::fixed << std::setprecision(4) 
+                      << percentage << "% completed, ETA: " << hours << "h " 
+                      << minutes << "m " << seconds << "s)" << std::flush;
+        }
         
+        seedSamplerRng();
         for (int p = 0; p < NUM_PLAYERS; p++) {
             SpinGoState state = game.new_initial_state();  // Create state on stack
+            state.defer_allin_runout = true;
             std::vector<double> reachProb(NUM_PLAYERS, 1.0);
             
-            double value = mccfr(&state, p, reachProb);
+            double value = mccfr(&state, p, reachProb, infosetTrie.root());
             totalUtility[p] += value;
-            finalResults[p] = totalUtility[p] / it;
         }
+        metricAdd(METRIC_ITERATIONS);
     }
 
-    // Save final results
-    std::ofstream resultFile("final_results.txt");
-    if (resultFile.is_open()) {
-        for (int p = 0; p < NUM_PLAYERS; p++) {
-            resultFile << "Player " << p << " final average utility: " << finalResults[p] << "\n";
-        }
-        resultFile.close();
-    } else {
-        std::cerr << "Unable to open file to save results.\n";
-    }
+    return totalUtility;
 }
 
 void printAverageStrategies() {
@@ -891,300 +977,747 @@ void printAverageStrategies() {
     }
 }
 
+// Splits an infoset key into the CSV fields: round, player, abstraction
+// (preflop cards or postflop cluster), the round's previous actions joined by
+// "|" and the pot.
+void parseInfoSetKey(const std::string& infoSet, std::string& round, std::string& player,
+                     std::string& abstraction, std::string& previousActions, std::string& pot) {
+    round.clear();
+    player.clear();
+    abstraction.clear();
+    previousActions.clear();
+    pot.clear();
+    
+    // Extract player
+    size_t playerPos = infoSet.find("P");
+    size_t playerEndPos = infoSet.find(":", playerPos);
+    if (playerPos != std::string::npos && playerEndPos != std::string::npos) {
+        player = infoSet.substr(playerPos + 1, playerEndPos - playerPos - 1);
+    }
+    
+    // Extract round
+    size_t roundPos = infoSet.find("Round:");
+    size_t roundEndPos = infoSet.find(" ", roundPos + 6);
+    if (roundPos != std::string::npos && roundEndPos != std::string::npos) {
+        round = infoSet.substr(roundPos + 6, roundEndPos - roundPos - 6);
+    }
+    
+    // Extract abstraction (preflop cards or cluster)
+    if (round == "preflop") {
+        // For preflop, abstraction is the two cards
+        size_t cardsPos = roundEndPos + 1;
+        size_t cardsEndPos = infoSet.find(" Actions:", cardsPos);
+        if (cardsPos != std::string::npos && cardsEndPos != std::string::npos) {
+            abstraction = infoSet.substr(cardsPos, cardsEndPos - cardsPos);
+            // Clean up any extra spaces
+            abstraction.erase(std::remove(abstraction.begin(), abstraction.end(), ' '), abstraction.end());
+        }
+    } else {
+        // For other rounds, abstraction is the cluster
+        std::string clusterPrefix;
+        if (round == "flop") clusterPrefix = "FlopCluster:";
+        else if (round == "turn") clusterPrefix = "TurnCluster:";
+        else if (round == "river" || round == "showdown") clusterPrefix = "RiverCluster:";
+        
+        size_t clusterPos = infoSet.find(clusterPrefix);
+        if (clusterPos != std::string::npos) {
+            size_t clusterEndPos = infoSet.find(" ", clusterPos + clusterPrefix.length());
+            if (clusterEndPos != std::string::npos) {
+                abstraction = infoSet.substr(clusterPos + clusterPrefix.length(), 
+                                            clusterEndPos - clusterPos - clusterPrefix.length());
+            }
+        }
+    }
+    
+    // Extract previous actions and reformat them to be in chronological order
+    size_t actionsPos = infoSet.find("Actions:");
+    size_t actionsEndPos = infoSet.find(" Pot:", actionsPos);
+    if (actionsPos != std::string::npos && actionsEndPos != std::string::npos) {
+        previousActions = action_history_text(infoSet.substr(actionsPos + 8, actionsEndPos - actionsPos - 8));
+    }
+    
+    // Extract pot
+    size_t potPos = infoSet.find("Pot:");
+    size_t potEndPos = infoSet.find(" CurrentBet:", potPos);
+    if (potPos != std::string::npos && potEndPos != std::string::npos) {
+        pot = infoSet.substr(potPos + 4, potEndPos - potPos - 4);
+    }
+}
+
+// Appends ",ACTION:sum|ACTION:sum" with every digit of sums, in the node's
+// action order.
+static void appendRawSumColumn(const Node& node, const NodeVector<double>& sums, std::string& out) {
+    char value[40];
+    out += ',';
+    for (size_t i = 0; i < sums.size(); ++i) {
+        if (i > 0) out += '|';
+        out += i < node.actions.size() ? action_to_string(node.actions[i]) : "ACTION_" + std::to_string(i);
+        std::snprintf(value, sizeof(value), ":%.17g", sums[i]);
+        out += value;
+    }
+}
+
 // Add this implementation with other functions
+// Appends the CSV row of one infoset. The columns come from the node's
+// fields; only nodes without fields have their key parsed.
+void appendInfoSetRow(const std::string& infoSet, const Node& node, std::string& out) {
+    std::string pot;
+    if (node.fields.valid()) {
+        node.fields.appendLeadingColumns(out);
+    } else {
+        std::string round, player, abstraction, previousActions;
+        parseInfoSetKey(infoSet, round, player, abstraction, previousActions, pot);
+        out += round + "," + player + "," + abstraction + "," + previousActions;
+    }
+    out += ',';
+
+    // Strategy with action labels
+    std::vector<double> avgStrat = node.getAverageStrategy();
+    char prob[32];
+    for (size_t i = 0; i < avgStrat.size(); ++i) {
+        if (i > 0) out += '|';
+        out += i < node.actions.size() ? action_to_string(node.actions[i]) : "ACTION_" + std::to_string(i);
+        std::snprintf(prob, sizeof(prob), ":%.6f", avgStrat[i]);
+        out += prob;
+    }
+    out += ',';
+
+    if (node.fields.valid()) {
+        node.fields.appendPot(out);
+    } else {
+        out += pot;
+    }
+    out += ',';
+    out += std::to_string(node.strategyUpdateCount);
+    if (exportRawSums) {
+        appendRawSumColumn(node, node.strategySum, out);
+        appendRawSumColumn(node, node.regretSum, out);
+    }
+    out += '\n';
+}
+
+// Fills row with the strategy of one infoset, from the node's fields or, for
+// nodes without them, the parsed key. False if the row cannot be encoded.
+bool infoSetStrategyRow(const std::string& infoSet, const Node& node, StrategyRow& row) {
+    if (node.fields.valid()) {
+        row.round = node.fields.round;
+        row.player = node.fields.player;
+        row.abstraction = node.fields.abstractionLabel();
+        row.history.clear();
+        node.fields.appendHistory(row.history);
+        row.potTenths = node.fields.potTenths;
+    } else {
+        std::string round, player, pot;
+        parseInfoSetKey(infoSet, round, player, row.abstraction, row.history, pot);
+        if (!strategyRoundFromName(round, row.round) || !strategyPotFromText(pot, row.potTenths)) return false;
+        row.player = static_cast<uint8_t>(std::atoi(player.c_str()));
+    }
+
+    // Action a is bit a of the mask; the probabilities go in enum order.
+    std::vector<double> avgStrat = node.getAverageStrategy();
+    double byAction[STRATEGY_NUM_ACTIONS] = {0};
+    int slot[STRATEGY_NUM_ACTIONS] = {0};
+    row.actionMask = 0;
+    for (size_t i = 0; i < avgStrat.size(); ++i) {
+        if (i >= node.actions.size()) return false;
+        int a = static_cast<int>(node.actions[i]);
+        if (a < 0 || a >= STRATEGY_NUM_ACTIONS) return false;
+        row.actionMask |= static_cast<uint16_t>(1u << a);
+        byAction[a] = avgStrat[i];
+        slot[a] = static_cast<int>(i);
+    }
+    row.probs.clear();
+    row.strategySums.clear();
+    row.regretSums.clear();
+    row.raw = exportRawSums && node.regretSum.size() == avgStrat.size();
+    for (int a = 0; a < STRATEGY_NUM_ACTIONS; a++) {
+        if (!(row.actionMask >> a & 1)) continue;
+        row.probs.push_back(byAction[a]);
+        if (row.raw) {
+            row.strategySums.push_back(node.strategySum[slot[a]]);
+            row.regretSums.push_back(node.regretSum[slot[a]]);
+        }
+    }
+    row.updateCount = static_cast<uint32_t>(std::max(0, node.strategyUpdateCount));
+    return true;
+}
+
+// Writes the average strategies as a binary strategy file (.sgs).
+void saveInfoSetsToStrategyFile(const std::string& filename) {
+    StrategyFileWriter writer;
+    if (!writer.open(filename, STRATEGY_FILE_BLOCK_ROWS, false, exportRawSums)) {
+        return;
+    }
+    StrategyRow row;
+    size_t skipped = 0;
+    nodeMap.forEachInShard(0, 1, [&](const std::string& infoSet, const Node& node) {
+        if (!infoSetStrategyRow(infoSet, node, row) || !writer.add(row)) skipped++;
+    });
+    if (!writer.close()) {
+        return;
+    }
+    std::cout << "InfoSets saved to " << filename;
+    if (skipped > 0) std::cout << " (" << skipped << " infosets skipped)";
+    std::cout << std::endl;
+}
+
+// Writes the average strategies as CSV, or as a binary strategy file if the
+// name ends in .sgs. For CSV every scheduler thread formats one shard of the
+// table into <filename>.part<i>; the shards are then appended behind the
+// header, in order, and removed.
 void saveInfoSetsToFile(const std::string& filename) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Unable to open file: " << filename << std::endl;
+    if (hasStrategyFileExtension(filename)) {
+        saveInfoSetsToStrategyFile(filename);
         return;
     }
 
-    // Write CSV header with added StrategyUpdateCount column
-    file << "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,StrategyUpdateCount\n";
+    WorkStealingScheduler& scheduler = sharedScheduler();
+    int numShards = scheduler.concurrency();
+    std::vector<std::string> shardFiles(numShards);
+    std::atomic<bool> failed(false);
 
-    for (const auto& entry : nodeMap) {
-        const std::string& infoSet = entry.first;
-        const Node& node = entry.second;
-        std::vector<double> avgStrat = node.getAverageStrategy();
-        std::vector<Action> actions = node.getActions();
-        
-        // Parse the infoSet string to extract the required information
-        std::string round, player, abstraction, pot;
-        
-        // Extract player
-        size_t playerPos = infoSet.find("P");
-        size_t playerEndPos = infoSet.find(":", playerPos);
-        if (playerPos != std::string::npos && playerEndPos != std::string::npos) {
-            player = infoSet.substr(playerPos + 1, playerEndPos - playerPos - 1);
-        }
-        
-        // Extract round
-        size_t roundPos = infoSet.find("Round:");
-        size_t roundEndPos = infoSet.find(" ", roundPos + 6);
-        if (roundPos != std::string::npos && roundEndPos != std::string::npos) {
-            round = infoSet.substr(roundPos + 6, roundEndPos - roundPos - 6);
-        }
-        
-        // Extract abstraction (preflop cards or cluster)
-        if (round == "preflop") {
-            // For preflop, abstraction is the two cards
-            size_t cardsPos = roundEndPos + 1;
-            size_t cardsEndPos = infoSet.find(" Actions:", cardsPos);
-            if (cardsPos != std::string::npos && cardsEndPos != std::string::npos) {
-                abstraction = infoSet.substr(cardsPos, cardsEndPos - cardsPos);
-                // Clean up any extra spaces
-                abstraction.erase(std::remove(abstraction.begin(), abstraction.end(), ' '), abstraction.end());
+    scheduler.parallelFor(0, numShards, 1, [&](long begin, long end) {
+        for (long s = begin; s < end; s++) {
+            shardFiles[s] = filename + ".part" + std::to_string(s);
+            std::ofstream shard(shardFiles[s], std::ios::binary | std::ios::trunc);
+            if (!shard.is_open()) {
+                failed = true;
+                continue;
             }
-        } else {
-            // For other rounds, abstraction is the cluster
-            std::string clusterPrefix;
-            if (round == "flop") clusterPrefix = "FlopCluster:";
-            else if (round == "turn") clusterPrefix = "TurnCluster:";
-            else if (round == "river" || round == "showdown") clusterPrefix = "RiverCluster:";
-            
-            size_t clusterPos = infoSet.find(clusterPrefix);
-            if (clusterPos != std::string::npos) {
-                size_t clusterEndPos = infoSet.find(" ", clusterPos + clusterPrefix.length());
-                if (clusterEndPos != std::string::npos) {
-                    abstraction = infoSet.substr(clusterPos + clusterPrefix.length(), 
-                                                clusterEndPos - clusterPos - clusterPrefix.length());
+            std::string buffer;
+            nodeMap.forEachInShard(static_cast<int>(s), numShards, [&](const std::string& infoSet, const Node& node) {
+                appendInfoSetRow(infoSet, node, buffer);
+                if (buffer.size() >= (1 << 20)) {
+                    shard.write(buffer.data(), buffer.size());
+                    buffer.clear();
                 }
-            }
+            });
+            shard.write(buffer.data(), buffer.size());
+            shard.close();
+            if (!shard) failed = true;
         }
-        
-        // Extract previous actions and reformat them to be in chronological order
-        std::string previousActions;
-        size_t actionsPos = infoSet.find("Actions:");
-        size_t actionsEndPos = infoSet.find(" Pot:", actionsPos);
-        if (actionsPos != std::string::npos && actionsEndPos != std::string::npos) {
-            std::string rawActions = infoSet.substr(actionsPos + 8, actionsEndPos - actionsPos - 8);
-            
-            // Parse the actions to extract them in order
-            std::vector<std::string> actionsList;
-            size_t pos = 0;
-            while (pos < rawActions.length()) {
-                size_t startPos = rawActions.find("[", pos);
-                if (startPos == std::string::npos) break;
-                
-                size_t endPos = rawActions.find("]", startPos);
-                if (endPos == std::string::npos) break;
-                
-                std::string action = rawActions.substr(startPos + 1, endPos - startPos - 1);
-                actionsList.push_back(action);
-                pos = endPos + 1;
-            }
-            
-            // Format actions in chronological order
-            for (size_t i = 0; i < actionsList.size(); ++i) {
-                previousActions += actionsList[i];
-                if (i < actionsList.size() - 1) {
-                    previousActions += "|";
-                }
-            }
+    });
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || failed) {
+        std::cerr << "Unable to write file: " << filename << std::endl;
+        for (const auto& shardFile : shardFiles) std::remove(shardFile.c_str());
+        return;
+    }
+
+    // Write CSV header with added StrategyUpdateCount column
+    file << "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,StrategyUpdateCount"
+         << (exportRawSums ? STRATEGY_CSV_RAW_COLUMNS : "") << "\n";
+    for (const auto& shardFile : shardFiles) {
+        std::ifstream shard(shardFile, std::ios::binary);
+        if (shard.peek() != std::ifstream::traits_type::eof()) file << shard.rdbuf();
+        shard.close();
+        std::remove(shardFile.c_str());
+    }
+
+    file.close();
+    std::cout << "InfoSets saved to " << filename << std::endl;
+}
+
+// Aggregates strategy CSVs or .sgs files into outputFile (.sgs output if the
+// name ends in .sgs) with the bounded-memory external merge of
+// spingo/strategy_merge.cpp, sorting at most memoryMB of rows at a time and
+// writing outputShards files.
+bool aggregateStrategies(const std::vector<std::string>& inputFiles, const std::string& outputFile, size_t memoryMB = 512,
+                         int outputShards = 1) {
+    StrategyMergeOptions options;
+    options.memoryBytes = memoryMB << 20;
+    options.outputShards = outputShards;
+    return mergeStrategyFiles(inputFiles, outputFile, options);
+}
+
+// Vector-form CFR over the public tree: every iteration samples one board and
+// updates all hand buckets of every public node at once.
+void trainVectorCFR(int iterations, const std::string& outputFilename) {
+    std::cout << "Training progress (vector CFR):\n";
+
+    PublicTreeCFR solver(postflopBucket);
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (int it = 1; it <= iterations; it++) {
+        solver.iterate();
+
+        if (it % 100 == 0 || it == iterations) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start_time);
+            double seconds_per_iter = elapsed.count() / static_cast<double>(it);
+            int remaining_seconds = static_cast<int>(seconds_per_iter * (iterations - it));
+            std::cout << "\rIteration " << it << " (" << std::fixed << std::setprecision(4)
+                      << (static_cast<double>(it) / iterations) * 100 << "% completed, ETA: "
+                      << remaining_seconds / 3600 << "h " << (remaining_seconds % 3600) / 60 << "m "
+                      << remaining_seconds % 60 << "s, public nodes: " << solver.numPublicNodes() << ")" << std::flush;
         }
-        
-        // Extract pot
-        size_t potPos = infoSet.find("Pot:");
-        size_t potEndPos = infoSet.find(" CurrentBet:", potPos);
-        if (potPos != std::string::npos && potEndPos != std::string::npos) {
-            pot = infoSet.substr(potPos + 4, potEndPos - potPos - 4);
+    }
+    std::cout << std::endl;
+
+    std::vector<double> finalResults = solver.averageValues();
+    std::ofstream resultFile("final_results.txt");
+    if (resultFile.is_open()) {
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            resultFile << "Player " << p << " final average utility: " << finalResults[p] << "\n";
         }
-        
-        // Format strategy as a string with action labels
-        std::stringstream strategyStr;
-        for (size_t i = 0; i < avgStrat.size(); ++i) {
-            // Use the stored action if available, otherwise use a default label
-            std::string actionLabel;
-            if (i < actions.size()) {
-                actionLabel = action_to_string(actions[i]);
-            } else {
-                actionLabel = "ACTION_" + std::to_string(i);
-            }
-            
-            strategyStr << actionLabel << ":" << std::fixed << std::setprecision(6) << avgStrat[i];
-            
-            if (i < avgStrat.size() - 1) {
-                strategyStr << "|";
+        resultFile.close();
+    } else {
+        std::cerr << "Unable to open file to save results.\n";
+    }
+
+    solver.writeCSV(outputFilename);
+}
+
+// Add this forward declaration before main()
+// onCheckpoint(completed, totalUtility) is called when firstIteration +
+// completed reaches a multiple of checkpointEvery, once the iterations still
+// running have finished and while no new ones start. completed then counts
+// every iteration whose updates are in the table, and no others.
+std::vector<double> trainMCCFRParallel(SpinGoGame& game, int iterations, int checkpointEvery = 0,
+                                       const std::function<void(int, const std::vector<double>&)>& onCheckpoint = nullptr,
+                                       int firstIteration = 0);
+
+// Hash of everything a checkpoint's infosets depend on: the game constants, the
+// key layout and the loaded cluster abstraction (order-independent over the
+// cache).
+uint64_t computeConfigHash() {
+    if (!clustersLoaded) {
+        preloadClusters();
+    }
+    uint64_t clusterHash = 0;
+    for (const auto& round : clusterCache) {
+        for (const auto& entry : round.second) {
+            clusterHash += fnv1a64(round.first + '\0' + entry.first + '\0' + entry.second);
+        }
+    }
+    std::string config = "players=" + std::to_string(NUM_PLAYERS) + ";stack=" + std::to_string(INITIAL_STACK)
+                       + ";clusters=" + std::to_string(clusterHash) + ";actions=packed";
+    return fnv1a64(config);
+}
+
+// Average strategies of the current nodeMap, keyed like the CSV rows.
+StrategyProfile profileFromNodeMap() {
+    StrategyProfile profile;
+    auto locks = nodeMap.lockAll();
+    for (const auto& entry : nodeMap) {
+        std::string round, player, abstraction, previousActions, pot;
+        parseInfoSetKey(entry.first, round, player, abstraction, previousActions, pot);
+        std::vector<double> avgStrat = entry.second.getAverageStrategy();
+        std::map<std::string, double> actionProbs;
+        for (size_t i = 0; i < avgStrat.size() && i < entry.second.actions.size(); i++) {
+            actionProbs[action_to_string(entry.second.actions[i])] = avgStrat[i];
+        }
+        profile.add(StrategyProfile::key(round, player, abstraction, previousActions, pot),
+                    actionProbs, entry.second.strategyUpdateCount);
+    }
+    return profile;
+}
+
+// Cold-tier counters of nodeMap, for the metrics reporter.
+MetricsReporter::Gauges nodeTableGauges() {
+    NodeTableStats stats = nodeMap.stats();
+    return {{"table_hot_hits", double(stats.hotHits)},       {"table_cold_hits", double(stats.coldHits)},
+            {"table_misses", double(stats.misses)},          {"table_evictions", double(stats.evictions)},
+            {"table_hit_rate", stats.hitRate()},             {"table_hot_entries", double(stats.hotEntries)},
+            {"table_cold_entries", double(stats.coldEntries)}, {"table_hot_bytes", double(stats.hotBytes)},
+            {"table_cold_bytes", double(stats.coldBytes)}};
+}
+
+// Number of buckets of a postflop round ("flop", "turn", "river"): one more
+// than the highest cluster loaded for it, at least 1.
+int clusterBucketCount(const std::string& round) {
+    if (!clustersLoaded) {
+        preloadClusters();
+    }
+    int count = 1;
+    auto it = clusterCache.find(round);
+    if (it != clusterCache.end()) {
+        for (const auto& entry : it->second) count = std::max(count, std::atoi(entry.second.c_str()) + 1);
+    }
+    return count;
+}
+
+// Buckets of each round: the preflop classes and the postflop clusters.
+std::array<int, 4> roundBucketCounts() {
+    return {{NUM_PREFLOP_CLASSES, clusterBucketCount("flop"), clusterBucketCount("turn"), clusterBucketCount("river")}};
+}
+
+void printInfosetTrieStats() {
+    auto stats = infosetTrie.stats();
+    std::cout << "Infoset trie: " << stats.publicNodes << " public nodes, " << stats.filledEntries
+              << " infoset entries, " << std::fixed << std::setprecision(1) << stats.bytes / (1024.0 * 1024.0)
+              << " MB" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+void printInfosetIndexStats() {
+    NodeTableStats stats = nodeMap.stats();
+    std::cout << "Infoset index: " << stats.indexedEntries << " of " << stats.indexSlots << " preallocated slots used, "
+              << stats.overflowEntries << " infosets outside the index in the overflow table" << std::endl;
+}
+
+// Writes the perfect-hash index of the infosets, with their action counts,
+// for --infoset-index. With samples > 0 they are those reached by playing
+// that many hands the way generateScenarios does (chance nodes dealt, a
+// uniformly random legal action at every decision); with 0, every infoset
+// of the public tree (InfosetEnumerator).
+bool buildInfosetIndex(int samples, const std::string& filename) {
+    SpinGoGame game;
+    std::mt19937 rng(std::random_device{}());
+    std::unordered_map<std::string, uint8_t> reached;
+    uint64_t decisions = 0;
+    if (samples <= 0) {
+        InfosetEnumerator enumerator(roundBucketCounts(), [&](const SpinGoState& state, int bucket) {
+            reached.emplace(getInformationSet(&state, bucket), static_cast<uint8_t>(state.legal_actions().size()));
+            decisions++;
+        });
+        enumerator.run().print(std::cout);
+    }
+    for (int sample = 0; sample < samples; sample++) {
+        SpinGoState state = game.new_initial_state();
+        state.defer_allin_runout = true;
+        while (!state.game_over) {
+            if (state.is_chance_node()) {
+                state.apply_action(Action::DEAL);
+                continue;
             }
+            std::vector<Action> legalActions = state.legal_actions();
+            if (legalActions.empty()) break;
+            reached.emplace(getInformationSet(&state), static_cast<uint8_t>(legalActions.size()));
+            decisions++;
+            std::uniform_int_distribution<size_t> pick(0, legalActions.size() - 1);
+            state.apply_action(legalActions[pick(rng)]);
         }
-        
-        // Write the CSV row with strategy update count
-        file << round << "," 
-             << player << "," 
-             << abstraction << "," 
-             << previousActions << "," 
-             << strategyStr.str() << "," 
-             << pot << "," 
-             << node.strategyUpdateCount << "\n";  // Add strategy update count to output
+        if ((sample + 1) % 10000 == 0 || sample + 1 == samples) {
+            std::cout << "\rScenarios: " << sample + 1 << "/" << samples << " | Unique infosets: " << reached.size()
+                      << std::flush;
+        }
+        if (sample + 1 == samples) std::cout << std::endl;
     }
 
-    file.close();
-    std::cout << "InfoSets saved to " << filename << std::endl;
+    std::vector<std::pair<std::string, uint8_t>> keys(reached.begin(), reached.end());
+    reached.clear();
+    InfosetIndex index;
+    if (!index.build(keys, computeConfigHash()) || !index.save(filename)) {
+        return false;
+    }
+    std::cout << "Indexed " << index.size() << " infosets from " << decisions << " decisions in " << index.slots()
+              << " slots, written to " << filename << std::endl;
+    return true;
 }
 
-// Add a simple utility to aggregate strategies from multiple files
-void aggregateStrategies(const std::vector<std::string>& inputFiles, const std::string& outputFile) {
-    // Structure to hold aggregated strategy data
-    struct StrategyEntry {
-        std::string round;
-        std::string player;
-        std::string abstraction;
-        std::string previousActions;
-        std::string pot;
-        std::map<std::string, double> actionProbs;  // Action -> probability
-        int totalStrategyUpdates; // Changed from totalVisits
-    };
-    
-    // Map from infoset key to aggregated strategy
-    std::map<std::string, StrategyEntry> aggregatedStrategies;
-    
-    // Process each input file
-    for (const auto& filename : inputFiles) {
-        std::cout << "Processing file: " << filename << std::endl;
-        std::ifstream file(filename);
-        
-        if (!file.is_open()) {
-            std::cerr << "Unable to open file: " << filename << std::endl;
-            continue;
+void printNodeTableStats() {
+    NodeTableStats stats = nodeMap.stats();
+    std::cout << "Infoset store: " << stats.hotEntries << " in RAM (" << std::fixed << std::setprecision(1)
+              << stats.hotBytes / (1024.0 * 1024.0) << " MB), " << stats.coldEntries << " on disk ("
+              << stats.coldBytes / (1024.0 * 1024.0) << " MB), hit rate " << std::setprecision(2)
+              << 100.0 * stats.hitRate() << "%, " << stats.coldHits << " page-ins, " << stats.evictions
+              << " evictions, " << stats.compactions << " compactions" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+// Loads the --warm-start prior from a strategy CSV, or from a checkpoint or
+// snapshot written under any abstraction/config.
+bool loadWarmStart(const std::string& filename) {
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {0};
+    uint32_t version = 0;
+    uint64_t configHash = 0;
+    std::ifstream probe(filename, std::ios::binary);
+    probe.read(magic, sizeof(magic));
+    if (probe && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0) {
+        readPod(probe, version);
+        readPod(probe, configHash);
+        std::unordered_map<std::string, Node> prior;
+        CheckpointInfo info;
+        if (!loadCheckpoint(filename, prior, info, configHash)) {
+            return false;
         }
-        
-        std::string line;
-        // Skip header
-        std::getline(file, line);
-        
-        // Process each line
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string round, player, abstraction, previousActions, strategyStr, pot, strategyUpdateCountStr; // Renamed from visitCountStr
-            
-            std::getline(ss, round, ',');
-            std::getline(ss, player, ',');
-            std::getline(ss, abstraction, ',');
-            std::getline(ss, previousActions, ',');
-            std::getline(ss, strategyStr, ',');
-            std::getline(ss, pot, ',');
-            std::getline(ss, strategyUpdateCountStr, ','); // Read the new column
-            
-            int strategyUpdates = std::stoi(strategyUpdateCountStr); // Renamed from visitCount
-            
-            // Create a key for this infoset
-            std::string key = round + "|" + player + "|" + abstraction + "|" + previousActions + "|" + pot;
-            
-            // Parse strategy string
+        for (const auto& entry : prior) {
+            std::string round, player, abstraction, previousActions, pot;
+            parseInfoSetKey(entry.first, round, player, abstraction, previousActions, pot);
+            std::vector<double> avgStrat = entry.second.getAverageStrategy();
             std::map<std::string, double> actionProbs;
-            std::stringstream stratSS(strategyStr);
-            std::string actionProb;
-            
-            while (std::getline(stratSS, actionProb, '|')) {
-                size_t colonPos = actionProb.find(':');
-                if (colonPos != std::string::npos) {
-                    std::string action = actionProb.substr(0, colonPos);
-                    double prob = std::stod(actionProb.substr(colonPos + 1));
-                    actionProbs[action] = prob;
-                }
-            }
-            
-            // If this is the first time seeing this infoset, initialize it
-            if (aggregatedStrategies.find(key) == aggregatedStrategies.end()) {
-                StrategyEntry entry;
-                entry.round = round;
-                entry.player = player;
-                entry.abstraction = abstraction;
-                entry.previousActions = previousActions;
-                entry.pot = pot;
-                entry.actionProbs = actionProbs;
-                entry.totalStrategyUpdates = strategyUpdates; // Changed from totalVisits
-                aggregatedStrategies[key] = entry;
-            } else {
-                // We've seen this infoset before, update with weighted average
-                auto& entry = aggregatedStrategies[key];
-                
-                // For each action in the current strategy
-                for (const auto& [action, prob] : actionProbs) {
-                    // If we haven't seen this action before, initialize it
-                    if (entry.actionProbs.find(action) == entry.actionProbs.end()) {
-                        entry.actionProbs[action] = 0.0;
-                    }
-                    
-                    // Update with weighted average
-                    double oldWeight = static_cast<double>(entry.totalStrategyUpdates); // Changed from totalVisits
-                    double newWeight = static_cast<double>(strategyUpdates); // Changed from visitCount
-                    double totalWeight = oldWeight + newWeight;
-                    
-                    if (totalWeight > 0) { // Avoid division by zero if both weights are zero (though unlikely here)
-                        entry.actionProbs[action] = (entry.actionProbs[action] * oldWeight + prob * newWeight) / totalWeight;
-                    } else if (newWeight > 0) { // If oldWeight was 0, just take the new probability
-                        entry.actionProbs[action] = prob;
-                    }
-                    // If both oldWeight and newWeight are 0, actionProbs[action] remains unchanged (e.g., 0.0)
-                }
-                
-                // Update total strategy updates
-                entry.totalStrategyUpdates += strategyUpdates; // Changed from totalVisits
+            for (size_t i = 0; i < avgStrat.size() && i < entry.second.actions.size(); i++) {
+                actionProbs[action_to_string(entry.second.actions[i])] = avgStrat[i];
             }
+            warmStart.add(entry.first, round, player, abstraction, previousActions, pot, actionProbs,
+                          entry.second.strategyUpdateCount);
         }
-        
-        file.close();
+        std::cout << "Warm start from checkpoint at iteration " << info.iteration;
+        if (configHash != computeConfigHash()) std::cout << " (different abstraction/config)";
+        std::cout << ": " << warmStart.size() << " prior infosets" << std::endl;
+        return true;
     }
-    
-    // Write aggregated strategies to output file
-    std::ofstream outFile(outputFile);
-    if (!outFile.is_open()) {
-        std::cerr << "Unable to open output file: " << outputFile << std::endl;
-        return;
+    if (!warmStart.loadCSV(filename)) {
+        return false;
     }
-    
-    // Write CSV header
-    outFile << "Round,Player,Abstraction,PreviousActions,Strategy,CumulatedPot,StrategyUpdateCount\n"; // Changed VisitCount
-    
-    // Write each aggregated strategy
-    for (const auto& [key, entry] : aggregatedStrategies) {
-        // Format strategy string
-        std::stringstream strategyStr;
-        bool first = true;
-        for (const auto& [action, prob] : entry.actionProbs) {
-            if (!first) strategyStr << "|";
-            strategyStr << action << ":" << std::fixed << std::setprecision(6) << prob;
-            first = false;
+    std::cout << "Warm start from " << filename << ": " << warmStart.size() << " prior infosets" << std::endl;
+    return true;
+}
+
+// Loads a strategy CSV or binary checkpoint as a StrategyProfile.
+bool loadStrategyProfile(const std::string& filename, StrategyProfile& profile) {
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {0};
+    std::ifstream probe(filename, std::ios::binary);
+    probe.read(magic, sizeof(magic));
+    if (probe && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0) {
+        CheckpointInfo info;
+        if (!loadCheckpoint(filename, nodeMap, info, computeConfigHash())) {
+            return false;
         }
-        
-        // Write CSV row
-        outFile << entry.round << "," 
-                << entry.player << "," 
-                << entry.abstraction << "," 
-                << entry.previousActions << "," 
-                << strategyStr.str() << "," 
-                << entry.pot << "," 
-                << entry.totalStrategyUpdates << "\n"; // Changed from totalVisits
-    }
-    
-    outFile.close();
-    std::cout << "Aggregated " << aggregatedStrategies.size() << " strategies to " << outputFile << std::endl;
+        std::cout << "Loaded checkpoint at iteration " << info.iteration << " with " << nodeMap.size() << " infosets." << std::endl;
+        profile = profileFromNodeMap();
+    } else if (!profile.loadCSV(filename)) {
+        return false;
+    }
+    return true;
 }
 
-// Add this forward declaration before main()
-void trainMCCFRParallel(SpinGoGame& game, int iterations);
+// Best-response evaluation of a strategy CSV or binary checkpoint.
+bool evaluateStrategyFile(const std::string& filename, const BestResponseConfig& config) {
+    StrategyProfile profile;
+    if (!loadStrategyProfile(filename, profile)) {
+        return false;
+    }
+
+    std::cout << "Evaluating " << profile.size() << " strategy infosets: best response fitted on "
+              << config.fitBoards << " boards, evaluated on " << config.evalBoards << " boards" << std::endl;
+    BestResponseEvaluator evaluator(profile, postflopBucket, config);
+    printBestResponse(evaluator.run());
+    return true;
+}
+
+// Re-solves one turn or river decision against a blueprint (--solve).
+bool solveSubgameDecision(const std::string& blueprintFile, const std::string& board, const std::string& actions,
+                          const std::string& hand, const SubgameOptions& options) {
+    SubgameSpec spec;
+    std::vector<int> heroCards;
+    if (!parseCards(board, spec.board)) {
+        std::cerr << "Cannot parse board: " << board << std::endl;
+        return false;
+    }
+    if (!parseActionHistory(actions, spec.history)) {
+        std::cerr << "Cannot parse actions: " << actions << " (expected e.g. P2:CALL|P0:CALL|P1:CHECK)" << std::endl;
+        return false;
+    }
+    if (!hand.empty()) {
+        if (!parseCards(hand, heroCards) || heroCards.size() != 2) {
+            std::cerr << "Cannot parse hand: " << hand << std::endl;
+            return false;
+        }
+        spec.heroCards[0] = heroCards[0];
+        spec.heroCards[1] = heroCards[1];
+    }
+
+    StrategyProfile blueprint;
+    if (!loadStrategyProfile(blueprintFile, blueprint)) {
+        return false;
+    }
+    SubgameSolver solver(blueprint, postflopBucket);
+    std::string error;
+    if (!solver.setup(spec, error)) {
+        std::cerr << "Cannot re-solve: " << error << std::endl;
+        return false;
+    }
+    printSubgameResult(solver.solve(options));
+    return true;
+}
+
+void saveFinalResults(const std::vector<double>& totalUtility, int iterations) {
+    std::ofstream resultFile("final_results.txt");
+    if (resultFile.is_open()) {
+        for (int p = 0; p < NUM_PLAYERS; p++) {
+            resultFile << "Player " << p << " final average utility: " << totalUtility[p] / iterations << "\n";
+        }
+        resultFile.close();
+    } else {
+        std::cerr << "Unable to open file to save results.\n";
+    }
+}
+
+// Runs training up to `iterations` total iterations. With checkpointEvery > 0
+// the full state is snapshotted to checkpointFile every checkpointEvery
+// iterations by a forked child (see spingo/snapshot.cpp). The parallel workers
+// are held only while the iterations in flight finish and for the fork, so
+// every checkpoint holds whole iterations; onSnapshot runs after each
+// snapshot is written. With resume the run continues from checkpointFile.
+// With evalEvery > 0 training pauses every evalEvery iterations to call
+// onEvaluate(iteration), and stops early when it returns true.
+bool trainWithCheckpoints(SpinGoGame& game, int iterations, bool useParallel,
+                          int checkpointEvery, const std::string& checkpointFile, bool resume,
+                          std::function<void(const std::string&)> onSnapshot = nullptr,
+                          int evalEvery = 0, std::function<bool(int)> onEvaluate = nullptr) {
+    CheckpointInfo info;
+    info.configHash = computeConfigHash();
+    info.totalUtility.assign(NUM_PLAYERS, 0.0);
 
+    if (resume) {
+        if (!std::ifstream(checkpointFile).good()) {
+            std::cout << "No checkpoint at " << checkpointFile << ", starting from scratch." << std::endl;
+        } else if (loadCheckpoint(checkpointFile, nodeMap, info, info.configHash)) {
+            restoreSamplerRng(info.rngState);
+            std::cout << "Resumed from " << checkpointFile << " at iteration " << info.iteration
+                      << " with " << nodeMap.size() << " infosets." << std::endl;
+        } else {
+            return false;
+        }
+    }
+
+    // The child process serializes its copy of snapshotInfo and nodeMap as
+    // they were at the fork
+    CheckpointInfo snapshotInfo = info;
+    BackgroundSnapshotter snapshotter([&snapshotInfo](const std::string& file) {
+        return saveCheckpoint(file, nodeMap, snapshotInfo);
+    }, onSnapshot);
+    auto takeSnapshot = [&](int iteration, const std::vector<double>& totalUtility) {
+        snapshotInfo.iteration = iteration;
+        snapshotInfo.totalUtility = totalUtility;
+        snapshotInfo.rngState = samplerRngState();
+        if (!snapshotter.snapshot(checkpointFile, nodeMap.mutexes())) {
+            std::cout << "\nSkipping checkpoint at iteration " << iteration << ": previous one still in progress" << std::endl;
+        }
+    };
+
+    // Training runs in segments that end at every evaluation and, when
+    // sequential, at every checkpoint
+    if (!onEvaluate) evalEvery = 0;
+    auto segmentEnd = [&](int from) {
+        int end = iterations;
+        if (evalEvery > 0) end = std::min(end, (from / evalEvery + 1) * evalEvery);
+        if (!useParallel && checkpointEvery > 0) end = std::min(end, (from / checkpointEvery + 1) * checkpointEvery);
+        return end;
+    };
+
+    int done = static_cast<int>(info.iteration);
+    bool stopped = false;
+    while (done < iterations && !stopped) {
+        int end = segmentEnd(done);
+        if (useParallel) {
+            // One pool per segment; checkpoints are taken while it is paused.
+            // Offsetting by base keeps them near multiples of checkpointEvery
+            // across segments.
+            std::vector<double> baseUtility = info.totalUtility;
+            int base = done;
+            std::vector<double> runUtility = trainMCCFRParallel(game, end - done, checkpointEvery,
+                [&](int completed, const std::vector<double>& utility) {
+                    std::vector<double> total = baseUtility;
+                    for (int p = 0; p < NUM_PLAYERS; p++) total[p] += utility[p];
+                    takeSnapshot(base + completed, total);
+                }, base);
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                info.totalUtility[p] += runUtility[p];
+            }
+        } else {
+            std::vector<double> segmentUtility = trainMCCFR(game, end - done);
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                info.totalUtility[p] += segmentUtility[p];
+            }
+        }
+        done = end;
+
+        if (evalEvery > 0 && done % evalEvery == 0) {
+            stopped = onEvaluate(done);
+        }
+        if (checkpointEvery > 0 && done % checkpointEvery == 0 && done < iterations && !stopped) {
+            takeSnapshot(done, info.totalUtility);
+        }
+    }
+
+    // The final checkpoint is written in the foreground so it is complete on exit
+    snapshotter.wait();
+    if (checkpointEvery > 0) {
+        info.iteration = done;
+        info.rngState = samplerRngState();
+        auto saveStart = std::chrono::steady_clock::now();
+        if (saveCheckpoint(checkpointFile, nodeMap, info)) {
+            auto saveMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - saveStart).count();
+            std::cout << "Checkpoint at iteration " << done << " written to " << checkpointFile
+                      << " (" << nodeMap.size() << " infosets, " << saveMs << " ms)" << std::endl;
+            if (onSnapshot) onSnapshot(checkpointFile);
+        }
+    }
+
+    if (done > 0) {
+        saveFinalResults(info.totalUtility, done);
+    }
+    return true;
+}
+
+// train_mpi.cpp reuses everything but main()
+#ifndef SPINGO_TRAINER_NO_MAIN
 // Then the main function can call it
 int main(int argc, char* argv[]) {
     // Check if we're in aggregation mode
     if (argc > 1 && std::string(argv[1]) == "--aggregate") {
         if (argc < 4) {
-            std::cerr << "Usage for aggregation: " << argv[0] << " --aggregate output.csv input1.csv input2.csv [input3.csv ...]" << std::endl;
+            std::cerr << "Usage for aggregation: " << argv[0] << " --aggregate output.csv|output.sgs input1 input2 [input3 ...] [--memory-mb N] [--shards N] (inputs: strategy CSVs or .sgs files)" << std::endl;
             return 1;
         }
         
         std::string outputFile = argv[2];
         std::vector<std::string> inputFiles;
+        size_t memoryMB = 512;
+        int outputShards = 1;
         
         for (int i = 3; i < argc; i++) {
+            if (std::string(argv[i]) == "--memory-mb" && i + 1 < argc) {
+                memoryMB = std::stoul(argv[++i]);
+                continue;
+            }
+            if (std::string(argv[i]) == "--shards" && i + 1 < argc) {
+                outputShards = std::stoi(argv[++i]);
+                continue;
+            }
             inputFiles.push_back(argv[i]);
         }
         
-        aggregateStrategies(inputFiles, outputFile);
+        return aggregateStrategies(inputFiles, outputFile, memoryMB, outputShards) ? 0 : 1;
+    }
+    
+    // Perfect-hash index of the infosets reached by random play, or of all
+    if (argc > 1 && std::string(argv[1]) == "--build-index") {
+        if (argc < 4) {
+            std::cerr << "Usage for indexing: " << argv[0] << " --build-index samples|all index.sgi" << std::endl;
+            return 1;
+        }
+        preloadClusters();
+        return buildInfosetIndex(std::string(argv[2]) == "all" ? 0 : std::stoi(argv[2]), argv[3]) ? 0 : 1;
+    }
+    
+    // Exact infoset counts per round and seat, from the public tree
+    if (argc > 1 && std::string(argv[1]) == "--count-infosets") {
+        preloadClusters();
+        InfosetEnumerator(roundBucketCounts()).run().print(std::cout);
         return 0;
     }
     
+    // Best-response evaluation of a saved strategy
+    if (argc > 1 && std::string(argv[1]) == "--best-response") {
+        if (argc < 3) {
+            std::cerr << "Usage for evaluation: " << argv[0] << " --best-response strategy.csv|checkpoint [fit_boards] [eval_boards]" << std::endl;
+            return 1;
+        }
+        BestResponseConfig config;
+        if (argc > 3) config.fitBoards = std::stoi(argv[3]);
+        if (argc > 4) config.evalBoards = std::stoi(argv[4]);
+        preloadClusters();
+        return evaluateStrategyFile(argv[2], config) ? 0 : 1;
+    }
+    
+    // Real-time re-solving of one turn or river decision
+    if (argc > 1 && std::string(argv[1]) == "--solve") {
+        if (argc < 5) {
+            std::cerr << "Usage for re-solving: " << argv[0] << " --solve blueprint.csv|checkpoint \"board\" \"actions\" [hand] [budget_ms] [river_samples]" << std::endl;
+            std::cerr << "  e.g. --solve strategies.csv \"Ah Kd 7c 2s\" \"P2:CALL|P0:CALL|P1:CHECK|P0:CHECK|P1:CHECK|P2:CHECK\" QhQs" << std::endl;
+            return 1;
+        }
+        SubgameOptions options;
+        if (argc > 6) options.budgetMs = std::stod(argv[6]);
+        if (argc > 7) options.riverSamples = std::stoi(argv[7]);
+        preloadClusters();
+        return solveSubgameDecision(argv[2], argv[3], argv[4], argc > 5 ? argv[5] : "", options) ? 0 : 1;
+    }
+    
     // Original training code
     SpinGoGame game;
     
@@ -1195,6 +1728,24 @@ int main(int argc, char* argv[]) {
     int iterations = 10000;  // Default value
     std::string outputFilename = "spingo_strategies_optimized.csv";  // Default output filename
     bool useParallel = true;  // Default to parallel mode
+    bool useVector = false;   // Vector-form public-tree CFR instead of MCCFR
+    
+    int evalEvery = 0;  // 0 = no exploitability evaluation during training
+    int evalPatience = 0;  // 0 = never stop early
+    BestResponseConfig evalConfig;
+    std::string metricsFile;  // Empty = no metrics reporter
+    std::string metricsFormat = "json";
+    double metricsInterval = 10.0;
+    int checkpointEvery = 0;  // 0 = no checkpoints
+    std::string checkpointFile;  // Defaults to <output>.ckpt
+    bool resume = false;
+    bool useTrie = true;
+    std::string indexFile;  // Empty = every infoset goes through the hash maps
+    int tablePartitions = 0;  // 0 = 1, or 16 per NUMA node with a NUMA layout
+    long ramBudgetMB = 0;  // 0 = keep every infoset in RAM
+    std::string coldStorePath;  // Defaults to <output>.cold
+    NumaLayout numaLayout = NUMA_LAYOUT_NONE;
+    std::string warmStartFile;  // Empty = start from uniform
     
     // Parse command line arguments as positional arguments
     if (argc >= 2) {
@@ -1209,23 +1760,179 @@ int main(int argc, char* argv[]) {
         outputFilename = argv[2];
     }
     
-    // Check for optional --sequential flag in any position
+    // Check for optional flags in any position
     for (int i = 1; i < argc; i++) {
         if (std::string(argv[i]) == "--sequential") {
             useParallel = false;
-            break;
+        } else if (std::string(argv[i]) == "--vector") {
+            useVector = true;
+        } else if (std::string(argv[i]) == "--checkpoint-every" && i + 1 < argc) {
+            checkpointEvery = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--checkpoint-file" && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        } else if (std::string(argv[i]) == "--resume") {
+            resume = true;
+        } else if (std::string(argv[i]) == "--pin-threads") {
+            pinWorkerThreads = true;
+        } else if (std::string(argv[i]) == "--no-trie") {
+            useTrie = false;
+        } else if (std::string(argv[i]) == "--infoset-index" && i + 1 < argc) {
+            indexFile = argv[++i];
+        } else if (std::string(argv[i]) == "--raw-sums") {
+            exportRawSums = true;
+        } else if (std::string(argv[i]) == "--ram-budget" && i + 1 < argc) {
+            ramBudgetMB = std::stol(argv[++i]);
+        } else if (std::string(argv[i]) == "--cold-store" && i + 1 < argc) {
+            coldStorePath = argv[++i];
+        } else if (std::string(argv[i]) == "--partitions" && i + 1 < argc) {
+            tablePartitions = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--numa" && i + 1 < argc) {
+            if (!parseNumaLayout(argv[++i], numaLayout)) {
+                std::cerr << "Unknown NUMA layout " << argv[i] << " (none, interleave or partitioned)" << std::endl;
+                return 1;
+            }
+        } else if (std::string(argv[i]) == "--eval-every" && i + 1 < argc) {
+            evalEvery = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--eval-patience" && i + 1 < argc) {
+            evalPatience = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--eval-boards" && i + 1 < argc) {
+            evalConfig.evalBoards = std::stoi(argv[++i]);
+            evalConfig.fitBoards = std::max(8, evalConfig.evalBoards / 4);
+        } else if (std::string(argv[i]) == "--metrics" && i + 1 < argc) {
+            metricsFile = argv[++i];
+        } else if (std::string(argv[i]) == "--metrics-format" && i + 1 < argc) {
+            metricsFormat = argv[++i];
+        } else if (std::string(argv[i]) == "--metrics-interval" && i + 1 < argc) {
+            metricsInterval = std::stod(argv[++i]);
+        } else if (std::string(argv[i]) == "--warm-start" && i + 1 < argc) {
+            warmStartFile = argv[++i];
+        } else if (std::string(argv[i]) == "--warm-start-weight" && i + 1 < argc) {
+            warmStartScale = std::stod(argv[++i]);
+        }
+    }
+    if (checkpointFile.empty()) {
+        checkpointFile = outputFilename + ".ckpt";
+    }
+    if (tablePartitions <= 0) {
+        tablePartitions = numaLayout == NUMA_LAYOUT_NONE ? 1 : 16 * NumaTopology::get().numNodes();
+    }
+    nodeMap.configure(tablePartitions, numaLayout);
+    if (ramBudgetMB > 0) {
+        if (coldStorePath.empty()) {
+            coldStorePath = outputFilename + ".cold";
+        }
+        if (!nodeMap.enableColdTier(coldStorePath, static_cast<uint64_t>(ramBudgetMB) << 20)) {
+            return 1;
+        }
+    }
+    if (!indexFile.empty()) {
+        if (ramBudgetMB > 0) {
+            std::cerr << "--infoset-index cannot be combined with --ram-budget" << std::endl;
+            return 1;
+        }
+        std::shared_ptr<InfosetIndex> index = std::make_shared<InfosetIndex>();
+        if (!index->load(indexFile)) {
+            return 1;
+        }
+        if (index->configHash() != computeConfigHash()) {
+            std::cerr << indexFile << " was built under a different abstraction/config" << std::endl;
+            return 1;
         }
+        nodeMap.useIndex(index);
+        std::cout << "Infoset index: " << index->size() << " infosets preallocated from " << indexFile << std::endl;
+    }
+    if (numaLayout == NUMA_LAYOUT_PARTITIONED) {
+        // Workers are spread over the nodes the partitions live on
+        pinWorkerThreads = true;
     }
     
     std::cout << "Starting training with " << iterations << " iterations." << std::endl;
     std::cout << "Results will be saved to: " << outputFilename << std::endl;
-    std::cout << "Mode: " << (useParallel ? "Parallel" : "Sequential") << std::endl;
+    if (tablePartitions > 1 || numaLayout != NUMA_LAYOUT_NONE) {
+        std::cout << "Infoset table: " << tablePartitions << " partitions, NUMA layout " << numaLayoutName(numaLayout)
+                  << " (" << NumaTopology::get().numNodes() << " nodes)" << std::endl;
+    }
+    if (ramBudgetMB > 0) {
+        std::cout << "Infoset RAM budget: " << ramBudgetMB << " MB, colder infosets evicted to " << coldStorePath << ".p*" << std::endl;
+    }
+    std::cout << "Mode: " << (useVector ? "Vector CFR" : (useParallel ? "Parallel" : "Sequential")) << std::endl;
+    
+    if (useVector) {
+        if (!warmStartFile.empty()) {
+            std::cerr << "Warning: --warm-start only applies to MCCFR; ignored with --vector" << std::endl;
+        }
+        trainVectorCFR(iterations, outputFilename);
+        return 0;
+    }
+    
+    if (!warmStartFile.empty() && !loadWarmStart(warmStartFile)) {
+        return 1;
+    }
+    
+    if (checkpointEvery > 0 || resume) {
+        std::cout << "Checkpoint file: " << checkpointFile;
+        if (checkpointEvery > 0) std::cout << " (every " << checkpointEvery << " iterations)";
+        std::cout << std::endl;
+    }
+    
+    // Exploitability is estimated with the workers paused, so it can use every core
+    ConvergenceMonitor monitor(evalPatience);
+    std::function<bool(int)> onEvaluate = nullptr;
+    if (evalEvery > 0) {
+        std::cout << "Exploitability evaluation every " << evalEvery << " iterations";
+        if (evalPatience > 0) std::cout << " (stop after " << evalPatience << " without improvement)";
+        std::cout << std::endl;
+        onEvaluate = [&](int iteration) {
+            std::cout << "\nExploitability at iteration " << iteration << ":" << std::endl;
+            StrategyProfile profile = profileFromNodeMap();
+            BestResponseEvaluator evaluator(profile, postflopBucket, evalConfig);
+            BestResponseResult result = evaluator.run();
+            printBestResponse(result);
+            if (monitor.record(result)) {
+                std::cout << "No improvement in " << evalPatience << " evaluations; stopping early." << std::endl;
+                return true;
+            }
+            return false;
+        };
+    }
+    
+    std::unique_ptr<MetricsReporter> metrics;
+    if (!metricsFile.empty()) {
+        std::cout << "Metrics: " << metricsFormat << " to " << metricsFile << " every " << metricsInterval << "s" << std::endl;
+        std::function<MetricsReporter::Gauges()> gauges = nullptr;
+        if (nodeMap.hasColdTier()) {
+            gauges = nodeTableGauges;
+        }
+        metrics.reset(new MetricsReporter(metricsFile, metricsFormat, metricsInterval, []() {
+            return nodeMap.stats().entries();
+        }, gauges));
+    }
+    
+    // Nodes must not move while the trie points at them, which the cold tier does
+    if (useTrie && !nodeMap.hasColdTier()) {
+        infosetTrie.enable(postflopBucket, roundBucketCounts());
+    }
     
     // Run the MCCFR training
-    if (useParallel) {
-        trainMCCFRParallel(game, iterations);
-    } else {
-        trainMCCFR(game, iterations);
+    if (!trainWithCheckpoints(game, iterations, useParallel, checkpointEvery, checkpointFile, resume,
+                              nullptr, evalEvery, onEvaluate)) {
+        std::cerr << "Could not resume from " << checkpointFile << std::endl;
+        return 1;
+    }
+    if (metrics) {
+        metrics->stop();
+    }
+    if (nodeMap.hasColdTier()) {
+        printNodeTableStats();
+    }
+    if (infosetTrie.enabled()) {
+        printInfosetTrieStats();
+    }
+    if (nodeMap.hasIndex()) {
+        printInfosetIndexStats();
+    }
+    if (warmStart.enabled()) {
+        warmStart.printSummary();
     }
     
     // Save the learned strategies to the specified CSV file
@@ -1233,6 +1940,7 @@ int main(int argc, char* argv[]) {
     
     return 0;
 }
+#endif // SPINGO_TRAINER_NO_MAIN
 
 void analyzeDuplicateInfoSets() {
     // Map to track potentially ambiguous infosets
@@ -1305,61 +2013,13 @@ void analyzeDuplicateInfoSets() {
     std::cout << "Total duplicate keys: " << totalDuplicates << std::endl;
 }
 
-// Add a thread pool for parallel training
-class ThreadPool {
-public:
-    ThreadPool(size_t numThreads) : stop(false) {
-        for (size_t i = 0; i < numThreads; ++i) {
-            workers.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(queueMutex);
-                        condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                        if (stop && tasks.empty()) return;
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                    }
-                    task();
-                }
-            });
-        }
-    }
-
-    template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            tasks.emplace(std::forward<F>(f));
-        }
-        condition.notify_one();
-    }
-
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers) {
-            worker.join();
-        }
-    }
-
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    bool stop;
-};
-
 // Parallel version of trainMCCFR
-void trainMCCFRParallel(SpinGoGame& game, int iterations) {
+std::vector<double> trainMCCFRParallel(SpinGoGame& game, int iterations, int checkpointEvery,
+                                       const std::function<void(int, const std::vector<double>&)>& onCheckpoint,
+                                       int firstIteration) {
     std::cout << "Training in parallel mode\n";
     
     std::vector<double> totalUtility(NUM_PLAYERS, 0.0);
-    std::vector<double> finalResults(NUM_PLAYERS, 0.0);
     
     auto start_time = std::chrono::steady_clock::now();
     
@@ -1370,83 +2030,75 @@ void trainMCCFRParallel(SpinGoGame& game, int iterations) {
     
     std::cout << "Using " << numThreads << " threads\n";
     
-    // Create the thread pool as a pointer so we can explicitly control its lifetime
-    std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>(numThreads);
+    // Iterations are handed out in small ranges by the work-stealing
+    // scheduler; the calling thread works too, so it gets one worker less
+    WorkStealingScheduler& scheduler = sharedScheduler(std::max(1u, numThreads) - 1, pinWorkerThreads);
     
     std::atomic<int> completedIterations(0);
     std::mutex resultsMutex;
-    
-    // Create batches of work
-    int batchSize = std::max(100, static_cast<int>(iterations / (numThreads * 10)));
-    int numBatches = (iterations + batchSize - 1) / batchSize;
-    
-    for (int batch = 0; batch < numBatches; ++batch) {
-        int startIter = batch * batchSize;
-        int endIter = std::min(startIter + batchSize, iterations);
-        int batchIterations = endIter - startIter;
-        
-        pool->enqueue([&game, &completedIterations, &resultsMutex, &totalUtility, 
-                      batchIterations, startIter, &start_time, iterations]() {
-            std::vector<double> batchUtility(NUM_PLAYERS, 0.0);
-            
-            for (int i = 0; i < batchIterations; ++i) {
-                for (int p = 0; p < NUM_PLAYERS; p++) {
-                    SpinGoState state = game.new_initial_state();
-                    std::vector<double> reachProb(NUM_PLAYERS, 1.0);
-                    
-                    double value = mccfr(&state, p, reachProb);
-                    batchUtility[p] += value;
-                }
+    IterationGate gate;
+    
+    long grain = std::max(1, std::min(64, iterations / (static_cast<int>(numThreads) * 16)));
+    scheduler.parallelFor(0, iterations, grain, [&](long begin, long end) {
+        for (long i = begin; i < end; ++i) {
+            gate.enter();
+            seedSamplerRng();
+            std::vector<double> iterationUtility(NUM_PLAYERS, 0.0);
+            for (int p = 0; p < NUM_PLAYERS; p++) {
+                SpinGoState state = game.new_initial_state();
+                state.defer_allin_runout = true;
+                std::vector<double> reachProb(NUM_PLAYERS, 1.0);
                 
-                // Update progress counter
-                int completed = ++completedIterations;
-                if (completed % 100 == 0) {
-                    double percentage = (static_cast<double>(completed) / iterations) * 100;
-                    
-                    auto current_time = std::chrono::steady_clock::now();
-                    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time);
-                    double seconds_per_iter = elapsed.count() / static_cast<double>(completed);
-                    int remaining_seconds = static_cast<int>(seconds_per_iter * (iterations - completed));
-                    
-                    int hours = remaining_seconds / 3600;
-                    int minutes = (remaining_seconds % 3600) / 60;
-                    int seconds = remaining_seconds % 60;
-                    
-                    std::cout << "\rIteration " << completed << " (" << std::fixed << std::setprecision(4) 
-                              << percentage << "% completed, ETA: " << hours << "h " 
-                              << minutes << "m " << seconds << "s)" << std::flush;
-                }
+                iterationUtility[p] = mccfr(&state, p, reachProb, infosetTrie.root());
             }
+            metricAdd(METRIC_ITERATIONS);
             
-            // Update global results with batch results
+            // Add to the global results per iteration so a checkpoint sees
+            // utility totals that match its iteration count
+            int completed;
+            bool checkpointDue;
             {
                 std::lock_guard<std::mutex> lock(resultsMutex);
                 for (int p = 0; p < NUM_PLAYERS; p++) {
-                    totalUtility[p] += batchUtility[p];
+                    totalUtility[p] += iterationUtility[p];
                 }
+                completed = ++completedIterations;
+                checkpointDue = checkpointEvery > 0 && onCheckpoint && (firstIteration + completed) % checkpointEvery == 0;
             }
-        });
-    }
-    
-    // Wait for all threads to complete by explicitly destroying the pool
-    // This ensures all tasks are completed before we continue
-    pool.reset();
-    
-    std::cout << "\nTraining completed. Calculating final results..." << std::endl;
+            gate.leave();
+            if (checkpointDue) {
+                // Iterations already running have written part of their
+                // updates; let them finish so the checkpoint counts them
+                gate.pause();
+                {
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    int settled = completedIterations;
+                    if (settled < iterations) {
+                        onCheckpoint(settled, totalUtility);
+                    }
+                }
+                gate.resume();
+            }
+            if (completed % 100 == 0) {
+                double percentage = (static_cast<double>(completed) / iterations) * 100;
+                
+                auto current_time = std::chrono::steady_clock::now();
+                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - start_time);
+                double seconds_per_iter = elapsed.count() / static_cast<double>(completed);
+                int remaining_seconds = static_cast<int>(seconds_per_iter * (iterations - completed));
+                
+                int hours = remaining_seconds / 3600;
+                int minutes = (remaining_seconds % 3600) / 60;
+                int seconds = remaining_seconds % 60;
+                
+                std::cout << "\rIteration " << completed << " (" << std::fixed << std::setprecision(4) 
+                          << percentage << "% completed, ETA: " << hours << "h " 
+                          << minutes << "m " << seconds << "s)" << std::flush;
+            }
+        }
+    });
     
-    // Calculate final results
-    for (int p = 0; p < NUM_PLAYERS; p++) {
-        finalResults[p] = totalUtility[p] / iterations;
-    }
+    std::cout << "\nTraining completed." << std::endl;
     
-    // Save final results
-    std::ofstream resultFile("final_results.txt");
-    if (resultFile.is_open()) {
-        for (int p = 0; p < NUM_PLAYERS; p++) {
-            resultFile << "Player " << p << " final average utility: " << finalResults[p] << "\n";
-        }
-        resultFile.close();
-    } else {
-        std::cerr << "Unable to open file to save results.\n";
-    }
+    return totalUtility;
 }
\ No newline at end of file
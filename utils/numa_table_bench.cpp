@@ -0,0 +1,179 @@
+#include "../spingo/node_table.cpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+// Compares infoset table layouts (spingo/node_table.cpp) under a synthetic
+// MCCFR-like load: every operation locks the partition of a random key,
+// copies the node out, updates its regrets and strategy sums and writes them
+// back, as mccfr() does in the trainers.
+//
+// Layouts measured, each after populating the table with every key:
+//   single lock      1 partition on the plain heap (the original nodeMap)
+//   none             N partitions on the plain heap
+//   interleave       N partitions, pages interleaved over all NUMA nodes
+//   partitioned      N partitions, partition p on node p % nodes
+//   partitioned-local  as partitioned, but each thread only draws keys whose
+//                    partition lives on its own node (the upper bound for
+//                    node affinity; MCCFR itself cannot route work this way)
+//
+// Threads are pinned round-robin over the nodes. On a single-node machine
+// all layouts place memory identically, so only the locking differences show.
+
+struct BenchNode {
+    NodeVector<double> regretSum;
+    NodeVector<double> strategy;
+    NodeVector<double> strategySum;
+    NodeVector<uint8_t> actions;
+    int strategyUpdateCount;
+    BenchNode(int numActions = 3)
+        : regretSum(numActions, 0.0), strategy(numActions, 0.0), strategySum(numActions, 0.0),
+          actions(numActions, 0), strategyUpdateCount(0) {}
+};
+
+struct BenchResult {
+    double opsPerSecond;
+    size_t mappedBytes;
+};
+
+BenchResult runLayout(const vector<string>& keys, int numThreads, double seconds, int partitions,
+                      NumaLayout layout, bool nodeLocal) {
+    PartitionedNodeTable<BenchNode> table(partitions, layout);
+    const NumaTopology& topology = NumaTopology::get();
+
+    // Keys each node's threads draw from in the node-local run
+    vector<vector<uint32_t>> keysByNode(topology.numNodes());
+    for (uint32_t k = 0; k < keys.size(); k++) {
+        keysByNode[table.nodeOf(table.partitionIndex(keys[k]))].push_back(k);
+    }
+
+    // Populate from pinned threads so first-touch placement is spread too
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            pinThreadToCpu(topology.cpuForThread(t));
+            for (size_t k = t; k < keys.size(); k += numThreads) {
+                auto& partition = table.partitionFor(keys[k]);
+                lock_guard<mutex> lock(partition.mutex);
+                partition.store(keys[k], BenchNode(2 + k % 4));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    threads.clear();
+
+    atomic<bool> running(true);
+    atomic<uint64_t> totalOps(0);
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            int node = 0;
+            pinThreadToCpu(topology.cpuForThread(t, &node));
+            const vector<uint32_t>* local = nodeLocal ? &keysByNode[node % keysByNode.size()] : nullptr;
+            if (local && local->empty()) return;
+            mt19937_64 rng(12345 + t);
+            uint64_t ops = 0;
+            BenchNode localNode;
+            while (running.load(memory_order_relaxed)) {
+                for (int batch = 0; batch < 256; batch++) {
+                    const string& key = local ? keys[(*local)[rng() % local->size()]] : keys[rng() % keys.size()];
+                    auto& partition = table.partitionFor(key);
+                    {
+                        lock_guard<mutex> lock(partition.mutex);
+                        localNode = *partition.find(key);
+                    }
+                    for (size_t a = 0; a < localNode.regretSum.size(); a++) {
+                        localNode.regretSum[a] += static_cast<double>(rng() & 0xff) - 127.5;
+                        localNode.strategySum[a] += 0.25;
+                    }
+                    {
+                        lock_guard<mutex> lock(partition.mutex);
+                        BenchNode& globalNode = partition.get(key);
+                        for (size_t a = 0; a < globalNode.regretSum.size(); a++) {
+                            globalNode.regretSum[a] = localNode.regretSum[a];
+                            globalNode.strategySum[a] = localNode.strategySum[a];
+                        }
+                        globalNode.strategyUpdateCount++;
+                    }
+                    ops++;
+                }
+            }
+            totalOps += ops;
+        });
+    }
+    auto start = chrono::steady_clock::now();
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    running = false;
+    for (auto& th : threads) th.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t mapped = 0;
+    for (int p = 0; p < table.numPartitions(); p++) {
+        if (table.partition(p).arena) mapped += table.partition(p).arena->mappedBytes();
+    }
+    return {totalOps / elapsed, mapped};
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--help") {
+        cerr << "Usage: " << argv[0] << " [num_threads] [num_keys] [seconds_per_layout] [partitions]" << endl;
+        return 1;
+    }
+
+    const NumaTopology& topology = NumaTopology::get();
+    int numThreads = max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+        numThreads = stoi(argv[1]);
+    size_t numKeys = 2000000;
+    if (argc > 2)
+        numKeys = stoul(argv[2]);
+    double seconds = 5.0;
+    if (argc > 3)
+        seconds = stod(argv[3]);
+    int partitions = 16 * topology.numNodes();
+    if (argc > 4)
+        partitions = stoi(argv[4]);
+
+    cout << "NUMA nodes: " << topology.numNodes() << "\nThreads: " << numThreads << "\nKeys: " << numKeys
+         << "\nPartitions: " << partitions << "\nSeconds per layout: " << seconds << endl;
+
+    // Infoset-like keys, long enough to live on the heap as they do in training
+    vector<string> keys(numKeys);
+    for (size_t k = 0; k < numKeys; k++) {
+        keys[k] = "P" + to_string(k % 3) + ":Round:flop FlopCluster:" + to_string(k % 97) + " Actions:" + to_string(k)
+                + " Pot:" + to_string(k % 41);
+    }
+
+    struct Run {
+        const char* name;
+        int partitions;
+        NumaLayout layout;
+        bool nodeLocal;
+    };
+    vector<Run> runs = {
+        {"single lock", 1, NUMA_LAYOUT_NONE, false},
+        {"none", partitions, NUMA_LAYOUT_NONE, false},
+        {"interleave", partitions, NUMA_LAYOUT_INTERLEAVE, false},
+        {"partitioned", partitions, NUMA_LAYOUT_PARTITIONED, false},
+        {"partitioned-local", partitions, NUMA_LAYOUT_PARTITIONED, true},
+    };
+
+    double baseline = 0.0;
+    cout << "\n" << left << setw(20) << "layout" << right << setw(14) << "Mops/s" << setw(12) << "relative"
+         << setw(14) << "arena MB" << endl;
+    for (const Run& run : runs) {
+        BenchResult result = runLayout(keys, numThreads, seconds, run.partitions, run.layout, run.nodeLocal);
+        if (baseline == 0.0)
+            baseline = result.opsPerSecond;
+        cout << left << setw(20) << run.name << right << fixed << setprecision(3) << setw(14)
+             << result.opsPerSecond / 1e6 << setw(12) << result.opsPerSecond / baseline << setw(14)
+             << result.mappedBytes / (1024.0 * 1024.0) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include "../spingo/fast_eval.cpp"
+#include "../spingo/preflop_equity_file.cpp"
+#include "../spingo/scheduler.cpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+// Generates the preflop all-in equity table read by spingo/allin_equity.cpp.
+//
+// Every 2-way and 3-way matchup of specific hole cards is stored once per suit
+// isomorphism class (see spingo/preflop_equity_file.cpp). 2-way entries are
+// exact: all C(48,5) boards are enumerated. Exact 3-way enumeration (C(46,5)
+// boards for ~13M canonical triples) is out of reach, so 3-way entries use a
+// seeded Monte Carlo unless three_way_samples is 0.
+//
+// Work is split into units of one (section, first combo). Finished units are
+// appended to <output_file>.partial, so an interrupted run resumes where it
+// stopped; the table is rewritten from all finished units at the end of a run.
+
+struct PartialRecord {
+    uint32_t section;  // 2 or 3; UNIT_DONE_FLAG | section marks a finished unit
+    uint32_t key;      // matchup key, or the unit's first combo for markers
+    float shares[3];
+};
+
+static const uint32_t UNIT_DONE_FLAG = 0x100;
+
+int comboCards[PREFLOP_COMBOS][2];
+
+void initComboCards() {
+    for (int c1 = 0; c1 < 52; c1++) {
+        for (int c2 = c1 + 1; c2 < 52; c2++) {
+            int h = comboIndex(c1, c2);
+            comboCards[h][0] = c1;
+            comboCards[h][1] = c2;
+        }
+    }
+}
+
+// Exact pot shares over every board that avoids the hole cards.
+void exactShares(const int* hole, int numPlayers, double* shares) {
+    uint64_t used = 0;
+    for (int i = 0; i < numPlayers * 2; i++) used |= 1ULL << hole[i];
+    vector<int> deck;
+    for (int c = 0; c < 52; c++) {
+        if (!(used & (1ULL << c))) deck.push_back(c);
+    }
+
+    int n = deck.size();
+    double totals[3] = {0.0, 0.0, 0.0};
+    long long boards = 0;
+    int board[5];
+    int scores[3];
+    for (int a = 0; a < n; a++) {
+        board[0] = deck[a];
+        for (int b = a + 1; b < n; b++) {
+            board[1] = deck[b];
+            for (int c = b + 1; c < n; c++) {
+                board[2] = deck[c];
+                for (int d = c + 1; d < n; d++) {
+                    board[3] = deck[d];
+                    for (int e = d + 1; e < n; e++) {
+                        board[4] = deck[e];
+                        int best = 0;
+                        for (int p = 0; p < numPlayers; p++) {
+                            scores[p] = fastHandScore(hole[p * 2], hole[p * 2 + 1], board, 5);
+                            best = max(best, scores[p]);
+                        }
+                        int winners = 0;
+                        for (int p = 0; p < numPlayers; p++) winners += scores[p] == best;
+                        for (int p = 0; p < numPlayers; p++) {
+                            if (scores[p] == best) totals[p] += 1.0 / winners;
+                        }
+                        boards++;
+                    }
+                }
+            }
+        }
+    }
+    for (int p = 0; p < numPlayers; p++) shares[p] = totals[p] / boards;
+}
+
+// Monte Carlo pot shares, seeded by the matchup key so reruns agree.
+void sampledShares(const int* hole, int numPlayers, int samples, uint32_t seed, double* shares) {
+    uint64_t used = 0;
+    for (int i = 0; i < numPlayers * 2; i++) used |= 1ULL << hole[i];
+    vector<int> deck;
+    for (int c = 0; c < 52; c++) {
+        if (!(used & (1ULL << c))) deck.push_back(c);
+    }
+
+    mt19937 rng(seed);
+    double totals[3] = {0.0, 0.0, 0.0};
+    int board[5];
+    int scores[3];
+    for (int s = 0; s < samples; s++) {
+        // Partial Fisher-Yates for the five board cards
+        for (int i = 0; i < 5; i++) {
+            int j = uniform_int_distribution<int>(i, deck.size() - 1)(rng);
+            swap(deck[i], deck[j]);
+            board[i] = deck[i];
+        }
+        int best = 0;
+        for (int p = 0; p < numPlayers; p++) {
+            scores[p] = fastHandScore(hole[p * 2], hole[p * 2 + 1], board, 5);
+            best = max(best, scores[p]);
+        }
+        int winners = 0;
+        for (int p = 0; p < numPlayers; p++) winners += scores[p] == best;
+        for (int p = 0; p < numPlayers; p++) {
+            if (scores[p] == best) totals[p] += 1.0 / winners;
+        }
+    }
+    for (int p = 0; p < numPlayers; p++) shares[p] = totals[p] / samples;
+}
+
+bool overlaps(int h1, int h2) {
+    return comboCards[h1][0] == comboCards[h2][0] || comboCards[h1][0] == comboCards[h2][1] ||
+           comboCards[h1][1] == comboCards[h2][0] || comboCards[h1][1] == comboCards[h2][1];
+}
+
+// All canonical matchups whose smallest combo is `first`, with their shares.
+void processUnit(int section, int first, int threeWaySamples, vector<PartialRecord>& out) {
+    int hole[6];
+    hole[0] = comboCards[first][0];
+    hole[1] = comboCards[first][1];
+    for (int second = first + 1; second < PREFLOP_COMBOS; second++) {
+        if (overlaps(first, second)) continue;
+        hole[2] = comboCards[second][0];
+        hole[3] = comboCards[second][1];
+
+        if (section == 2) {
+            uint32_t key = first * PREFLOP_COMBOS + second;
+            if (canonicalMatchupKey(hole, 2, nullptr) != key) continue;
+            double shares[3] = {0.0, 0.0, 0.0};
+            exactShares(hole, 2, shares);
+            out.push_back({2, key, {static_cast<float>(shares[0]), static_cast<float>(shares[1]), 0.0f}});
+            continue;
+        }
+
+        for (int third = second + 1; third < PREFLOP_COMBOS; third++) {
+            if (overlaps(first, third) || overlaps(second, third)) continue;
+            hole[4] = comboCards[third][0];
+            hole[5] = comboCards[third][1];
+            uint32_t key = (static_cast<uint32_t>(first) * PREFLOP_COMBOS + second) * PREFLOP_COMBOS + third;
+            if (canonicalMatchupKey(hole, 3, nullptr) != key) continue;
+            double shares[3] = {0.0, 0.0, 0.0};
+            if (threeWaySamples > 0) {
+                sampledShares(hole, 3, threeWaySamples, key, shares);
+            } else {
+                exactShares(hole, 3, shares);
+            }
+            out.push_back({3, key, {static_cast<float>(shares[0]), static_cast<float>(shares[1]), static_cast<float>(shares[2])}});
+        }
+    }
+}
+
+bool writeTable(const string& outputFile, vector<PartialRecord>& records, int threeWaySamples) {
+    sort(records.begin(), records.end(), [](const PartialRecord& a, const PartialRecord& b) {
+        return a.section != b.section ? a.section < b.section : a.key < b.key;
+    });
+    records.erase(unique(records.begin(), records.end(), [](const PartialRecord& a, const PartialRecord& b) {
+        return a.section == b.section && a.key == b.key;
+    }), records.end());
+
+    vector<PreflopEquityRecord2> records2;
+    vector<PreflopEquityRecord3> records3;
+    for (const auto& r : records) {
+        if (r.section == 2) {
+            records2.push_back({r.key, r.shares[0]});
+        } else if (r.section == 3) {
+            records3.push_back({r.key, {r.shares[0], r.shares[1], r.shares[2]}});
+        }
+    }
+
+    PreflopEquityHeader header;
+    memcpy(header.magic, PREFLOP_EQUITY_MAGIC, 8);
+    header.version = PREFLOP_EQUITY_VERSION;
+    header.threeWaySamples = threeWaySamples;
+    header.count2 = records2.size();
+    header.count3 = records3.size();
+
+    ofstream out(outputFile, ios::binary);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records2.data()), records2.size() * sizeof(PreflopEquityRecord2));
+    out.write(reinterpret_cast<const char*>(records3.data()), records3.size() * sizeof(PreflopEquityRecord3));
+    cout << "Wrote " << records2.size() << " 2-way and " << records3.size() << " 3-way matchups to " << outputFile << endl;
+    return out.good();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <output_file> [num_threads] [three_way_samples] [sections]" << endl;
+        cerr << "  three_way_samples: Monte Carlo boards per 3-way matchup, 0 for exact (default 20000)" << endl;
+        cerr << "  sections: 2, 3 or 23 (default 23)" << endl;
+        return 1;
+    }
+
+    string outputFile = argv[1];
+    int numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 4;
+    if (argc > 2)
+        numThreads = stoi(argv[2]);
+    int threeWaySamples = 20000;
+    if (argc > 3)
+        threeWaySamples = stoi(argv[3]);
+    string sections = "23";
+    if (argc > 4)
+        sections = argv[4];
+
+    cout << "Output file: " << outputFile << "\nThreads: " << numThreads
+         << "\n3-way samples: " << (threeWaySamples > 0 ? to_string(threeWaySamples) : "exact")
+         << "\nSections: " << sections << endl;
+
+    initComboCards();
+
+    // Resume from the partial file, dropping a torn trailing record
+    string partialFile = outputFile + ".partial";
+    vector<PartialRecord> records;
+    set<pair<int, int>> doneUnits;
+    {
+        ifstream in(partialFile, ios::binary);
+        PartialRecord r;
+        while (in.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+            if (r.section & UNIT_DONE_FLAG) {
+                doneUnits.insert({static_cast<int>(r.section & ~UNIT_DONE_FLAG), static_cast<int>(r.key)});
+            } else {
+                records.push_back(r);
+            }
+        }
+    }
+    if (!records.empty() || !doneUnits.empty()) {
+        // Keep only the records of units that were completed
+        records.erase(remove_if(records.begin(), records.end(), [&](const PartialRecord& r) {
+            int first = r.section == 2 ? r.key / PREFLOP_COMBOS : r.key / (PREFLOP_COMBOS * PREFLOP_COMBOS);
+            return !doneUnits.count({static_cast<int>(r.section), first});
+        }), records.end());
+        cout << "Resuming: " << doneUnits.size() << " units already done" << endl;
+    }
+    // Rewrite the partial file so it holds exactly the kept state
+    {
+        ofstream rewrite(partialFile, ios::binary | ios::trunc);
+        for (const auto& r : records)
+            rewrite.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        for (const auto& u : doneUnits) {
+            PartialRecord marker = {UNIT_DONE_FLAG | static_cast<uint32_t>(u.first), static_cast<uint32_t>(u.second), {0.0f, 0.0f, 0.0f}};
+            rewrite.write(reinterpret_cast<const char*>(&marker), sizeof(marker));
+        }
+    }
+
+    // 3-way units are listed first so the long ones start early
+    vector<pair<int, int>> units;
+    for (int section = 3; section >= 2; section--) {
+        if (sections.find(char('0' + section)) == string::npos)
+            continue;
+        for (int first = 0; first < PREFLOP_COMBOS; first++) {
+            if (!doneUnits.count({section, first}))
+                units.push_back({section, first});
+        }
+    }
+
+    ofstream partial(partialFile, ios::binary | ios::app);
+    if (!partial) {
+        cerr << "Error: cannot open " << partialFile << endl;
+        return 1;
+    }
+
+    atomic<size_t> finishedUnits(0);
+    mutex writeMutex;
+    auto startTime = chrono::steady_clock::now();
+
+    // One unit per task; the main thread is one of the numThreads workers
+    WorkStealingScheduler scheduler(numThreads - 1);
+    scheduler.parallelFor(0, units.size(), 1, [&](long begin, long end) {
+        vector<PartialRecord> buffer;
+        for (long u = begin; u < end; u++) {
+            buffer.clear();
+            processUnit(units[u].first, units[u].second, threeWaySamples, buffer);
+
+            lock_guard<mutex> lock(writeMutex);
+            partial.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PartialRecord));
+            PartialRecord marker = {UNIT_DONE_FLAG | static_cast<uint32_t>(units[u].first), static_cast<uint32_t>(units[u].second), {0.0f, 0.0f, 0.0f}};
+            partial.write(reinterpret_cast<const char*>(&marker), sizeof(marker));
+            partial.flush();
+            records.insert(records.end(), buffer.begin(), buffer.end());
+
+            size_t done = ++finishedUnits;
+            auto elapsedSeconds = chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - startTime).count();
+            int remaining = elapsedSeconds > 0 ? static_cast<int>(elapsedSeconds * (units.size() - done) / done) : 0;
+            cout << "\rUnits " << done << "/" << units.size()
+                 << " (" << fixed << setprecision(1) << (done * 100.0 / units.size()) << "%) - "
+                 << "ETA: " << remaining / 3600 << "h " << (remaining % 3600) / 60 << "m " << remaining % 60 << "s    " << flush;
+        }
+    });
+    partial.close();
+    cout << endl;
+
+    if (!writeTable(outputFile, records, threeWaySamples)) {
+        cerr << "Error: cannot write " << outputFile << endl;
+        return 1;
+    }
+    // The partial file is kept so another section can be added later
+    cout << "Resume state kept in " << partialFile << " (safe to delete)" << endl;
+    return 0;
+}